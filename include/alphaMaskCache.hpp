@@ -0,0 +1,133 @@
+#pragma once
+
+extern "C" {
+#include <SDL2/SDL.h>
+}
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace lui {
+	/**
+	 *	\brief A process-wide cache of 1-bit alpha masks of textures, for pixel-accurate hit testing
+	 *
+	 *	Buttons and items normally take hover and clicks anywhere in their rectangle. Once a
+	 *	mask is added for their texture, they only take them over its solid pixels, so round or
+	 *	irregular buttons let clicks through their transparent corners to whatever is beneath.
+	 *	One mask serves every element using the texture, whatever part of it (srcrect) they
+	 *	draw, and is sampled after undoing the element's angle and flip.
+	 *
+	 *	Masks are packed into 64-bit words, so a sample is one load and a shift. Once the masks
+	 *	exceed the byte budget, those sampled least recently are dropped, and their textures
+	 *	are hit tested by rectangle again until added again.
+	 *
+	 *	\code
+	 *	SDL_Surface *surface = IMG_Load("round.png");
+	 *	SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
+	 *	lui::alphaMaskCache::global().add(texture, surface);
+	 *	SDL_FreeSurface(surface);
+	 *	\endcode
+	 *
+	 *	\note Destroy textures with masks through renderBackend::destroyTexture(), or remove()
+	 *	their mask first, so a texture made later at the same address does not inherit it.
+	 */
+	class alphaMaskCache {
+	public:
+		/**
+		 *	\brief Which pixels of a texture are solid, one bit each
+		 */
+		struct mask {
+			int w = 0, h = 0;
+			int wordsPerRow = 0;
+			std::vector<Uint64> bits; //Row by row; bit x % 64 of word x / 64 is set where pixel x is solid
+
+			/**
+			 *	\brief Is a pixel solid
+			 *
+			 *	\return true if the pixel is inside of the mask and solid
+			 */
+			bool test(int x, int y) const {
+				if (x < 0 || y < 0 || x >= w || y >= h) {
+					return false;
+				}
+				return (bits[(size_t)y * wordsPerRow + (x >> 6)] >> (x & 63)) & 1;
+			}
+		};
+	private:
+		struct entry {
+			SDL_Texture *texture;
+			mask bits;
+			size_t bytes;
+		};
+
+		std::mutex m_mutex; //Mutex for everything below
+			std::list<entry> m_entries; //Front is the most recently sampled
+			std::unordered_map<SDL_Texture*, std::list<entry>::iterator> m_index;
+			size_t m_byteBudget = 8 * 1024 * 1024;
+			size_t m_bytesUsed = 0;
+
+		void m_erase(std::list<entry>::iterator it);
+		void m_trim(); //Drop least recently sampled masks until within budget
+	public:
+		alphaMaskCache();
+		alphaMaskCache(const alphaMaskCache&) = delete;
+		alphaMaskCache& operator=(const alphaMaskCache&) = delete;
+
+		/**
+		 *	\brief Get the cache shared by the whole process
+		 */
+		static alphaMaskCache& global();
+
+		/**
+		 *	\brief Build the mask of a texture from the surface it was made from
+		 *
+		 *	\param *texture The texture, used only as the key.
+		 *	\param *surface Pixels of the texture, in any format; not kept.
+		 *	\param threshold Lowest alpha of a solid pixel.
+		 *
+		 *	\returns 0 on success, or -1 if the surface could not be read or the mask is larger than the whole budget
+		 */
+		int add(SDL_Texture *texture, SDL_Surface *surface, Uint8 threshold = 128);
+		/**
+		 *	\brief Forget the mask of a texture
+		 *
+		 *	\param *texture The texture, which may have no mask.
+		 */
+		void remove(SDL_Texture *texture);
+		/**
+		 *	\brief Does a texture have a mask
+		 */
+		bool has(SDL_Texture *texture);
+		/**
+		 *	\brief Is a point of a texture solid
+		 *
+		 *	\param *texture The texture.
+		 *	\param *srcrect Part of the texture drawn, or nullptr for all of it.
+		 *	\param u Horizontal position across srcrect, from 0 at its left edge to 1 at its right edge.
+		 *	\param v Vertical position across srcrect, from 0 at its top edge to 1 at its bottom edge.
+		 *
+		 *	\returns 1 if solid, 0 if not, or -1 if the texture has no mask
+		 */
+		int sample(SDL_Texture *texture, const SDL_Rect *srcrect, float u, float v);
+		/**
+		 *	\brief Forget every mask
+		 */
+		void clear();
+
+		/**
+		 *	\brief Set the maximum number of bytes the masks may take
+		 *
+		 *	\param bytes The budget, in bytes. Masks are dropped immediately if over it.
+		 */
+		void setByteBudget(size_t bytes);
+		/**
+		 *	\brief Get the maximum number of bytes the masks may take
+		 */
+		size_t getByteBudget();
+		/**
+		 *	\brief Get the number of bytes the masks take
+		 */
+		size_t getBytesUsed();
+	};
+};
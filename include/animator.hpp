@@ -0,0 +1,198 @@
+#pragma once
+
+#include "./element.hpp"
+
+extern "C" {
+#include <SDL2/SDL.h>
+}
+#include <vector>
+#include <utility> //std::pair
+#include <algorithm>
+#include <cmath>
+
+namespace lui {
+	class set;
+
+	/**
+	 *	\brief Tweens and keyframe animations of the elements in a set
+	 *
+	 *	Every set has one, from set::getAnimator(), which is stepped by the set's loopLogic().
+	 *	Tracks are kept in parallel arrays, so a step advances time, eases, and interpolates every
+	 *	track in flat loops, then applies the results to each element with as few setter calls as
+	 *	possible. The set holds an update (see set::beginUpdate()) while they are applied, so
+	 *	invalidation and focus checks happen once per frame however many tracks are running.
+	 *
+	 *	Finished and stopped tracks leave their slot free for the next one, so running animations
+	 *	does not allocate once the arrays have grown to the most tracks running at once.
+	 *
+	 *	\code
+	 *	set.getAnimator().tween(&btn, lui::animator::X, 300.f, 250, lui::animator::CubicOut);
+	 *	set.getAnimator().tween(&btn, lui::animator::Alpha, 0.f, 250, lui::animator::Linear, 250);
+	 *	\endcode
+	 *
+	 *	\note Only the set and its children can be animated. Tracks on an element are stopped
+	 *	when it is removed from the set.
+	 */
+	class animator {
+	public:
+		/*!
+		 *	\brief What a track animates
+		 */
+		enum Property {
+			X,			//!<dstrect x
+			Y,			//!<dstrect y
+			Width,		//!<dstrect w
+			Height,		//!<dstrect h
+			Angle,		//!<Angle in degrees
+			Red,		//!<Red color modulation, 0 to 255 (element::setColorMod())
+			Green,		//!<Green color modulation, 0 to 255
+			Blue,		//!<Blue color modulation, 0 to 255
+			Alpha,		//!<Alpha modulation, 0 to 255 (element::setAlphaMod())
+			CornerX,	//!<Render corner x, for sets only (set::setRenderCorner())
+			CornerY		//!<Render corner y, for sets only
+		};
+		/*!
+		 *	\brief How a track moves between its start and end
+		 */
+		enum Easing {
+			Linear,
+			QuadIn,
+			QuadOut,
+			QuadInOut,
+			CubicIn,
+			CubicOut,
+			CubicInOut,
+			SineInOut,
+			BackOut		//!<Overshoots the end a little before settling
+		};
+		/**
+		 *	\brief A value a keyframe animation passes through
+		 */
+		struct keyframe {
+			Uint32 time; //!<Milliseconds since the animation started
+			float value; //!<Value at that time
+			Easing easing; //!<Easing from the previous keyframe to this one
+		};
+	private:
+		set *m_owner = nullptr;
+
+		//One entry per slot; m_targets[i] is nullptr for free slots
+		std::vector<element*> m_targets;
+		std::vector<Uint8> m_properties;
+		std::vector<Uint8> m_easings;
+		std::vector<Uint8> m_waiting; //Chained after another track, which hasn't finished yet
+		std::vector<Uint8> m_fromCurrent; //Start from the property's value when the delay is over
+		std::vector<float> m_from;
+		std::vector<float> m_to;
+		std::vector<float> m_elapsed; //Milliseconds since the track started, negative while delayed
+		std::vector<float> m_inverseDuration;
+		std::vector<float> m_progress; //Scratch, eased progress of the current step
+		std::vector<float> m_values; //Scratch, values of the current step
+		std::vector<Uint32> m_next; //Track started when this one finishes, or m_none
+		std::vector<Uint32> m_previous; //Track this one is waiting on, or m_none
+		std::vector<Uint32> m_serials; //Bumped when a slot is reused, so stale handles are ignored
+		std::vector<Uint32> m_free; //Free slots
+		std::vector<std::pair<Uint32, float>> m_starting; //Scratch, chained tracks started by the current step and how far past their start it ended
+		size_t m_running = 0;
+		size_t m_delayedStarts = 0; //Running tracks still to read their starting value
+
+		static const Uint32 m_none = 0xFFFFFFFF;
+
+		Uint32 m_allocate(element *target, Property p, float from, float to, Uint32 duration, Easing easing);
+		void m_release(Uint32 slot);
+		float m_current(element *target, Property p);
+		static Uint8 m_toByte(float value) {
+			return (Uint8)std::lround(std::min(std::max(value, 0.f), 255.f));
+		}
+		void m_apply(size_t first, size_t last); //Write the values of slots [first, last) to their targets
+	public:
+		/**
+		 *	\brief Construct an animator for a set
+		 *
+		 *	\param *owner The set whose children are animated.
+		 *
+		 *	\note Use set::getAnimator() rather than constructing one.
+		 */
+		animator(set *owner);
+		~animator();
+
+		/**
+		 *	\brief Animate a property from its current value
+		 *
+		 *	\param *target The set or one of its children.
+		 *	\param p The property.
+		 *	\param to Value to end at.
+		 *	\param duration Milliseconds to take.
+		 *	\param easing How to get there.
+		 *	\param delay Milliseconds to wait before starting; the starting value is read then.
+		 *
+		 *	\returns Handle of the track, or 0 if the target or property can't be animated
+		 *
+		 *	\note Tracks on the same property don't replace each other; stop() the old one first.
+		 */
+		Uint64 tween(element *target, Property p, float to, Uint32 duration, Easing easing = Linear, Uint32 delay = 0);
+		/**
+		 *	\brief Animate a property through a series of values
+		 *
+		 *	The property jumps to the first keyframe's value when the animation starts, and each
+		 *	later keyframe is eased into from the one before it.
+		 *
+		 *	\param *target The set or one of its children.
+		 *	\param p The property.
+		 *	\param &keyframes Keyframes in order of time.
+		 *	\param delay Milliseconds to wait before starting.
+		 *
+		 *	\returns Handle of the animation, or 0 if there are no keyframes or the target or property can't be animated
+		 */
+		Uint64 animate(element *target, Property p, const std::vector<keyframe> &keyframes, Uint32 delay = 0);
+		/**
+		 *	\brief Stop an animation where it is
+		 *
+		 *	\param track Handle returned by tween() or animate().
+		 *
+		 *	\returns true if it was still running
+		 */
+		bool stop(Uint64 track);
+		/**
+		 *	\brief Stop every animation of an element
+		 *
+		 *	\returns Number of animations stopped
+		 */
+		size_t stop(element *target);
+		/**
+		 *	\brief Stop every animation of one property of an element
+		 *
+		 *	\returns Number of animations stopped
+		 */
+		size_t stop(element *target, Property p);
+		/**
+		 *	\brief Is an animation still running
+		 *
+		 *	\param track Handle returned by tween() or animate().
+		 */
+		bool isRunning(Uint64 track);
+		/**
+		 *	\brief Get the number of tracks running, or waiting on another to finish
+		 */
+		size_t size();
+
+		/**
+		 *	\brief Advance every track
+		 *
+		 *	\param ms Milliseconds since the last step.
+		 *
+		 *	\note Called by the set's loopLogic().
+		 */
+		void step(Uint32 ms);
+
+		/**
+		 *	\brief Apply an easing curve
+		 *
+		 *	\param easing The curve.
+		 *	\param t Progress from 0 to 1.
+		 *
+		 *	\returns Eased progress, 0 at t = 0 and 1 at t = 1
+		 */
+		static float ease(Easing easing, float t);
+	};
+};
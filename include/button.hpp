@@ -38,6 +38,7 @@ namespace lui {
 		~button();
 
 		void render(SDL_Renderer *renderer);
+		bool record(displayList &list);
 		void userLogic(std::vector<SDL_Event> &events, SDL_Renderer *renderer);
 		using element::resetUserLogic;
 		using element::loopLogic;
@@ -62,7 +63,18 @@ namespace lui {
 		 *	\returns The texture of the button
 		 */
 		SDL_Texture* getTexture();
+		/**
+		 *	\brief Does the button hide everything under it
+		 *
+		 *	\return true if set opaque, or if all of its texture is drawn without blending (SDL_BLENDMODE_NONE)
+		 */
+		bool isOpaque();
 
-		using element::pointInElement;
+		/**
+		 *	\brief Is a point over the button
+		 *
+		 *	\return true if point is inside of the button, and over a solid pixel if its texture has a mask in alphaMaskCache
+		 */
+		bool pointInElement(const SDL_Point point);
 	};
 };
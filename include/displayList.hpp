@@ -0,0 +1,91 @@
+#pragma once
+
+extern "C" {
+#include <SDL2/SDL.h>
+}
+#include <vector>
+
+namespace lui {
+	class element;
+
+	/**
+	 *	\brief A flat list of draw commands recorded from the children of a set
+	 *
+	 *	Sets with retained rendering (set::setRetainedRendering()) record their children into
+	 *	one once, then replay it every frame until a child changes, instead of calling every
+	 *	child's render(). Elements record themselves with element::record(); those which do
+	 *	not are kept in the list as a call to their render(), in the same place.
+	 *
+	 *	Positions are in the set's local coordinates and are shifted when replayed, so
+	 *	scrolling the set does not need the list recorded again.
+	 *
+	 *	\code
+	 *	bool myElement::record(lui::displayList &list) {
+	 *		list.copy(m_background, nullptr, m_dstrect, m_angle, m_flip, m_mod);
+	 *		list.copy(m_icon, nullptr, m_iconRect, m_angle, m_flip, m_mod);
+	 *		return true;
+	 *	}
+	 *	\endcode
+	 */
+	class displayList {
+	public:
+		/**
+		 *	\brief One draw command
+		 */
+		struct command {
+			SDL_Texture *texture = nullptr;
+			SDL_Rect srcrect = { 0, 0, 0, 0 };
+			bool wholeTexture = true; //srcrect is unused
+			SDL_FRect dstrect = { 0.f, 0.f, 0.f, 0.f };
+			double angle = 0; //Degrees clockwise around the upper-left corner of dstrect
+			SDL_RendererFlip flip = SDL_FLIP_NONE;
+			SDL_Color mod = { 255, 255, 255, 255 }; //Color and alpha modulation
+			SDL_FRect bounds = { 0.f, 0.f, 0.f, 0.f }; //Area drawn on, no size if it may be anywhere
+			element *immediate = nullptr; //Element drawn with its own render() instead
+		};
+	private:
+		std::vector<command> m_commands;
+	public:
+		/**
+		 *	\brief Remove every command
+		 */
+		void clear();
+		/**
+		 *	\brief Record a texture being drawn, like renderBackend::copy()
+		 *
+		 *	\param *texture The texture; nothing is recorded if nullptr.
+		 *	\param *srcrect Part of the texture to draw, or nullptr for all of it.
+		 *	\param dstrect Where to draw it, in the set's local coordinates.
+		 *	\param angle Degrees to turn it clockwise around the upper-left corner of dstrect.
+		 *	\param flip How to flip it.
+		 *	\param mod Color and alpha modulation to draw it with.
+		 */
+		void copy(SDL_Texture *texture, const SDL_Rect *srcrect, const SDL_FRect &dstrect, double angle = 0, SDL_RendererFlip flip = SDL_FLIP_NONE, SDL_Color mod = { 255, 255, 255, 255 });
+		/**
+		 *	\brief Record an element drawing itself with render() when replayed
+		 *
+		 *	\param *e The element, which draws with the offset of the set replaying the list.
+		 */
+		void render(element *e);
+		/**
+		 *	\brief Move commands next to earlier ones with the same texture, where nothing between them overlaps
+		 *
+		 *	Draws of the same texture in a row are batched by SDL. Commands are only moved past
+		 *	commands they do not overlap, and never past an element drawing itself, so what is
+		 *	drawn stays the same.
+		 */
+		void groupByTexture();
+		/**
+		 *	\brief Draw the commands in order
+		 *
+		 *	\param *renderer Renderer to draw with.
+		 *	\param offset Added to every dstrect.
+		 *	\param *area Commands entirely outside of this, in local coordinates, are skipped; nullptr to draw all.
+		 */
+		void replay(SDL_Renderer *renderer, SDL_FPoint offset, const SDL_FRect *area);
+		/**
+		 *	\brief Get the recorded commands, in the order they are drawn
+		 */
+		const std::vector<command>& getCommands() const;
+	};
+};
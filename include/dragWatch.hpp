@@ -0,0 +1,88 @@
+#pragma once
+
+#include "./element.hpp"
+
+extern "C" {
+#include <SDL2/SDL.h>
+}
+#include <functional>
+#include <mutex>
+
+namespace lui {
+	/**
+	 *	\brief Low-latency tracking of the cursor while something is dragged
+	 *
+	 *	Normally a dragged item or scroll bar grip only moves when userLogic() is given the
+	 *	frame's events, which can be a whole frame behind the cursor. When enabled, an
+	 *	SDL event watch records the newest cursor position as each motion event arrives,
+	 *	and the outermost set "late-latches" it right before rendering: events are pumped
+	 *	once more and the dragged element is moved to where the cursor is now.
+	 *
+	 *	Only one element is dragged at a time. Items and scroll bars use this on their own
+	 *	once it is enabled.
+	 *
+	 *	\note The event watch may be called from another thread on some platforms; the
+	 *	position is handed over under a mutex, and elements are only ever moved on the
+	 *	thread calling latch().
+	 */
+	class dragWatch {
+	private:
+		std::mutex m_enableMutex; //Serializes setEnabled(); never taken inside of the watch, so SDL may be called under it
+		std::mutex m_mutex; //Guards everything below; taken inside of the watch, so never held while calling SDL
+			bool m_enabled = false;
+			const element *m_target = nullptr; //Element being dragged
+			std::function<void(SDL_FPoint)> m_move; //Moves m_target to a cursor position in window coordinates
+			SDL_FPoint m_position = { 0.f, 0.f }; //Newest cursor position seen
+			bool m_moved = false; //Has the cursor moved since m_move was last called
+
+		static int m_watch(void *userdata, SDL_Event *e);
+
+		dragWatch();
+		~dragWatch();
+	public:
+		/**
+		 *	\brief Get the drag watch shared by all elements
+		 */
+		static dragWatch& global();
+
+		/**
+		 *	\brief Enable or disable low-latency dragging
+		 *
+		 *	Adds or removes the SDL event watch. Disabling ends any drag in progress.
+		 *
+		 *	\param enabled Should drags follow the cursor between frames.
+		 */
+		void setEnabled(bool enabled);
+		/**
+		 *	\brief Is low-latency dragging enabled
+		 */
+		bool isEnabled();
+
+		/**
+		 *	\brief Start following the cursor for an element
+		 *
+		 *	\param *target The element being dragged. Replaces any previous target.
+		 *	\param move Called by latch() with the newest cursor position, in window coordinates.
+		 *
+		 *	\returns false if the watch is disabled, in which case the element should follow motion events itself
+		 */
+		bool begin(const element *target, std::function<void(SDL_FPoint)> move);
+		/**
+		 *	\brief Stop following the cursor
+		 *
+		 *	\param *target The element which was being dragged. Nothing happens if another element is the target.
+		 */
+		void end(const element *target);
+		/**
+		 *	\brief Is an element being dragged through the watch
+		 */
+		bool isDragging(const element *target);
+		/**
+		 *	\brief Move the dragged element to the newest cursor position
+		 *
+		 *	\param pump Pump SDL events first so the watch sees motion which arrived since the last poll.
+		 *	Must be false when not called from the thread which initialized the video subsystem.
+		 */
+		void latch(bool pump = true);
+	};
+};
@@ -0,0 +1,377 @@
+#pragma once
+
+#include "./element.hpp"
+#include "./set.hpp"
+
+extern "C" {
+#include <SDL2/SDL.h>
+}
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include "./extra.hpp" //BoundingBox, RectCorners
+
+namespace lui {
+	template<typename T>
+	class item;
+	template<typename T>
+	class itemHolder;
+	template<typename T>
+	class itemGrid;
+
+	/**
+	 *	\brief Something items of type T can be dropped onto
+	 *
+	 *	Targets register themselves with dropRegistry<T> along with the element they are, and
+	 *	are told by a dragged item<T> as it moves over them, is dropped on them, and is picked
+	 *	back up from them.
+	 *
+	 *	\sa itemHolder, itemGrid
+	 */
+	template<typename T>
+	class dropTarget {
+		friend class item<T>;
+		friend class itemHolder<T>; //Both take items from other targets
+		friend class itemGrid<T>;
+	protected:
+		item<T> *m_hoveringItem = nullptr; //!<Item being dragged over the target
+
+		/**
+		 *	\brief Called while an item is dragged over the target
+		 *
+		 *	\param *dragged The item, or nullptr once it moves off of the target or is dropped.
+		 *	m_hoveringItem still holds the previous item while this is called.
+		 *	\param local Cursor position in the coordinates of the target's set.
+		 */
+		virtual void m_dragOver(item<T> *dragged, SDL_FPoint local) = 0;
+		/**
+		 *	\brief Called when an item is dropped on the target
+		 *
+		 *	\param *dropped The item.
+		 *	\param local Cursor position in the coordinates of the target's set.
+		 *
+		 *	\returns true if the target took the item
+		 */
+		virtual bool m_drop(item<T> *dropped, SDL_FPoint local) = 0;
+		/**
+		 *	\brief Called when an item the target holds is picked up or destroyed
+		 *
+		 *	\param *taken The item.
+		 *	\param force Let go of the item even if the target would rather keep it.
+		 *
+		 *	\returns true if the target let go of the item
+		 */
+		virtual bool m_take(item<T> *taken, bool force) = 0;
+	public:
+		virtual ~dropTarget();
+		/**
+		 *	\brief Gets the item being dragged over the target
+		 *
+		 *	\returns The item, or nullptr if none is
+		 */
+		item<T>* getHoveringItem() {
+			return m_hoveringItem;
+		}
+	};
+
+	/**
+	 *	\brief Finds the drop target under a point, for items of one type
+	 *
+	 *	Every dropTarget<T> registers itself here. Each is listed in a spatial hash under the
+	 *	window-space box it covers, clipped to the sets around it, so finding the target under
+	 *	the cursor only checks the few targets sharing its cell, whichever set they are in.
+	 *
+	 *	Boxes are worked out lazily: targets which moved are updated on the next query, as are
+	 *	those in sets which moved, turned, or scrolled, or are inside of one which did, since
+	 *	the last one. Targets are grouped by set, so only the sets holding targets are checked.
+	 *
+	 *	\sa set::getLastTransformChange()
+	 */
+	template<typename T>
+	class dropRegistry {
+	private:
+		struct entry {
+			element *e = nullptr; //The target, as an element
+			SDL_FRect bounds = { 0.f, 0.f, 0.f, 0.f }; //Window coordinates, clipped by the sets around the target
+			set *parent = nullptr; //Set of e when bounds was worked out
+			bool placed = false; //Listed in m_cells
+			bool dirty = true; //Moved since bounds was worked out
+		};
+		std::unordered_map<dropTarget<T>*, entry> m_entries;
+		std::unordered_map<set*, std::vector<dropTarget<T>*>> m_groups; //Targets by parent, the set they were in when placed
+		std::vector<dropTarget<T>*> m_moved; //Scratch for m_refresh
+		std::unordered_map<Uint64, std::vector<dropTarget<T>*>> m_cells; //Key is the column in the upper 32 bits and the row in the lower
+		std::vector<dropTarget<T>*> m_dirty; //Targets to update on the next query
+		float m_cellSize = 64.f;
+		Uint32 m_generation = 0; //set::getTransformGeneration() when the boxes were last brought up to date
+		bool m_built = false;
+
+		static Uint64 m_cellKey(int column, int row) {
+			return ((Uint64)(Uint32)column << 32) | (Uint32)row;
+		}
+		//Bounding box, in window coordinates, of a rectangle in the local coordinates of s
+		static SDL_FRect m_toWindow(set *s, SDL_FRect r) {
+			if (s == nullptr) {
+				return r;
+			}
+			SDL_FPoint corners[4];
+			RectCorners(rotation(), &r, 1, corners);
+			s->localToWindow(corners, 4, corners);
+			float minX = corners[0].x, minY = corners[0].y, maxX = corners[0].x, maxY = corners[0].y;
+			for (SDL_FPoint &c : corners) {
+				minX = std::min(minX, c.x);
+				minY = std::min(minY, c.y);
+				maxX = std::max(maxX, c.x);
+				maxY = std::max(maxY, c.y);
+			}
+			return SDL_FRect{ minX, minY, maxX - minX, maxY - minY };
+		}
+		static SDL_FRect m_clip(const SDL_FRect &a, const SDL_FRect &b) {
+			float x = std::max(a.x, b.x), y = std::max(a.y, b.y);
+			float w = std::min(a.x + a.w, b.x + b.w) - x, h = std::min(a.y + a.h, b.y + b.h) - y;
+			return SDL_FRect{ x, y, std::max(w, 0.f), std::max(h, 0.f) };
+		}
+		//The part of the window where the target can be dropped onto
+		static SDL_FRect m_windowBounds(element *e) {
+			SDL_FRect bounds = m_toWindow(e->getSet(), BoundingBox(e->getDstrect(), e->getRotation()));
+			for (set *s = e->getSet(); s != nullptr && bounds.w > 0.f && bounds.h > 0.f; s = s->getSet()) {
+				SDL_FRect setRect = s->getDstrect();
+				if (setRect.w > 0 && setRect.h > 0) { //Sets with a size clip their children to their texture
+					bounds = m_clip(bounds, m_toWindow(s->getSet(), BoundingBox(setRect, s->getRotation())));
+				}
+			}
+			return bounds;
+		}
+		template<typename F>
+		void m_forCells(const SDL_FRect &r, F f) {
+			int left = (int)std::floor(r.x / m_cellSize), right = (int)std::floor((r.x + r.w) / m_cellSize);
+			int top = (int)std::floor(r.y / m_cellSize), bottom = (int)std::floor((r.y + r.h) / m_cellSize);
+			for (int column = left; column <= right; column++) {
+				for (int row = top; row <= bottom; row++) {
+					f(m_cellKey(column, row));
+				}
+			}
+		}
+		void m_place(dropTarget<T> *target, entry &e) {
+			e.bounds = m_windowBounds(e.e);
+			e.dirty = false;
+			e.parent = e.e->getSet();
+			m_groups[e.parent].push_back(target);
+			e.placed = e.bounds.w > 0.f && e.bounds.h > 0.f; //Scrolled out of view or clipped away
+			if (e.placed) {
+				m_forCells(e.bounds, [this, target](Uint64 key) {
+					m_cells[key].push_back(target);
+				});
+			}
+		}
+		void m_unplace(dropTarget<T> *target, entry &e) {
+			auto group = m_groups.find(e.parent);
+			if (group != m_groups.end()) {
+				group->second.erase(std::remove(group->second.begin(), group->second.end(), target), group->second.end());
+				if (group->second.empty()) {
+					m_groups.erase(group);
+				}
+			}
+			if (e.placed) {
+				m_forCells(e.bounds, [this, target](Uint64 key) {
+					auto cell = m_cells.find(key);
+					if (cell != m_cells.end()) {
+						cell->second.erase(std::remove(cell->second.begin(), cell->second.end(), target), cell->second.end());
+						if (cell->second.empty()) {
+							m_cells.erase(cell);
+						}
+					}
+				});
+				e.placed = false;
+			}
+		}
+		//Is generation a change made after the boxes were last brought up to date
+		bool m_since(Uint32 generation) {
+			return (Sint32)(generation - m_generation) > 0;
+		}
+		void m_refresh() {
+			Uint32 generation = set::getTransformGeneration();
+			if (!m_built) {
+				m_cells.clear();
+				m_groups.clear();
+				for (auto &e : m_entries) {
+					e.second.placed = false;
+					m_place(e.first, e.second);
+				}
+				m_built = true;
+			}
+			else if (generation != m_generation) {
+				//Only targets in sets which moved, or which left a set, are placed again
+				m_moved.clear();
+				for (auto &group : m_groups) {
+					set *s = group.first;
+					if (s == nullptr) { //Targets outside of any set never move, they are only placed again once added to one
+						for (dropTarget<T> *target : group.second) {
+							if (m_entries[target].e->getSet() != nullptr) {
+								m_moved.push_back(target);
+							}
+						}
+						continue;
+					}
+					//The set is only asked if its first target is still in it, since it may have been destroyed since
+					bool stillIn = m_entries[group.second.front()].e->getSet() == s;
+					bool moved = stillIn && m_since(s->getLastTransformChange());
+					bool left = !stillIn || m_since(s->getLastMembershipChange());
+					if (!moved && !left) {
+						continue;
+					}
+					for (dropTarget<T> *target : group.second) {
+						if (moved || m_entries[target].e->getSet() != s) {
+							m_moved.push_back(target);
+						}
+					}
+				}
+				for (dropTarget<T> *target : m_moved) {
+					entry &e = m_entries[target];
+					m_unplace(target, e);
+					m_place(target, e);
+				}
+			}
+			m_generation = generation;
+			for (dropTarget<T> *target : m_dirty) {
+				auto found = m_entries.find(target);
+				if (found != m_entries.end() && found->second.dirty) {
+					m_unplace(target, found->second);
+					m_place(target, found->second);
+				}
+			}
+			m_dirty.clear();
+		}
+		//Are the target and every set around it shown
+		static bool m_shown(element *e) {
+			if (!e->isVisible()) {
+				return false;
+			}
+			for (set *s = e->getSet(); s != nullptr; s = s->getSet()) {
+				if (!s->isVisible()) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		dropRegistry() {}
+	public:
+		/**
+		 *	\brief Get the registry for items of type T
+		 */
+		static dropRegistry<T>& global() {
+			static dropRegistry<T> registry;
+			return registry;
+		}
+
+		/**
+		 *	\brief Start finding a target
+		 *
+		 *	\param *target The target.
+		 *	\param *e The element which is the target, used for its position and hit testing.
+		 *
+		 *	\note Targets call this when constructed.
+		 */
+		void add(dropTarget<T> *target, element *e) {
+			entry added;
+			added.e = e;
+			if (m_entries.emplace(target, added).second) {
+				m_dirty.push_back(target);
+			}
+		}
+		/**
+		 *	\brief Stop finding a target
+		 *
+		 *	\note Targets call this when destroyed.
+		 */
+		void remove(dropTarget<T> *target) {
+			auto found = m_entries.find(target);
+			if (found != m_entries.end()) {
+				m_unplace(target, found->second);
+				m_entries.erase(found);
+			}
+		}
+		/**
+		 *	\brief Work out where a target is again on the next query
+		 *
+		 *	\note Targets call this when moved or rotated.
+		 */
+		void update(dropTarget<T> *target) {
+			auto found = m_entries.find(target);
+			if (found != m_entries.end() && !found->second.dirty) {
+				found->second.dirty = true;
+				m_dirty.push_back(target);
+			}
+		}
+		/**
+		 *	\brief Get the number of registered targets
+		 */
+		size_t size() {
+			return m_entries.size();
+		}
+		/**
+		 *	\brief Set the size of the hash's cells
+		 *
+		 *	Cells about the size of a target keep each one listed in few cells while
+		 *	keeping few targets in each cell.
+		 *
+		 *	\param size Width and height of a cell, in pixels.
+		 */
+		void setCellSize(float size) {
+			if (size > 0.f && size != m_cellSize) {
+				m_cellSize = size;
+				m_built = false;
+			}
+		}
+		/**
+		 *	\brief Get the size of the hash's cells
+		 */
+		float getCellSize() {
+			return m_cellSize;
+		}
+		/**
+		 *	\brief Find the target under a point
+		 *
+		 *	\param windowPoint Point in window coordinates.
+		 *	\param *local Set to the point in the coordinates of the target's set, if not nullptr.
+		 *
+		 *	\returns The shown target containing the point, or nullptr if there is none. If targets
+		 *	overlap, the most recently placed one is returned.
+		 */
+		dropTarget<T>* find(SDL_FPoint windowPoint, SDL_FPoint *local = nullptr) {
+			m_refresh();
+			auto cell = m_cells.find(m_cellKey((int)std::floor(windowPoint.x / m_cellSize), (int)std::floor(windowPoint.y / m_cellSize)));
+			if (cell == m_cells.end()) {
+				return nullptr;
+			}
+			for (auto it = cell->second.rbegin(); it != cell->second.rend(); it++) {
+				const entry &e = m_entries[*it];
+				if (windowPoint.x < e.bounds.x || windowPoint.y < e.bounds.y || windowPoint.x >= e.bounds.x + e.bounds.w || windowPoint.y >= e.bounds.y + e.bounds.h) {
+					continue;
+				}
+				if (!m_shown(e.e)) {
+					continue;
+				}
+				//The box may be larger than a rotated target, so check the target itself
+				SDL_FPoint point = e.e->getSet() != nullptr ? e.e->getSet()->windowToLocal(windowPoint) : windowPoint;
+				if (e.e->pointInElement(SDL_Point{ (int)std::round(point.x), (int)std::round(point.y) })) {
+					if (local != nullptr) {
+						*local = point;
+					}
+					return *it;
+				}
+			}
+			return nullptr;
+		}
+	};
+
+	template<typename T>
+	dropTarget<T>::~dropTarget() {
+		if (m_hoveringItem != nullptr) {
+			m_hoveringItem->m_hoverTarget = nullptr;
+		}
+		dropRegistry<T>::global().remove(this);
+	}
+};
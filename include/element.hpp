@@ -6,6 +6,8 @@ extern "C" {
 #include <array>
 #include <vector>
 #include <functional>
+#include "./extra.hpp" //rotation
+#include "./renderBackend.hpp"
 
 /**
  *	\brief Humble User Interface namespace
@@ -26,6 +28,8 @@ namespace lui {
 		FocusLost,		//!<Just stopped being current element
 		ValueChanged,	//!<Value of the element has changed
 		DestRectChanged,//!<The dstRect has been changed
+		DragEntered,	//!<An item being dragged moved over the element (itemHolder only)
+		DragLeft,		//!<An item being dragged moved off of the element, or was dropped (itemHolder only)
 
 		//Mouse buttons; These will likely be depricated and removed in the future:
 		LMBDown,		//!<LMB was pressed down on element
@@ -54,6 +58,7 @@ namespace lui {
 
 	class element;
 	class set;
+	class displayList;
 
 	/**
 	 *	\brief The function type of all event functions
@@ -67,21 +72,49 @@ namespace lui {
 	 *	\warning The element class is meant only for the inheritance of other classes and should not typically be instansiated on it's own.
 	 */
 	class element {
+		friend class set; //Sets draw overlaid elements
 	protected:
 		/**
 		 *	\brief Destination Rectangle the element will be drawn in
 		 */
-		SDL_FRect m_dstrect; //Destination rectangle
+		SDL_FRect m_dstrect = { 0.f, 0.f, 0.f, 0.f }; //Destination rectangle
 		/**
 		 *	\brief Angle in degrees the element will be rotated when rendered
 		 *
 		 *	\note The element is rotated around the upper-left corner of m_dstrect
 		 */
 		double m_angle = 0; //Angle
+		/**
+		 *	\brief m_angle's sine and cosine, kept up to date by setAngle()
+		 */
+		rotation m_rotation;
 		/**
 		 *	\brief The flip the element will have when rendered
 		 */
 		SDL_RendererFlip m_flip = SDL_FLIP_NONE; //Flip
+		/**
+		 *	\brief Color (r, g, b) and alpha (a) modulation of the element's textures
+		 */
+		SDL_Color m_mod = { 255, 255, 255, 255 };
+		SDL_Color m_savedMod = { 255, 255, 255, 255 }; //Modulation the texture had before m_applyMod(), put back by m_clearMod()
+		/**
+		 *	\brief Apply m_mod to a texture about to be drawn
+		 *
+		 *	\note Textures may be shared, so pair with m_clearMod() after drawing.
+		 */
+		void m_applyMod(SDL_Texture *texture);
+		/**
+		 *	\brief Undo m_applyMod() once the texture is drawn, putting back the modulation the texture had
+		 */
+		void m_clearMod(SDL_Texture *texture);
+		/**
+		 *	\brief Is a point inside of the element and over a solid pixel of its texture
+		 *
+		 *	\param point Point to check for.
+		 *	\param *texture Texture drawn over the dstrect; hit tested by rectangle if it has no alphaMaskCache mask.
+		 *	\param *srcrect Part of the texture drawn, or nullptr for all of it.
+		 */
+		bool m_pointOnTexture(const SDL_Point point, SDL_Texture *texture, const SDL_Rect *srcrect);
 
 		/**
 		 *	\brief The hui this element is a part of
@@ -89,6 +122,7 @@ namespace lui {
 		 *	@see hui::set#setChild
 		 */
 		set* m_parentSet = nullptr; //The set we are a part of
+		set* m_overlaySet = nullptr; //The outermost set, while it draws us above everything else
 
 		/**
 		 *	\brief Array of all event function pointers
@@ -114,6 +148,64 @@ namespace lui {
 		 *	\brief Does this element have focus
 		 */
 		bool m_hasFocus = false;
+		/**
+		 *	\brief Is this element rendered and given events by its set
+		 */
+		bool m_visible = true;
+		/**
+		 *	\brief Does this element cover every pixel of its dstrect with opaque pixels
+		 */
+		bool m_opaque = false;
+
+		int m_updateDepth = 0; //beginUpdate() calls not yet ended
+		bool m_updatePending = false; //Notifications are being held back until the update ends
+		bool m_pendingListed = false; //Our set will deliver them when its update ends
+			bool m_pendingInvalidate = false; //Looks different
+			bool m_pendingFocus = false; //Moved, turned, or shown or hidden
+			bool m_pendingDestRect = false; //DestRectChanged is owed
+			SDL_FRect m_pendingBounds = { 0.f, 0.f, 0.f, 0.f }; //Bounding box before the first held back change
+		/**
+		 *	\brief Should notifications be held back
+		 *
+		 *	\return true if this element, or the set it is in, is between beginUpdate() and endUpdate()
+		 */
+		bool m_deferring();
+		/**
+		 *	\brief Start holding back notifications, remembering where the element was
+		 */
+		void m_deferChange();
+		/**
+		 *	\brief Deliver the held back notifications
+		 */
+		void m_commitUpdate();
+
+		/**
+		 *	\brief Distance every element is shifted by while rendering
+		 *
+		 *	Sets change this while their children render, for their render corner or the cache
+		 *	tile being drawn, so children never need their dstrect changed to be drawn elsewhere.
+		 */
+		static thread_local SDL_FPoint m_renderOffset;
+		/**
+		 *	\brief Get a rectangle shifted by the current render offset
+		 *
+		 *	\param r Rectangle in the coordinates of the parent set.
+		 *
+		 *	\return Where to draw the rectangle on the current render target
+		 */
+		static SDL_FRect m_offsetRect(SDL_FRect r) {
+			r.x += m_renderOffset.x;
+			r.y += m_renderOffset.y;
+			return r;
+		}
+		/**
+		 *	\brief Get the dstrect to draw with in render()
+		 *
+		 *	\return m_dstrect shifted by the current render offset
+		 */
+		SDL_FRect m_renderDstrect() {
+			return m_offsetRect(m_dstrect);
+		}
 	public:
 		/**
 		 *	\brief Construct the element a size of 0x0
@@ -136,8 +228,37 @@ namespace lui {
 		 *	\brief Render the element
 		 *
 		 *	\param *renderer Renderer to use for rendering.
+		 *
+		 *	\note Overrides must draw at m_renderDstrect(), or shift other rectangles with
+		 *	m_offsetRect(), rather than at m_dstrect. Sets no longer move their children's dstrects
+		 *	while rendering, so drawing at m_dstrect puts the element in the wrong place inside sets
+		 *	with a render corner, cached tiles, or scrolling.
 		 */
 		virtual void render(SDL_Renderer *renderer);
+		/**
+		 *	\brief Free the textures the element made for itself
+		 *
+		 *	They are made again by the next render(), which may be given another renderer.
+		 *	Called on the children of a set when it starts or stops rendering on a worker thread.
+		 *
+		 *	\note Textures given to the element are left alone.
+		 */
+		virtual void releaseTextures();
+		/**
+		 *	\brief Record how the element draws into a set's display list
+		 *
+		 *	Called instead of render() by sets with retained rendering (set::setRetainedRendering()),
+		 *	once until the element or its set changes. Record what render() would draw, in local
+		 *	coordinates, without the render offset.
+		 *
+		 *	\param &list The list to record into.
+		 *
+		 *	\return true if recorded, or false to be drawn with render() when the list is replayed, which is the default
+		 *
+		 *	\note Classes overriding render() of a class which records must override this too.
+		 *	\note Changes the list cannot see, such as to a texture's pixels, need invalidate().
+		 */
+		virtual bool record(displayList &list);
 		/**
 		 *	\brief Update the element based on events
 		 *
@@ -183,6 +304,12 @@ namespace lui {
 		 *	\param s The set which we are a part of.
 		 */
 		void setSet(set* s);
+		/**
+		 *	\brief Get the set this element is a part of
+		 *
+		 *	\return The parent set, or nullptr if there is none
+		 */
+		set* getSet();
 		/**
 		 *	\brief Tell this element if it has focus or not
 		 *
@@ -217,6 +344,12 @@ namespace lui {
 		 *	\return The angle of the element in degrees
 		 */
 		virtual double getAngle();
+		/**
+		 *	\brief Gets the current angle of the element, with its sine and cosine
+		 *
+		 *	\return The rotation of the element around the upper-left corner of its dstrect
+		 */
+		const rotation& getRotation();
 		/**
 		 *	\brief Set the flip of the element
 		 *
@@ -229,6 +362,107 @@ namespace lui {
 		 *	\return The flip of the element
 		 */
 		virtual SDL_RendererFlip getFlip();
+		/**
+		 *	\brief Tint the element's textures
+		 *
+		 *	\param r Red multiplier, where 255 leaves red unchanged.
+		 *	\param g Green multiplier.
+		 *	\param b Blue multiplier.
+		 */
+		void setColorMod(Uint8 r, Uint8 g, Uint8 b);
+		/**
+		 *	\brief Get the tint of the element's textures
+		 *
+		 *	\return The color multipliers, with the alpha multiplier as a
+		 */
+		SDL_Color getColorMod();
+		/**
+		 *	\brief Fade the element's textures
+		 *
+		 *	\param a Alpha multiplier, where 255 leaves them opaque.
+		 */
+		void setAlphaMod(Uint8 a);
+		/**
+		 *	\brief Get the alpha multiplier of the element's textures
+		 */
+		Uint8 getAlphaMod();
+		/**
+		 *	\brief Show or hide the element
+		 *
+		 *	Hidden elements stay in their set but are skipped when it renders,
+		 *	runs userLogic, and looks for the focused element.
+		 *
+		 *	\param visible Should the element be shown.
+		 */
+		void setVisible(bool visible);
+		/**
+		 *	\brief Is the element shown
+		 *
+		 *	\return true if the element is rendered by its set.
+		 */
+		bool isVisible();
+		/**
+		 *	\brief Promise that the element hides everything under its dstrect
+		 *
+		 *	Sets skip drawing children entirely behind an opaque, unrotated element in front of
+		 *	them, so stacked pages and modal dialogs stop paying to draw what is hidden.
+		 *
+		 *	\param opaque Does the element draw an opaque pixel at every pixel of its dstrect.
+		 *
+		 *	\note Elements which draw outside of their dstrect are drawn regardless.
+		 */
+		void setOpaque(bool opaque);
+		/**
+		 *	\brief Does the element hide everything under its dstrect
+		 *
+		 *	\return true if set opaque and not faded by setAlphaMod()
+		 */
+		virtual bool isOpaque();
+		/**
+		 *	\brief Start a batch of changes
+		 *
+		 *	Until the matching endUpdate(), changes to the element are made right away, but the
+		 *	notifications they cause are held back: the set is invalidated once for where the
+		 *	element was and once for where it ends up, focus is rechecked once, and
+		 *	DestRectChanged fires once. Updates may be nested.
+		 *
+		 *	\code
+		 *	e.beginUpdate();
+		 *	e.setDstrect(rect);
+		 *	e.setAngle(angle);
+		 *	e.endUpdate(); //DestRectChanged fires here
+		 *	\endcode
+		 *
+		 *	\sa set::beginUpdate()
+		 */
+		virtual void beginUpdate();
+		/**
+		 *	\brief End a batch of changes, delivering the notifications held back if it is the outermost one
+		 *
+		 *	\note If the element's set is itself updating, the notifications are delivered when the set's update ends.
+		 */
+		virtual void endUpdate();
+		/**
+		 *	\brief Is the element between beginUpdate() and endUpdate()
+		 */
+		bool isUpdating();
+		/**
+		 *	\brief Tell the parent set the element looks different
+		 *
+		 *	Sets caching their content in tiles only redraw the tiles which were invalidated.
+		 *	Changes made through the element's own functions invalidate automatically; call this
+		 *	after changing anything else shown, such as the srcrect of a button, or the contents
+		 *	of a texture it draws.
+		 *
+		 *	\sa set::setTileCaching()
+		 */
+		void invalidate();
+		/**
+		 *	\brief Is the element drawn on its outermost set's overlay
+		 *
+		 *	\sa set::addOverlay()
+		 */
+		bool isOverlaid();
 
 		/**
 		*	\brief Is a point inside the interface
@@ -44,6 +44,135 @@ namespace lui {
 	*	\returns 0 on success, or -1 on error
 	*/
 	int RenderBezierCurve(SDL_Renderer* renderer, const SDL_FPoint p1, const SDL_FPoint p1c, const SDL_FPoint p2c, const SDL_FPoint p2, unsigned int segments = 16, unsigned int segmentsToRender = 0);
+
+	/**
+	 *	\brief The four points of a cubic Bezier curve
+	 */
+	struct bezierCurve {
+		SDL_FPoint p1; //!<The start point
+		SDL_FPoint p1c; //!<The start point's control point
+		SDL_FPoint p2c; //!<The end point's control point
+		SDL_FPoint p2; //!<The end point
+	};
+
+	/**
+	 *	\brief Turn a Bezier curve into line segments no further than a tolerance from it
+	 *
+	 *	The curve is split in half until each piece is flat enough, so gentle curves get few
+	 *	segments and tight ones get many.
+	 *
+	 *	\param &points Points are appended to this, starting with p1 unless it already ends there, and ending with p2.
+	 *	\param p1 The start point.
+	 *	\param p1c The start point's control point.
+	 *	\param p2c The end point's control point.
+	 *	\param p2 The end point.
+	 *	\param tolerance Greatest distance, in pixels, between the segments and the curve.
+	 *
+	 *	\returns The number of points appended
+	 */
+	size_t FlattenBezierCurve(std::vector<SDL_FPoint> &points, const SDL_FPoint p1, const SDL_FPoint p1c, const SDL_FPoint p2c, const SDL_FPoint p2, float tolerance = 0.25f);
+
+	/**
+	 *	\brief Render many Bezier curves on the target, each flattened to a tolerance
+	 *
+	 *	Each curve is drawn with one renderBackend::drawLines() call.
+	 *
+	 *	\param renderer The renderer to render the Bezier curves on.
+	 *	\param &curves The curves.
+	 *	\param tolerance Greatest distance, in pixels, between the drawn lines and the curves.
+	 *
+	 *	\returns 0 on success, or -1 on error
+	 */
+	int RenderBezierCurves(SDL_Renderer* renderer, const std::vector<bezierCurve> &curves, float tolerance = 0.25f);
+
+	/**
+	 *	\brief Render many thick, antialiased Bezier curves on the target
+	 *
+	 *	Every curve is built into one triangle mesh, with a one pixel fringe fading to transparent
+	 *	on each side, and drawn with a single renderBackend::geometry() call.
+	 *
+	 *	\param renderer The renderer to render the Bezier curves on.
+	 *	\param &curves The curves.
+	 *	\param thickness Width of the curves, in pixels.
+	 *	\param color Color of the curves.
+	 *	\param tolerance Greatest distance, in pixels, between the drawn lines and the curves.
+	 *
+	 *	\returns 0 on success, or -1 on error
+	 *
+	 *	\note Falls back to RenderBezierCurves() when built against SDL older than 2.0.18.
+	 */
+	int RenderThickBezierCurves(SDL_Renderer* renderer, const std::vector<bezierCurve> &curves, float thickness, SDL_Color color, float tolerance = 0.25f);
+
+	/**
+	 *	\brief Calculate points, and optionally tangents, along many Bezier curves at once
+	 *
+	 *	Each curve is evaluated at its own parameter through the Bernstein polynomials, four
+	 *	at a time with SSE2 or NEON when available.
+	 *
+	 *	\param *curves The curves; curves[i] is evaluated at t[i].
+	 *	\param *t The parameters, each from 0 to 1.
+	 *	\param count Number of curves and parameters.
+	 *	\param *positions Filled with count points.
+	 *	\param *tangents Filled with count derivatives of the curves, not normalized, if not nullptr.
+	 */
+	void PointsAlongBezierCurves(const bezierCurve *curves, const float *t, size_t count, SDL_FPoint *positions, SDL_FPoint *tangents = nullptr);
+
+	/**
+	 *	\brief Lookup table from distance along a Bezier curve to the parameter at that distance
+	 *
+	 *	Moving the parameter evenly doesn't move evenly along a curve. The table samples the
+	 *	curve's length once, so points can then be found by distance, such as for dots moving
+	 *	along it at a constant speed.
+	 *
+	 *	\code
+	 *	table.build(curve); //Only samples again if the curve changed
+	 *	table.parametersAt(distances.data(), distances.size(), t.data());
+	 *	lui::PointsAlongBezierCurves(curves.data(), t.data(), t.size(), positions.data());
+	 *	\endcode
+	 */
+	class arcLengthTable {
+	private:
+		bezierCurve m_curve = { { 0.f, 0.f }, { 0.f, 0.f }, { 0.f, 0.f }, { 0.f, 0.f } };
+		std::vector<float> m_lengths; //Length from the start to each sample, sampled evenly by parameter
+	public:
+		arcLengthTable() {}
+		/**
+		 *	\brief Construct the table for a curve
+		 *
+		 *	\param curve The curve.
+		 *	\param samples Number of straight pieces to measure the curve with.
+		 */
+		arcLengthTable(const bezierCurve &curve, unsigned int samples = 64);
+		/**
+		 *	\brief Measure a curve, unless it is the one already measured
+		 *
+		 *	\param curve The curve.
+		 *	\param samples Number of straight pieces to measure the curve with.
+		 *
+		 *	\returns true if the curve was measured, false if the table was already for it
+		 */
+		bool build(const bezierCurve &curve, unsigned int samples = 64);
+		/**
+		 *	\brief Get the length of the curve
+		 */
+		float getLength() const;
+		/**
+		 *	\brief Find the parameter at a distance along the curve
+		 *
+		 *	\param distance Distance from the start; clamped to the curve.
+		 *
+		 *	\returns The parameter, from 0 to 1
+		 */
+		float parameterAt(float distance) const;
+		/**
+		 *	\brief Find the parameters at many distances along the curve
+		 *
+		 *	\param *distances The distances.
+		 *	\param count Number of distances.
+		 *	\param *t Filled with count parameters.
+		 */
+		void parametersAt(const float *distances, size_t count, float *t) const;
+	};
 	
 	/**
 	 *	\/brief Render a Bezier curve on the target.
@@ -67,4 +196,153 @@ namespace lui {
 	 *	\returns Translated point
 	 */
 	SDL_FPoint RotatePoint(SDL_FPoint point, double degrees, SDL_FPoint pivot = { 0.f, 0.f });
+
+	/**
+	 *	\brief Get the axis-aligned rectangle around a rotated rectangle
+	 *
+	 *	\param rect The rectangle before rotating.
+	 *	\param degrees How many degrees the rectangle is rotated around its upper-left corner.
+	 *
+	 *	\returns The smallest rectangle containing every corner of the rotated rectangle
+	 */
+	SDL_FRect BoundingBox(SDL_FRect rect, double degrees);
+
+	/**
+	 *	\brief An angle with its sine and cosine worked out once
+	 *
+	 *	RotatePoint() works out the trig on every call. Anything turning points by the same
+	 *	angle over and over, such as an element hit testing against its own angle, keeps one
+	 *	of these and only builds a new one when the angle changes.
+	 *
+	 *	\code
+	 *	lui::rotation r(30.0);
+	 *	SDL_FPoint turned = r.apply(point, pivot);
+	 *	SDL_FPoint back = r.applyInverse(turned, pivot);
+	 *	\endcode
+	 */
+	struct rotation {
+		double degrees = 0; //!<The angle, in degrees
+		float cosine = 1.f; //!<Cosine of the angle
+		float sine = 0.f; //!<Sine of the angle
+		bool identity = true; //!<The angle is a whole number of turns, so nothing moves
+
+		rotation() {}
+		/**
+		 *	\brief Construct a rotation by an angle
+		 *
+		 *	\param deg The angle, in degrees.
+		 */
+		explicit rotation(double deg);
+
+		/**
+		 *	\brief Rotate a point around a pivot point, the same as RotatePoint()
+		 */
+		SDL_FPoint apply(SDL_FPoint point, SDL_FPoint pivot = { 0.f, 0.f }) const {
+			if (identity) {
+				return point;
+			}
+			float x = point.x - pivot.x, y = point.y - pivot.y;
+			return SDL_FPoint{ x * cosine - y * sine + pivot.x, y * cosine + x * sine + pivot.y };
+		}
+		/**
+		 *	\brief Rotate a point back around a pivot point, undoing apply()
+		 */
+		SDL_FPoint applyInverse(SDL_FPoint point, SDL_FPoint pivot = { 0.f, 0.f }) const {
+			if (identity) {
+				return point;
+			}
+			float x = point.x - pivot.x, y = point.y - pivot.y;
+			return SDL_FPoint{ x * cosine + y * sine + pivot.x, y * cosine - x * sine + pivot.y };
+		}
+		/**
+		 *	\brief Get the rotation by the opposite angle
+		 */
+		rotation inverse() const {
+			rotation r = *this;
+			r.degrees = -degrees;
+			r.sine = -sine;
+			return r;
+		}
+	};
+
+	/**
+	 *	\brief Get the axis-aligned rectangle around a rotated rectangle
+	 *
+	 *	\param rect The rectangle before rotating.
+	 *	\param r How the rectangle is rotated around its upper-left corner.
+	 *
+	 *	\returns The smallest rectangle containing every corner of the rotated rectangle
+	 */
+	SDL_FRect BoundingBox(SDL_FRect rect, const rotation &r);
+
+	/**
+	 *	\brief Rotate many points around one pivot point
+	 *
+	 *	Points are turned several at a time with SSE2 or NEON when available.
+	 *
+	 *	\param r The rotation.
+	 *	\param *points The points.
+	 *	\param count Number of points.
+	 *	\param *rotated Filled with count points; may be the same array as points.
+	 *	\param pivot The point to rotate around.
+	 */
+	void RotatePoints(const rotation &r, const SDL_FPoint *points, size_t count, SDL_FPoint *rotated, SDL_FPoint pivot = { 0.f, 0.f });
+
+	/**
+	 *	\brief Get the corners of many rectangles, each rotated around its upper-left corner
+	 *
+	 *	\param r The rotation.
+	 *	\param *rects The rectangles.
+	 *	\param count Number of rectangles.
+	 *	\param *corners Filled with 4 * count points: the upper-left, upper-right, lower-right,
+	 *	then lower-left corner of each rectangle, before rotating.
+	 */
+	void RectCorners(const rotation &r, const SDL_FRect *rects, size_t count, SDL_FPoint *corners);
+
+	/**
+	 *	\brief Do two rectangles overlap
+	 *
+	 *	\param a The first rectangle.
+	 *	\param b The second rectangle.
+	 *
+	 *	\returns true if the rectangles share some area; touching edges do not count
+	 */
+	bool RectsOverlap(const SDL_FRect &a, const SDL_FRect &b);
+	/**
+	 *	\brief Get the smallest rectangle containing two rectangles
+	 *
+	 *	\param a The first rectangle.
+	 *	\param b The second rectangle.
+	 *
+	 *	\returns The union of the rectangles
+	 */
+	SDL_FRect UnionRect(const SDL_FRect &a, const SDL_FRect &b);
+	/**
+	 *	\brief Is one rectangle inside of another
+	 *
+	 *	\param outer The rectangle which may contain the other.
+	 *	\param inner The rectangle which may be contained.
+	 *
+	 *	\returns true if every point of inner is in outer; shared edges count
+	 */
+	bool RectContains(const SDL_FRect &outer, const SDL_FRect &inner);
+
+	/**
+	 *	\brief Merge runs of mouse motion and mouse wheel events
+	 *
+	 *	Consecutive SDL_MOUSEMOTION events from the same mouse and window become one event
+	 *	with the latest position and button state and the sum of their relative motion.
+	 *	Consecutive SDL_MOUSEWHEEL events are merged by summing their scroll amounts.
+	 *	Any other event ends a run, so motion is never moved across a button press, key
+	 *	press, or anything else.
+	 *
+	 *	With high-rate mice this lets hit testing and dragging run once per frame instead
+	 *	of once per report.
+	 *
+	 *	\param &events Events to merge, in place.
+	 *
+	 *	\returns How many events were removed
+	 *	\sa set::setCoalesceEvents()
+	 */
+	size_t CoalesceEvents(std::vector<SDL_Event> &events);
 };
@@ -2,6 +2,9 @@
 
 #include "./element.hpp"
 #include "./itemHolder.hpp"
+#include "./set.hpp"
+#include "./dragWatch.hpp"
+#include "./displayList.hpp"
 
 extern "C" {
 #include <SDL2/SDL.h>
@@ -10,16 +13,68 @@ extern "C" {
 
 namespace lui {
 	
+	template<typename T>
+	class itemGrid;
+
 	/**
-	 *	\brief A draggable item which can be placed inside itemHolders
+	 *	\brief A draggable item which can be placed inside itemHolders and itemGrids
+	 *
+	 *	When dropped, the item is given to the dropTarget<T> under the cursor, found through
+	 *	dropRegistry<T>, in whichever set it is. While dragged, the target under the cursor
+	 *	is told as the item moves over it. While dragged, the item is drawn on the outermost
+	 *	set's overlay, above everything else.
 	 *
 	 *	\note Item template type must match the itemHolder's template type for the item to be held.
 	 */
 	template<typename T>
 	class item : public element {
+		friend class dropTarget<T>;
+		friend class itemHolder<T>;
+		friend class itemGrid<T>;
 	protected:
 		SDL_Texture *m_texture = nullptr; //!<The texture of the item
 		bool m_beingMoved = false; //!<Is this item currently being moved by the user
+		SDL_FPoint m_grabPoint = { 0.f, 0.f }; //!<Cursor position in the parent set when picked up, used by the drag watch
+		SDL_FRect m_grabDstrect = { 0.f, 0.f, 0.f, 0.f }; //!<Dstrect when picked up, used by the drag watch
+		SDL_FPoint m_cursorPoint = { 0.f, 0.f }; //!<Cursor position in the parent set while being moved
+		dropTarget<T> *m_container = nullptr; //!<Target holding the item
+		size_t m_containerSlot = 0; //!<Slot of m_container holding the item, for targets with several
+		dropTarget<T> *m_hoverTarget = nullptr; //!<Target under the cursor while being moved
+		SDL_FPoint m_hoverPoint = { 0.f, 0.f }; //!<Cursor position in the coordinates of m_hoverTarget's set
+
+		/**
+		 *	\brief Find the target under the cursor and tell it, and the last one if it changed
+		 */
+		void m_updateHover() {
+			dropTarget<T> *target = nullptr;
+			if (m_beingMoved) {
+				target = dropRegistry<T>::global().find(m_parentSet != nullptr ? m_parentSet->localToWindow(m_cursorPoint) : m_cursorPoint, &m_hoverPoint);
+			}
+			if (target != m_hoverTarget && m_hoverTarget != nullptr) {
+				m_hoverTarget->m_dragOver(nullptr, m_hoverPoint);
+				m_hoverTarget->m_hoveringItem = nullptr;
+			}
+			m_hoverTarget = target;
+			if (m_hoverTarget != nullptr) {
+				m_hoverTarget->m_dragOver(this, m_hoverPoint);
+				m_hoverTarget->m_hoveringItem = this;
+			}
+		}
+
+		/**
+		 *	\brief Move the item by how far the cursor has moved since it was picked up
+		 *
+		 *	\param windowPoint Cursor position in window coordinates.
+		 */
+		void m_dragTo(SDL_FPoint windowPoint) {
+			SDL_FPoint local = m_parentSet != nullptr ? m_parentSet->windowToLocal(windowPoint) : windowPoint;
+			invalidate();
+			m_dstrect.x = m_grabDstrect.x + local.x - m_grabPoint.x;
+			m_dstrect.y = m_grabDstrect.y + local.y - m_grabPoint.y;
+			invalidate();
+			m_cursorPoint = local;
+			m_updateHover();
+		}
 	public:
 		SDL_Rect *srcrect = nullptr; //!<Rectangle of the texture to draw
 		itemHolder<T> *m_holder = nullptr; //!<The itemHolder to which we are assigned \warning This item should never be written to.
@@ -52,24 +107,50 @@ namespace lui {
 		/**
 		 *	\brief Deconstruct item
 		 */
-		~item() {}
+		~item() {
+			dragWatch::global().end(this);
+			if (m_hoverTarget != nullptr) {
+				m_hoverTarget->m_hoveringItem = nullptr;
+			}
+			if (m_container != nullptr) {
+				m_container->m_take(this, true);
+			}
+		}
 
 		void render(SDL_Renderer *renderer) {
-			SDL_RenderCopyExF(renderer, m_texture, srcrect, &m_dstrect, m_angle, &(zeroFPoint), m_flip);
+			SDL_FRect dstrect = m_renderDstrect();
+			m_applyMod(m_texture);
+			renderBackend::get(renderer)->copy(m_texture, srcrect, &dstrect, m_angle, &(zeroFPoint), m_flip);
+			m_clearMod(m_texture);
+		}
+		bool record(displayList &list) {
+			list.copy(m_texture, srcrect, m_dstrect, m_angle, m_flip, m_mod);
+			return true;
 		}
 		void userLogic(std::vector<SDL_Event> &events, SDL_Renderer *renderer) {
 			element::userLogic(events, renderer);
+			bool watched = m_beingMoved && dragWatch::global().isDragging(this);
+			if (watched) {
+				//Catch up with the watch before focus is checked against these events
+				dragWatch::global().latch(false);
+			}
+			SDL_FPoint cursorBefore = m_cursorPoint;
 			for (SDL_Event &e : events) {
-				if (m_hasFocus) {
+				if (m_beingMoved && !watched && e.type == SDL_MOUSEMOTION) {
+					m_cursorPoint = SDL_FPoint{ (float)e.motion.x, (float)e.motion.y };
+				}
+				if (m_hasFocus || m_beingMoved) { //While dragged it follows the cursor, and only drops when the button is let go
 					switch (e.type) {
 					case SDL_MOUSEMOTION:
-						if (m_beingMoved) {
+						if (m_beingMoved && !watched) {
+							invalidate();
 							m_dstrect.x += e.motion.xrel;
 							m_dstrect.y += e.motion.yrel;
+							invalidate();
 						}
 						break;
 					case SDL_MOUSEBUTTONDOWN:
-						if (e.button.button == SDL_BUTTON_LEFT) {
+						if (m_hasFocus && e.button.button == SDL_BUTTON_LEFT) {
 							//Start dragging item.
 							pickup();
 						}
@@ -77,12 +158,18 @@ namespace lui {
 					case SDL_MOUSEBUTTONUP:
 						if (e.button.button == SDL_BUTTON_LEFT) {
 							//Release item
+							if (m_beingMoved) {
+								m_cursorPoint = SDL_FPoint{ (float)e.button.x, (float)e.button.y };
+							}
 							release();
 						}
 						break;
 					}
 				}
 			}
+			if (m_beingMoved && (m_cursorPoint.x != cursorBefore.x || m_cursorPoint.y != cursorBefore.y)) {
+				m_updateHover();
+			}
 		}
 		void resetUserLogic() {
 			element::resetUserLogic();
@@ -95,11 +182,6 @@ namespace lui {
 
 		using element::setSet;
 		using element::setFocus;
-		void onFocusUpdated() {
-			if (!m_hasFocus && m_beingMoved) {
-				release();
-			}
-		}
 		using element::setDstrect;
 		using element::getDstrect;
 		using element::setAngle;
@@ -111,6 +193,7 @@ namespace lui {
 		 */
 		void setTexture(SDL_Texture *texture) {
 			m_texture = texture;
+			invalidate();
 		}
 		/**
 		 *	\brief Gets the item's texture
@@ -124,29 +207,60 @@ namespace lui {
 		 *	\brief Release/drop the item
 		 */
 		void release() {
+			if (!m_beingMoved) {
+				return;
+			}
+			dragWatch::global().end(this);
+			if (m_overlaySet != nullptr) {
+				m_overlaySet->removeOverlay(this);
+			}
+			//Check if we were released on a target
+			m_updateHover();
+			dropTarget<T> *target = m_hoverTarget;
+			SDL_FPoint point = m_hoverPoint;
 			m_beingMoved = false;
-			//Check if we were released on an itemHolder
-			if (m_parentSet != nullptr) {
-				std::array<element*, 2> focused = m_parentSet->getFocusedElements();
-				itemHolder<T>* focusedSub = dynamic_cast<itemHolder<T>*>(focused[1]);
-				if (focused[0] == this && focusedSub != nullptr) {
-					focusedSub->setChild(this);
-				}
+			m_updateHover();
+			if (target != nullptr) {
+				target->m_drop(this, point);
 			}
 		}
 		/**
 		 *	\brief Pickup the item and attach it to the user's mouse
+		 *
+		 *	\note Nothing happens if the item is held by a target which refuses to let go of it.
 		 */
 		void pickup() {
-			m_beingMoved = true;
 			//Check if we are being taken from an itemHolder
-			if (m_holder != nullptr) {
-				m_holder->setChild((item<T>*)nullptr);
+			if (m_container != nullptr) {
+				if (!m_container->m_take(this, false)) {
+					return;
+				}
+				m_container = nullptr;
 				m_holder = nullptr;
 				m_callEventFunction(Event::ValueChanged);
 			}
+			m_beingMoved = true;
+			//Follow the cursor between frames if the drag watch is enabled
+			int x = 0, y = 0;
+			SDL_GetMouseState(&x, &y);
+			SDL_FPoint windowPoint = { (float)x, (float)y };
+			m_grabPoint = m_parentSet != nullptr ? m_parentSet->windowToLocal(windowPoint) : windowPoint;
+			m_grabDstrect = m_dstrect;
+			m_cursorPoint = m_grabPoint;
+			dragWatch::global().begin(this, [this](SDL_FPoint p) { m_dragTo(p); });
+			if (m_parentSet != nullptr) { //Draw above everything while dragged, without redrawing the set under us
+				m_parentSet->getRoot()->addOverlay(this);
+			}
+			m_updateHover();
 		}
 
-		using element::pointInElement;
+		/**
+		 *	\brief Is a point over the item
+		 *
+		 *	\return true if point is inside of the item, and over a solid pixel if its texture has a mask in alphaMaskCache
+		 */
+		bool pointInElement(const SDL_Point point) {
+			return m_pointOnTexture(point, m_texture, srcrect);
+		}
 	};
 };
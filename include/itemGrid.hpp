@@ -0,0 +1,430 @@
+#pragma once
+
+#include "./element.hpp"
+#include "./set.hpp"
+#include "./item.hpp"
+#include "./dropRegistry.hpp"
+
+extern "C" {
+#include <SDL2/SDL.h>
+}
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include "./extra.hpp" //rotation, RectCorners
+
+namespace lui {
+	/**
+	 *	\brief A grid of slots which each hold one item
+	 *
+	 *	Works like a grid of itemHolders, but is a single element: the slots are one array of
+	 *	item pointers, the slot under a point is found from its row and column, and every slot
+	 *	background and held item is drawn in a few batched calls rather than one per slot.
+	 *
+	 *	Items placed in the grid are taken out of their set and drawn by the grid. Pressing on
+	 *	a held item puts it back into the grid's set and picks it up, and items dropped on the
+	 *	grid land in the slot under the cursor.
+	 *
+	 *	\code
+	 *	lui::itemGrid<int> inventory(slotTexture, { 0, 0, 640, 640 }, 100, 100);
+	 *	inventory.setSlot(0, &sword);
+	 *	inventory.bind(lui::ValueChanged, [&inventory](lui::element*, SDL_Event*) {
+	 *		size_t slot = inventory.getLastChangedSlot();
+	 *		save(slot, inventory.getSlotValue(slot));
+	 *	});
+	 *	\endcode
+	 *
+	 *	\note Slots are numbered row by row, starting at the upper left.
+	 *	\note Batching needs SDL 2.0.18 or newer; older versions draw each slot with its own copy.
+	 */
+	template<typename T>
+	class itemGrid : public element, public dropTarget<T> {
+	public:
+		/**
+		 *	\brief The function type used to check if an item is valid for a slot
+		 *
+		 *	The item will be nullptr when checking if a slot's item can be removed.
+		 */
+		typedef bool(*slotAcceptFunction)(itemGrid<T>*, size_t, item<T>*);
+	protected:
+		SDL_Texture *m_slotTexture = nullptr; //!<Background texture of every slot
+		int m_columns = 1, m_rows = 1;
+		std::vector<item<T>*> m_slots; //!<Item held in each slot, or nullptr
+		slotAcceptFunction m_acceptFunction = nullptr;
+		size_t m_lastChangedSlot = 0;
+		size_t m_hoveredSlot = 0; //!<Slot under a dragged item, or getSlotCount() if none
+
+		std::vector<SDL_Vertex> m_vertices; //!<Reused between frames for batching
+		std::vector<int> m_indices;
+
+		using dropTarget<T>::m_hoveringItem;
+
+		void m_dragOver(item<T> *dragged, SDL_FPoint local) {
+			if (dragged != m_hoveringItem) {
+				if (m_hoveringItem != nullptr) {
+					m_callEventFunction(Event::DragLeft);
+				}
+				if (dragged != nullptr) {
+					m_callEventFunction(Event::DragEntered);
+				}
+			}
+			size_t slot = dragged != nullptr ? slotAt(SDL_Point{ (int)std::round(local.x), (int)std::round(local.y) }) : m_slots.size();
+			if (slot != m_hoveredSlot) {
+				m_hoveredSlot = slot;
+				invalidate();
+			}
+		}
+		bool m_drop(item<T> *dropped, SDL_FPoint local) {
+			size_t slot = slotAt(SDL_Point{ (int)std::round(local.x), (int)std::round(local.y) });
+			return slot < m_slots.size() && setSlot(slot, dropped);
+		}
+		bool m_take(item<T> *taken, bool force) {
+			size_t slot = taken->m_containerSlot;
+			if (taken->m_container != this || slot >= m_slots.size() || m_slots[slot] != taken) {
+				return true;
+			}
+			if (!force && m_acceptFunction != nullptr && !m_acceptFunction(this, slot, nullptr)) {
+				return false;
+			}
+			m_clearSlot(slot);
+			return true;
+		}
+		//Empty a slot without asking the accept function
+		void m_clearSlot(size_t slot) {
+			item<T> *previous = m_slots[slot];
+			m_slots[slot] = nullptr;
+			previous->m_container = nullptr;
+			m_lastChangedSlot = slot;
+			invalidate();
+			m_callEventFunction(Event::ValueChanged);
+		}
+		//Center a held item in its slot, in the coordinates of our set
+		void m_placeItem(size_t slot) {
+			item<T> *held = m_slots[slot];
+			SDL_FRect slotRect = getSlotRect(slot), itemRect = held->getDstrect();
+			SDL_FPoint nominalPosition = { slotRect.x + (slotRect.w - itemRect.w) / 2.f, slotRect.y + (slotRect.h - itemRect.h) / 2.f };
+			SDL_FPoint upperLeft = m_rotation.apply(nominalPosition, { m_dstrect.x, m_dstrect.y });
+			itemRect.x = upperLeft.x;
+			itemRect.y = upperLeft.y;
+			held->beginUpdate(); //Moved and turned as one change
+			held->setDstrect(itemRect);
+			held->setAngle(m_angle);
+			held->endUpdate();
+		}
+		//Queue a textured quad, rotated about its upper left corner
+		void m_pushQuad(SDL_FRect dst, const rotation &r, SDL_FPoint uv0, SDL_FPoint uv1, SDL_RendererFlip flip, SDL_Color mod) {
+			if (flip & SDL_FLIP_HORIZONTAL) {
+				std::swap(uv0.x, uv1.x);
+			}
+			if (flip & SDL_FLIP_VERTICAL) {
+				std::swap(uv0.y, uv1.y);
+			}
+			SDL_FPoint corners[4];
+			RectCorners(r, &dst, 1, corners);
+			const SDL_FPoint uvs[4] = { uv0, { uv1.x, uv0.y }, uv1, { uv0.x, uv1.y } };
+			int first = (int)m_vertices.size();
+			for (int i = 0; i < 4; i++) {
+				SDL_Vertex v;
+				v.position = corners[i];
+				v.color = mod; //Vertex colors modulate the texture like SDL_SetTextureColorMod()
+				v.tex_coord = uvs[i];
+				m_vertices.push_back(v);
+			}
+			const int order[6] = { 0, 1, 2, 0, 2, 3 };
+			for (int i : order) {
+				m_indices.push_back(first + i);
+			}
+		}
+		//Texture coordinates of a source rectangle, or the whole texture
+		static void m_uv(SDL_Texture *texture, const SDL_Rect *src, SDL_FPoint &uv0, SDL_FPoint &uv1) {
+			uv0 = SDL_FPoint{ 0.f, 0.f };
+			uv1 = SDL_FPoint{ 1.f, 1.f };
+			int w = 0, h = 0;
+			if (src != nullptr && SDL_QueryTexture(texture, nullptr, nullptr, &w, &h) == 0 && w > 0 && h > 0) {
+				uv0 = SDL_FPoint{ (float)src->x / w, (float)src->y / h };
+				uv1 = SDL_FPoint{ (float)(src->x + src->w) / w, (float)(src->y + src->h) / h };
+			}
+		}
+		//Draw the queued quads
+		void m_flush(SDL_Renderer *renderer, SDL_Texture *texture) {
+			if (!m_indices.empty()) {
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+				renderBackend::get(renderer)->geometry(texture, m_vertices.data(), (int)m_vertices.size(), m_indices.data(), (int)m_indices.size());
+#endif
+				m_vertices.clear();
+				m_indices.clear();
+			}
+		}
+	public:
+		SDL_Rect *srcrect = nullptr; //!<Rectangle of the slot texture to draw
+
+		/**
+		 *	\brief Construct an itemGrid
+		 *
+		 *	\param *slotTexture The texture drawn behind every slot.
+		 *	\param dstrect The rectangle to draw the grid in; each slot gets an equal part of it.
+		 *	\param columns Number of slots across.
+		 *	\param rows Number of slots down.
+		 *	\param func Function which will return if an item is valid for a slot or not.
+		 *	\param angle The angle the grid will be at.
+		 */
+		itemGrid(SDL_Texture *slotTexture, const SDL_FRect dstrect, int columns, int rows, slotAcceptFunction func = nullptr, const double angle = 0) {
+			dropRegistry<T>::global().add(this, this);
+			m_columns = std::max(columns, 1);
+			m_rows = std::max(rows, 1);
+			m_slots.assign((size_t)m_columns * m_rows, nullptr);
+			m_hoveredSlot = m_slots.size();
+			setSlotTexture(slotTexture);
+			setAcceptFunction(func);
+			setDstrect(dstrect);
+			setAngle(angle);
+		}
+		/**
+		 *	\brief Deconstruct itemGrid
+		 *
+		 *	\note Held items are let go of, but not put back into any set.
+		 */
+		~itemGrid() {
+			for (item<T> *held : m_slots) {
+				if (held != nullptr) {
+					held->m_container = nullptr;
+				}
+			}
+		}
+
+		void render(SDL_Renderer *renderer) {
+			SDL_FRect dstrect = m_renderDstrect();
+			float slotW = m_dstrect.w / m_columns, slotH = m_dstrect.h / m_rows;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+			SDL_FPoint uv0, uv1;
+			//Every slot background in one call
+			if (m_slotTexture != nullptr) {
+				m_uv(m_slotTexture, srcrect, uv0, uv1);
+				for (int row = 0; row < m_rows; row++) {
+					for (int column = 0; column < m_columns; column++) {
+						SDL_FPoint corner = m_rotation.apply({ dstrect.x + column * slotW, dstrect.y + row * slotH }, { dstrect.x, dstrect.y });
+						m_pushQuad({ corner.x, corner.y, slotW, slotH }, m_rotation, uv0, uv1, m_flip, m_mod);
+					}
+				}
+				m_flush(renderer, m_slotTexture);
+			}
+			//Held items, in one call per run of items sharing a texture
+			SDL_Texture *batchTexture = nullptr;
+			for (item<T> *held : m_slots) {
+				if (held == nullptr || held->getTexture() == nullptr) {
+					continue;
+				}
+				if (held->getTexture() != batchTexture) {
+					m_flush(renderer, batchTexture);
+					batchTexture = held->getTexture();
+				}
+				m_uv(batchTexture, held->srcrect, uv0, uv1);
+				m_pushQuad(m_offsetRect(held->getDstrect()), held->getRotation(), uv0, uv1, held->getFlip(), held->getColorMod());
+			}
+			m_flush(renderer, batchTexture);
+#else
+			for (size_t slot = 0; slot < m_slots.size(); slot++) {
+				SDL_FPoint corner = m_rotation.apply({ dstrect.x + (slot % m_columns) * slotW, dstrect.y + (slot / m_columns) * slotH }, { dstrect.x, dstrect.y });
+				SDL_FRect slotRect = { corner.x, corner.y, slotW, slotH };
+				m_applyMod(m_slotTexture);
+				renderBackend::get(renderer)->copy(m_slotTexture, srcrect, &slotRect, m_angle, &zeroFPoint, m_flip);
+				m_clearMod(m_slotTexture);
+			}
+			for (item<T> *held : m_slots) {
+				if (held != nullptr) {
+					held->render(renderer);
+				}
+			}
+#endif
+		}
+		void userLogic(std::vector<SDL_Event> &events, SDL_Renderer *renderer) {
+			element::userLogic(events, renderer);
+			for (SDL_Event &e : events) {
+				if (m_hasFocus && e.type == SDL_MOUSEBUTTONDOWN && e.button.button == SDL_BUTTON_LEFT && m_parentSet != nullptr) {
+					//Hand the item under the cursor back to our set and let it be dragged from there
+					size_t slot = slotAt(SDL_Point{ e.button.x, e.button.y });
+					if (slot < m_slots.size() && m_slots[slot] != nullptr) {
+						item<T> *held = m_slots[slot];
+						if (m_acceptFunction == nullptr || m_acceptFunction(this, slot, nullptr)) {
+							m_clearSlot(slot);
+							m_parentSet->addElement(held);
+							held->pickup();
+							held->m_grabPoint = held->m_cursorPoint = SDL_FPoint{ (float)e.button.x, (float)e.button.y };
+						}
+					}
+				}
+			}
+		}
+		using element::resetUserLogic;
+		using element::loopLogic;
+		using element::resetLoopLogic;
+		using element::bind;
+		using element::unbind;
+
+		using element::setSet;
+		using element::setFocus;
+		void setDstrect(SDL_FRect dr) {
+			element::setDstrect(dr);
+			dropRegistry<T>::global().update(this);
+			for (size_t slot = 0; slot < m_slots.size(); slot++) {
+				if (m_slots[slot] != nullptr) {
+					m_placeItem(slot);
+				}
+			}
+		}
+		using element::getDstrect;
+		void setAngle(double a) {
+			element::setAngle(a);
+			dropRegistry<T>::global().update(this);
+			for (size_t slot = 0; slot < m_slots.size(); slot++) {
+				if (m_slots[slot] != nullptr) {
+					m_placeItem(slot);
+				}
+			}
+		}
+		using element::getAngle;
+		/**
+		 *	\brief Sets the texture drawn behind every slot
+		 *
+		 *	\param *texture The texture for the slots to use
+		 */
+		void setSlotTexture(SDL_Texture *texture) {
+			m_slotTexture = texture;
+			invalidate();
+		}
+		/**
+		 *	\brief Gets the texture drawn behind every slot
+		 */
+		SDL_Texture* getSlotTexture() {
+			return m_slotTexture;
+		}
+		/**
+		 *	\brief Sets the function to check if an item is valid for a slot
+		 *
+		 *	\param func Function which is given the grid, the slot, and the item.
+		 *
+		 *	\note This function will also be called, with a nullptr item, to check if a slot's item can be removed.
+		 */
+		void setAcceptFunction(slotAcceptFunction func) {
+			m_acceptFunction = func;
+		}
+
+		/**
+		 *	\brief Gets the number of slots across
+		 */
+		int getColumns() {
+			return m_columns;
+		}
+		/**
+		 *	\brief Gets the number of slots down
+		 */
+		int getRows() {
+			return m_rows;
+		}
+		/**
+		 *	\brief Gets the number of slots
+		 */
+		size_t getSlotCount() {
+			return m_slots.size();
+		}
+		/**
+		 *	\brief Find the slot under a point
+		 *
+		 *	\param point Point in the coordinates of the grid's set.
+		 *
+		 *	\returns The slot, or getSlotCount() if the point is outside of the grid
+		 */
+		size_t slotAt(SDL_Point point) {
+			SDL_FPoint local = m_rotation.applyInverse({ (float)point.x, (float)point.y }, { m_dstrect.x, m_dstrect.y });
+			float x = (local.x - m_dstrect.x) / (m_dstrect.w / m_columns), y = (local.y - m_dstrect.y) / (m_dstrect.h / m_rows);
+			if (!(x >= 0.f && y >= 0.f && x < m_columns && y < m_rows)) { //Also catches a grid with no size
+				return m_slots.size();
+			}
+			return (size_t)y * m_columns + (size_t)x;
+		}
+		/**
+		 *	\brief Gets the rectangle a slot covers, before the grid's rotation
+		 *
+		 *	\param slot The slot.
+		 *
+		 *	\returns The slot's rectangle in the coordinates of the grid's set, as if the grid had no angle
+		 */
+		SDL_FRect getSlotRect(size_t slot) {
+			float slotW = m_dstrect.w / m_columns, slotH = m_dstrect.h / m_rows;
+			return SDL_FRect{ m_dstrect.x + (slot % m_columns) * slotW, m_dstrect.y + (slot / m_columns) * slotH, slotW, slotH };
+		}
+		/**
+		 *	\brief Attempts to set the item in a slot
+		 *
+		 *	An item can be placed in an empty slot, and a full slot can be emptied with nullptr,
+		 *	if the accept function allows it. A placed item is taken out of its set and drawn by
+		 *	the grid until it is picked up again.
+		 *
+		 *	\param slot The slot.
+		 *	\param *child Item to place, or nullptr to empty the slot.
+		 *
+		 *	\returns true if the slot was changed
+		 */
+		bool setSlot(size_t slot, item<T> *child) {
+			if (slot >= m_slots.size() || (m_slots[slot] == nullptr) == (child == nullptr)) {
+				return false;
+			}
+			if (m_acceptFunction != nullptr && !m_acceptFunction(this, slot, child)) {
+				return false;
+			}
+			if (child == nullptr) {
+				m_clearSlot(slot);
+				return true;
+			}
+			if (child->m_container != nullptr && !child->m_container->m_take(child, false)) { //Held somewhere else which won't let go
+				return false;
+			}
+			if (child->getSet() != nullptr) {
+				child->getSet()->removeElement(child);
+			}
+			m_slots[slot] = child;
+			child->m_container = this;
+			child->m_containerSlot = slot;
+			child->m_holder = nullptr;
+			m_placeItem(slot);
+			m_lastChangedSlot = slot;
+			invalidate();
+			m_callEventFunction(Event::ValueChanged);
+			return true;
+		}
+		/**
+		 *	\brief Gets the item in a slot
+		 *
+		 *	\returns The item, or nullptr if the slot is empty or does not exist
+		 */
+		item<T>* getSlot(size_t slot) {
+			return slot < m_slots.size() ? m_slots[slot] : nullptr;
+		}
+		/**
+		 *	\brief Gets the value of the item in a slot
+		 *
+		 *	\returns The item's value if present, otherwise the default value for type T
+		 */
+		T getSlotValue(size_t slot) {
+			return getSlot(slot) != nullptr ? m_slots[slot]->value : T();
+		}
+		/**
+		 *	\brief Gets the slot changed by the last ValueChanged event
+		 */
+		size_t getLastChangedSlot() {
+			return m_lastChangedSlot;
+		}
+		/**
+		 *	\brief Gets the slot a dragged item is over
+		 *
+		 *	\returns The slot, or getSlotCount() if no item is being dragged over the grid
+		 *	\sa getHoveringItem
+		 */
+		size_t getHoveredSlot() {
+			return m_hoveredSlot;
+		}
+		using dropTarget<T>::getHoveringItem;
+
+		using element::pointInElement;
+	};
+};
@@ -6,7 +6,8 @@ extern "C" {
 #include <SDL2/SDL.h>
 }
 #include <vector>
-#include "./extra.hpp" //RotatePoint
+#include "./extra.hpp" //rotation
+#include "./dropRegistry.hpp"
 
 namespace lui {
 	template<typename T>
@@ -19,7 +20,8 @@ namespace lui {
 	 *	\see hui::itemHolder#setAcceptFunction
 	 */
 	template<typename T>
-	class itemHolder : public element {
+	class itemHolder : public element, public dropTarget<T> {
+		friend class item<T>;
 	public:
 		/**
 		*	\brief The function type used to check if an item is valid
@@ -30,6 +32,38 @@ namespace lui {
 		item<T> *m_childItem = nullptr; //!<Item currently held by the itemHolder
 
 		itemAcceptFunction m_acceptFunction = nullptr; //!<Function to determine if an item is valid for the itemHolder
+		using dropTarget<T>::m_hoveringItem;
+
+		void m_dragOver(item<T> *dragged, SDL_FPoint /*local*/) {
+			if (dragged != m_hoveringItem) {
+				if (m_hoveringItem != nullptr) {
+					m_callEventFunction(Event::DragLeft);
+				}
+				if (dragged != nullptr) {
+					m_callEventFunction(Event::DragEntered);
+				}
+				invalidate();
+			}
+		}
+		bool m_drop(item<T> *dropped, SDL_FPoint /*local*/) {
+			return setChild(dropped);
+		}
+		bool m_take(item<T> *taken, bool force) {
+			if (taken != m_childItem) {
+				return true;
+			}
+			if (setChild((item<T>*)nullptr)) {
+				return true;
+			}
+			if (force) { //Refused by the accept function
+				m_childItem = nullptr;
+				taken->m_holder = nullptr;
+				taken->m_container = nullptr;
+				m_callEventFunction(Event::ValueChanged);
+				return true;
+			}
+			return false;
+		}
 	public:
 		SDL_Rect *srcrect = nullptr; //!<Rectangle of the texture to draw
 
@@ -40,6 +74,7 @@ namespace lui {
 		 *	\param *func The function which will return if an item is valid or not.
 		 */
 		itemHolder(SDL_Texture *texture, bool(*func)(itemHolder<T>*, item<T>*) = nullptr) {
+			dropRegistry<T>::global().add(this, this);
 			setTexture(texture);
 			setAcceptFunction(func);
 		}
@@ -53,6 +88,7 @@ namespace lui {
 		 *	\param *func The function which will return if an item is valid or not.
 		 */
 		itemHolder(SDL_Texture *texture, const SDL_FRect dstrect, const double angle = 0, const SDL_RendererFlip flip = SDL_FLIP_NONE, bool(*func)(itemHolder<T>*, item<T>*) = nullptr) {
+			dropRegistry<T>::global().add(this, this);
 			setDstrect(dstrect);
 			setAngle(angle);
 			setFlip(flip);
@@ -62,10 +98,18 @@ namespace lui {
 		/**
 		 *	\brief Deconsturct itemHolder
 		 */
-		~itemHolder() {}
+		~itemHolder() {
+			if (m_childItem != nullptr) { //So the item does not reach back into us when destroyed or picked up
+				m_childItem->m_holder = nullptr;
+				m_childItem->m_container = nullptr;
+			}
+		}
 		
 		void render(SDL_Renderer *renderer) {
-			SDL_RenderCopyExF(renderer, m_texture, srcrect, &m_dstrect, m_angle, &zeroFPoint, m_flip);
+			SDL_FRect dstrect = m_renderDstrect();
+			m_applyMod(m_texture);
+			renderBackend::get(renderer)->copy(m_texture, srcrect, &dstrect, m_angle, &zeroFPoint, m_flip);
+			m_clearMod(m_texture);
 		}
 		using element::userLogic;
 		using element::resetUserLogic;
@@ -91,11 +135,13 @@ namespace lui {
 		using element::setFocus;
 		void setDstrect(SDL_FRect dr) {
 			element::setDstrect(dr);
+			dropRegistry<T>::global().update(this);
 			centerChild();
 		}
 		using element::getDstrect;
 		void setAngle(double a) {
 			element::setAngle(a);
+			dropRegistry<T>::global().update(this);
 			centerChild();
 		}
 		using element::getAngle;
@@ -127,10 +173,22 @@ namespace lui {
 			if (std::is_same<T, U>::value) { //If they are not of same type, they can not (will not) be compared.
 				if (m_acceptFunction == nullptr || m_acceptFunction != nullptr && m_acceptFunction(this, child)) { //If there is no accept function, all are welcome.
 					if ((m_childItem == nullptr) != (child == nullptr)) {
+						if (child != nullptr && child->m_container != nullptr && !child->m_container->m_take(child, false)) { //Held somewhere else which won't let go
+							return false;
+						}
+						item<T> *previous = m_childItem;
 						m_childItem = child;
 						if (child != nullptr) { //No current child, and a valid child
 							centerChild();
 							m_childItem->m_holder = this;
+							m_childItem->m_container = this;
+							if (m_childItem->getSet() == nullptr && m_parentSet != nullptr) { //Taken from an itemGrid, which draws its items itself
+								m_parentSet->addElement(m_childItem);
+							}
+						}
+						else { //Let the previous child know it is free
+							previous->m_holder = nullptr;
+							previous->m_container = nullptr;
 						}
 						m_callEventFunction(Event::ValueChanged);
 						return true;
@@ -147,6 +205,19 @@ namespace lui {
 		item<T>* getChild() {
 			return m_childItem;
 		}
+		using dropTarget<T>::getHoveringItem;
+		/**
+		 *	\brief Would an item be accepted if it were dropped now
+		 *
+		 *	Useful to preview a drop, such as by highlighting the itemHolder on DragEntered.
+		 *
+		 *	\param *child Item to check.
+		 *
+		 *	\returns true if setChild() would accept the item
+		 */
+		bool canAccept(item<T> *child) {
+			return child != nullptr && m_childItem == nullptr && (m_acceptFunction == nullptr || m_acceptFunction(this, child));
+		}
 		/**
 		 *	\brief Gets the value of the child item
 		 *
@@ -167,12 +238,14 @@ namespace lui {
 				nominalPosition.x = m_dstrect.x + (m_dstrect.w - childDstrect.w) / 2.f;
 				nominalPosition.y = m_dstrect.y + (m_dstrect.h - childDstrect.h) / 2.f;
 
-				SDL_FPoint upperLeft = RotatePoint(nominalPosition, m_angle, { m_dstrect.x, m_dstrect.y });
+				SDL_FPoint upperLeft = m_rotation.apply(nominalPosition, { m_dstrect.x, m_dstrect.y });
 				
 				childDstrect.x = upperLeft.x;
 				childDstrect.y = upperLeft.y;
+				m_childItem->beginUpdate(); //Moved and turned as one change
 				m_childItem->setDstrect(childDstrect);
 				m_childItem->setAngle(m_angle);
+				m_childItem->endUpdate();
 			}
 		}
 
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "./element.hpp"
+
+extern "C" {
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+}
+#include <vector>
+#include <string>
+
+namespace lui {
+	/**
+	 *	\brief A static line of text
+	 *
+	 *	The text is measured and rasterized through the process-wide textCache,
+	 *	so any number of labels showing the same string share one texture.
+	 *
+	 *	\note The text is drawn at its natural size from the upper-left corner of the
+	 *	dstrect and is clipped to the dstrect. A dstrect with no size shows all of it.
+	 *	\note All strings used in this class are formatted with UTF-8.
+	 *
+	 *	\sa lui::textCache
+	 */
+	class label : public element {
+	protected:
+		TTF_Font *m_font = nullptr; //!<Font being used
+		std::string m_text = ""; //!<The text shown
+		size_t m_textHash = 0; //!<Hash of m_text, so lookups don't rehash it every render
+		SDL_Color m_color = { 255, 255, 255, 255 }; //!<Color of the text
+	public:
+		/**
+		 *	\brief Construct a label with a font and text
+		 *
+		 *	\param *font The font of the text.
+		 *	\param text The UTF-8 text to show.
+		 */
+		label(TTF_Font *font, const std::string &text = "");
+		/**
+		 *	\brief Construct a label with a font, text, position, size, angle, and flip
+		 *
+		 *	\param *font The font of the text.
+		 *	\param text The UTF-8 text to show.
+		 *	\param dstrect The rectangle to draw the label in.
+		 *	\param angle The angle the label will be at.
+		 *	\param flip The flip the label will have.
+		 */
+		label(TTF_Font *font, const std::string &text, const SDL_FRect dstrect, const double angle = 0, const SDL_RendererFlip flip = SDL_FLIP_NONE);
+		/**
+		 *	\brief Deconstruct label
+		 */
+		~label();
+
+		void render(SDL_Renderer *renderer);
+		using element::userLogic;
+		using element::resetUserLogic;
+		using element::loopLogic;
+		using element::resetLoopLogic;
+		using element::bind;
+		using element::unbind;
+
+		using element::setFocus;
+		using element::setDstrect;
+		using element::getDstrect;
+		using element::setAngle;
+		using element::getAngle;
+		/**
+		 *	\brief Set the text to show
+		 *
+		 *	\param text UTF-8 string to show.
+		 */
+		void setText(const std::string &text);
+		/**
+		 *	\brief Get the text being shown
+		 *
+		 *	\return The text of the label.
+		 */
+		std::string getText();
+		/**
+		 *	\brief Set the font to use for rendering
+		 *
+		 *	\param *font The font to be used.
+		 */
+		void setFont(TTF_Font *font);
+		/**
+		 *	\brief Get the current font
+		 *
+		 *	\return The font currently being used.
+		 */
+		TTF_Font* getFont();
+		/**
+		 *	\brief Set the color of the text
+		 *
+		 *	\param clr Color to use.
+		 */
+		void setColor(SDL_Color clr);
+		/**
+		 *	\brief Get the color of the text
+		 *
+		 *	\return The color of the text.
+		 */
+		SDL_Color getColor();
+		/**
+		 *	\brief Get the natural size of the text
+		 *
+		 *	\return Width (x) and height (y) of the text, in pixels.
+		 */
+		SDL_Point getTextSize();
+		/**
+		 *	\brief Resize the dstrect to the natural size of the text
+		 */
+		void fitToText();
+
+		using element::pointInElement;
+	};
+};
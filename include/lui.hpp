@@ -11,11 +11,23 @@
 
 #include "./element.hpp"
 #include "./set.hpp"
+#include "./alphaMaskCache.hpp"
+#include "./animator.hpp"
 #include "./button.hpp"
+#include "./displayList.hpp"
+#include "./dragWatch.hpp"
+#include "./dropRegistry.hpp"
 #include "./item.hpp"
 #include "./itemHolder.hpp"
+#include "./itemGrid.hpp"
+#include "./label.hpp"
+#include "./renderBackend.hpp"
 #include "./scrollBar.hpp"
+#include "./searchIndex.hpp"
+#include "./surfaceBackend.hpp"
 #include "./textField.hpp"
+#include "./textCache.hpp"
+#include "./utf8.hpp"
 
 #include "./extra.hpp"
 
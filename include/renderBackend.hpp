@@ -0,0 +1,212 @@
+#pragma once
+
+extern "C" {
+#include <SDL2/SDL.h>
+}
+
+namespace lui {
+	/**
+	 *	\brief Where elements draw, for one SDL_Renderer
+	 *
+	 *	Every render() path draws through the backend of the renderer it is given, found with
+	 *	get(), rather than calling SDL_Renderer functions itself. Renderers with no backend of
+	 *	their own get an sdlBackend, which calls SDL as before. Attaching a backend to a
+	 *	renderer replaces whatever backend it had, so drawing can be sent elsewhere, such as
+	 *	into an SDL_Surface with surfaceBackend, without changing any element.
+	 *
+	 *	Textures the library makes are made through the backend too, so backends can keep
+	 *	their own copy of them. Texture color, alpha, and blend modes are still set on the
+	 *	SDL_Texture with SDL, and backends read them from it.
+	 *
+	 *	\code
+	 *	lui::renderBackend *backend = lui::renderBackend::get(renderer);
+	 *	backend->copy(texture, nullptr, &dstrect, angle, &center, SDL_FLIP_NONE);
+	 *	\endcode
+	 *
+	 *	\sa sdlBackend, surfaceBackend
+	 */
+	class renderBackend {
+	private:
+		SDL_Renderer *m_renderer = nullptr;
+	protected:
+		/**
+		 *	\brief Construct a backend for a renderer
+		 *
+		 *	\param *renderer The renderer whose drawing goes through this backend once attached.
+		 */
+		renderBackend(SDL_Renderer *renderer);
+		/**
+		 *	\brief Called when any texture is destroyed through destroyTexture(), so copies kept of it can be freed
+		 */
+		virtual void m_forgetTexture(SDL_Texture *texture);
+	public:
+		/**
+		 *	\brief Deconstruct the backend, and stop using it for its renderer
+		 *
+		 *	\note Backends with a destructor of their own call detach() first in it, so no thread reaches a half destroyed backend.
+		 */
+		virtual ~renderBackend();
+
+		/**
+		 *	\brief Make this the backend used for its renderer, replacing whatever backend it had
+		 *
+		 *	Not done by the constructor, so other threads calling get() never reach a backend
+		 *	which is not fully constructed.
+		 */
+		void attach();
+		/**
+		 *	\brief Stop using this backend for its renderer, if it is the one used
+		 */
+		void detach();
+
+		/**
+		 *	\brief Get the backend of a renderer
+		 *
+		 *	\param *renderer The renderer.
+		 *
+		 *	\returns The backend attached to the renderer last, or an sdlBackend made for it the first time it is asked for
+		 *
+		 *	\note The last renderer asked for on each thread is remembered, so this is cheap to call for every draw.
+		 */
+		static renderBackend* get(SDL_Renderer *renderer);
+		/**
+		 *	\brief Free the sdlBackend made for a renderer, if get() made one
+		 *
+		 *	\note Call this before destroying a renderer which may be created again at the same address.
+		 */
+		static void clearRenderer(SDL_Renderer *renderer);
+		/**
+		 *	\brief Destroy a texture, letting every backend free what it kept of it, and forgetting its alpha mask
+		 *
+		 *	\param *texture The texture, which may be nullptr.
+		 */
+		static void destroyTexture(SDL_Texture *texture);
+
+		/**
+		 *	\brief Get the renderer this backend draws for
+		 */
+		SDL_Renderer* getRenderer();
+
+		/**
+		 *	\brief Create a texture, the same as SDL_CreateTexture()
+		 */
+		virtual SDL_Texture* createTexture(Uint32 format, int access, int w, int h) = 0;
+		/**
+		 *	\brief Create a texture from a surface, the same as SDL_CreateTextureFromSurface()
+		 */
+		virtual SDL_Texture* createTextureFromSurface(SDL_Surface *surface) = 0;
+		/**
+		 *	\brief Replace pixels of a texture, the same as SDL_UpdateTexture()
+		 */
+		virtual int updateTexture(SDL_Texture *texture, const SDL_Rect *rect, const void *pixels, int pitch) = 0;
+		/**
+		 *	\brief Draw into a texture, or nullptr for the default target, the same as SDL_SetRenderTarget()
+		 */
+		virtual int setTarget(SDL_Texture *texture) = 0;
+		/**
+		 *	\brief Get the texture being drawn into, or nullptr for the default target
+		 */
+		virtual SDL_Texture* getTarget() = 0;
+		/**
+		 *	\brief Get the size, in pixels, of the texture being drawn into, or of the default target
+		 */
+		virtual int getOutputSize(int *w, int *h) = 0;
+		/**
+		 *	\brief Clip drawing to a rectangle of the target, or nullptr to stop clipping, the same as SDL_RenderSetClipRect()
+		 */
+		virtual int setClipRect(const SDL_Rect *rect) = 0;
+		/**
+		 *	\brief Get the rectangle drawing is clipped to
+		 *
+		 *	\param *rect Filled with the clip rectangle, or an empty rectangle if not clipping.
+		 *
+		 *	\returns true if clipping
+		 */
+		virtual bool getClipRect(SDL_Rect *rect) = 0;
+		/**
+		 *	\brief Set the color used by clear(), fillRect(), drawRect(), and drawLines()
+		 */
+		virtual int setDrawColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a) = 0;
+		/**
+		 *	\brief Get the color used by clear(), fillRect(), drawRect(), and drawLines()
+		 */
+		virtual int getDrawColor(Uint8 *r, Uint8 *g, Uint8 *b, Uint8 *a) = 0;
+		/**
+		 *	\brief Set how fillRect(), drawRect(), drawLines(), and untextured geometry() blend, the same as SDL_SetRenderDrawBlendMode()
+		 */
+		virtual int setDrawBlendMode(SDL_BlendMode mode) = 0;
+		/**
+		 *	\brief Get how fillRect(), drawRect(), drawLines(), and untextured geometry() blend
+		 */
+		virtual int getDrawBlendMode(SDL_BlendMode *mode) = 0;
+		/**
+		 *	\brief Fill the whole target with the draw color, the same as SDL_RenderClear()
+		 */
+		virtual int clear() = 0;
+		/**
+		 *	\brief Fill a rectangle with the draw color, the same as SDL_RenderFillRectF()
+		 */
+		virtual int fillRect(const SDL_FRect *rect) = 0;
+		/**
+		 *	\brief Outline a rectangle with the draw color, the same as SDL_RenderDrawRectF()
+		 */
+		virtual int drawRect(const SDL_FRect *rect) = 0;
+		/**
+		 *	\brief Draw connected lines with the draw color, the same as SDL_RenderDrawLinesF()
+		 */
+		virtual int drawLines(const SDL_FPoint *points, int count) = 0;
+		/**
+		 *	\brief Copy part of a texture, the same as SDL_RenderCopyExF()
+		 *
+		 *	\param *texture The texture.
+		 *	\param *srcrect Part of the texture to draw, or nullptr for all of it.
+		 *	\param *dstrect Where to draw it, or nullptr for the whole target.
+		 *	\param angle Degrees to turn it clockwise.
+		 *	\param *center Point to turn around, relative to dstrect, or nullptr for its center.
+		 *	\param flip How to flip it.
+		 */
+		virtual int copy(SDL_Texture *texture, const SDL_Rect *srcrect, const SDL_FRect *dstrect, double angle = 0, const SDL_FPoint *center = nullptr, SDL_RendererFlip flip = SDL_FLIP_NONE) = 0;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+		/**
+		 *	\brief Draw triangles, the same as SDL_RenderGeometry()
+		 */
+		virtual int geometry(SDL_Texture *texture, const SDL_Vertex *vertices, int numVertices, const int *indices, int numIndices) = 0;
+#endif
+	};
+
+	/**
+	 *	\brief Backend drawing with the SDL_Renderer itself
+	 *
+	 *	Used for every renderer which has no other backend.
+	 */
+	class sdlBackend : public renderBackend {
+	public:
+		/**
+		 *	\brief Construct a backend calling SDL for a renderer
+		 *
+		 *	\param *renderer The renderer.
+		 */
+		sdlBackend(SDL_Renderer *renderer);
+
+		SDL_Texture* createTexture(Uint32 format, int access, int w, int h);
+		SDL_Texture* createTextureFromSurface(SDL_Surface *surface);
+		int updateTexture(SDL_Texture *texture, const SDL_Rect *rect, const void *pixels, int pitch);
+		int setTarget(SDL_Texture *texture);
+		SDL_Texture* getTarget();
+		int getOutputSize(int *w, int *h);
+		int setClipRect(const SDL_Rect *rect);
+		bool getClipRect(SDL_Rect *rect);
+		int setDrawColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+		int getDrawColor(Uint8 *r, Uint8 *g, Uint8 *b, Uint8 *a);
+		int setDrawBlendMode(SDL_BlendMode mode);
+		int getDrawBlendMode(SDL_BlendMode *mode);
+		int clear();
+		int fillRect(const SDL_FRect *rect);
+		int drawRect(const SDL_FRect *rect);
+		int drawLines(const SDL_FPoint *points, int count);
+		int copy(SDL_Texture *texture, const SDL_Rect *srcrect, const SDL_FRect *dstrect, double angle = 0, const SDL_FPoint *center = nullptr, SDL_RendererFlip flip = SDL_FLIP_NONE);
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+		int geometry(SDL_Texture *texture, const SDL_Vertex *vertices, int numVertices, const int *indices, int numIndices);
+#endif
+	};
+};
@@ -7,6 +7,8 @@ extern "C" {
 }
 
 namespace lui {
+	class set;
+
 	/**
 	 *	\brief A scroll bar with 2D functionality
 	 *
@@ -16,9 +18,13 @@ namespace lui {
 	 *
 	 *	\note The grip will never be larger than the track
 	 *
+	 *	A scroll bar attached to a set with attachSet() sizes its grip to how much of the
+	 *	set's content is shown, and scrolls the set as the grip moves.
+	 *
 	 *	\sa hui::set
 	 */
 	class scrollBar : public element {
+		friend class set; //Sets detach their scroll bars when destroyed
 	protected:
 		SDL_Texture *m_textureTrack = nullptr; //!<The texture of the track
 		SDL_Texture *m_textureGrip = nullptr; //!<The texture of the grip
@@ -26,6 +32,29 @@ namespace lui {
 		bool m_gripMoving = 0; //!<Is the grip being dragged by user
 		SDL_FRect m_dstrectGrip; //!<Rectangle to draw the grip in
 		SDL_FPoint m_gripPos = {0.f, 0.f}; //!<The position of the grip and all attached scrollWindows
+		SDL_FPoint m_gripGrabPos = { 0.f, 0.f }; //!<Grip position when dragging started, used by the drag watch
+		SDL_FPoint m_grabPoint = { 0.f, 0.f }; //!<Cursor position in the parent set when dragging started, used by the drag watch
+
+		/**
+		 *	\brief Move the grip by how far the cursor has moved since dragging started
+		 *
+		 *	\param windowPoint Cursor position in window coordinates.
+		 */
+		void m_dragGripTo(SDL_FPoint windowPoint);
+
+		set *m_attachedSet = nullptr; //!<Set scrolled by the grip
+		Uint32 m_attachedGeneration = 0; //!<set::getContentGeneration() of m_attachedSet when last synced
+		/**
+		 *	\brief Resize and move the grip to match the attached set, if it changed since last time
+		 */
+		void m_syncAttached();
+		/**
+		 *	\brief Get the area which can be scrolled over in the attached set, and how far it can be scrolled
+		 *
+		 *	\param &area Set to the content bounds, grown to include the origin and the set's size.
+		 *	\param &range Set to how far the set can be scrolled in each axis.
+		 */
+		void m_attachedArea(SDL_FRect &area, SDL_FPoint &range);
 
 		/**
 		 *	\brief Array of all event function pointers
@@ -86,7 +115,7 @@ namespace lui {
 		void render(SDL_Renderer *renderer);
 		void userLogic(std::vector<SDL_Event> &events, SDL_Renderer *renderer);
 		void resetUserLogic();
-		using element::loopLogic;
+		void loopLogic(Uint32 ms);
 		using element::resetLoopLogic;
 		/**
 		 *	\brief Bind a function to a specific event
@@ -169,6 +198,27 @@ namespace lui {
 		 *	\note Position is given as % between min and max position
 		 */
 		SDL_FPoint getGripPosition();
+		/**
+		 *	\brief Scroll a set with the grip
+		 *
+		 *	The grip is sized to the part of the set's content bounds shown within its dstrect,
+		 *	and moving the grip sets the set's render corner. Both are kept in sync as the content,
+		 *	the set's size, or its scrolling changes, at the cost of one check each frame when
+		 *	nothing did.
+		 *
+		 *	\param *s The set to scroll, or nullptr to detach.
+		 *
+		 *	\note The set must have a size for it to be scrolled.
+		 *
+		 *	\sa set::getContentBounds()
+		 */
+		void attachSet(set *s);
+		/**
+		 *	\brief Get the set scrolled by the grip
+		 *
+		 *	\returns The set, or nullptr if none is attached
+		 */
+		set* getAttachedSet();
 
 		using element::pointInElement;
 		/**
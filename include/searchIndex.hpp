@@ -0,0 +1,130 @@
+#pragma once
+
+#include "./element.hpp"
+
+extern "C" {
+#include <SDL2/SDL.h>
+}
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace lui {
+	/**
+	 *	\brief Substring filter over a list of labels
+	 *
+	 *	Every label is broken into runs of 1, 2, and 3 bytes, and each run keeps a
+	 *	sorted list of the entries containing it. Queries of up to 3 bytes are answered
+	 *	straight from these lists; longer ones only check the entries sharing all of
+	 *	their trigrams. A query which extends the previous one only refines the
+	 *	previous results. Results of shorter queries are kept on a stack,
+	 *	so deleting characters from the end of the query costs nothing to recompute.
+	 *
+	 *	Entries may be paired with an element. Those elements are shown or hidden
+	 *	with element::setVisible() as they start or stop matching, which lets a
+	 *	set filter its children without removing or adding anything. Only the
+	 *	elements whose state changed are touched.
+	 *
+	 *	\code
+	 *	lui::searchIndex index;
+	 *	for (lui::button *b : buttons) {
+	 *		index.addEntry(nameOf(b), b);
+	 *	}
+	 *	field.bind(lui::ValueChanged, [&index](lui::element *e, SDL_Event*) {
+	 *		index.setQuery(static_cast<lui::textField*>(e)->getCommitedString());
+	 *	});
+	 *	\endcode
+	 *
+	 *	\note Matching is case-insensitive for ASCII letters only; other bytes must match exactly.
+	 *	\note The lists take roughly 12 bytes per byte of label.
+	 */
+	class searchIndex {
+	private:
+		std::string m_labels = ""; //All labels, lowercased and stored back to back
+		std::vector<Uint32> m_offsets = { 0 }; //Start of each label in m_labels, plus the end of the last one
+		std::vector<element*> m_elements; //Element paired with each entry, may be nullptr
+		std::unordered_map<Uint32, std::vector<Uint32>> m_postings; //Sorted entries containing each run of 1 to 3 bytes
+
+		std::string m_query = ""; //Lowercased current query
+		std::vector<Uint32> m_results; //Sorted entries matching m_query
+		std::vector<std::pair<std::string, std::vector<Uint32>>> m_history; //Queries which m_query extends, and their results
+
+		static std::string m_lower(const std::string &s);
+		static Uint32 m_gram(const char *p, size_t n); //Pack a run of 1 to 3 bytes into a key
+		bool m_contains(Uint32 id, const std::string &query);
+		//Intersect two sorted lists, probing the longer one when their lengths are far apart
+		static void m_intersect(const std::vector<Uint32> &a, const std::vector<Uint32> &b, std::vector<Uint32> &out);
+		//Entries from candidates which contain query, or from every entry if candidates is nullptr
+		void m_match(const std::string &query, const std::vector<Uint32> *candidates, std::vector<Uint32> &out);
+		//Make results current, showing and hiding the elements which changed; results is left holding the previous results
+		void m_swapResults(std::vector<Uint32> &results);
+	public:
+		/**
+		 *	\brief Construct an empty index
+		 */
+		searchIndex();
+		/**
+		 *	\brief Deconstruct index
+		 *
+		 *	\note Elements are left in whatever visibility they were last given.
+		 */
+		~searchIndex();
+
+		/**
+		 *	\brief Reserve memory for a number of entries
+		 *
+		 *	\param entries Number of entries expected.
+		 *	\param labelBytes Total length of their labels, if known.
+		 */
+		void reserve(size_t entries, size_t labelBytes = 0);
+		/**
+		 *	\brief Add an entry to the index
+		 *
+		 *	The new entry is checked against the current query right away.
+		 *
+		 *	\param label UTF-8 text to search in.
+		 *	\param *e Element to show and hide along with the entry, or nullptr.
+		 *
+		 *	\returns The id of the entry; ids count up from 0 in the order they are added
+		 */
+		size_t addEntry(const std::string &label, element *e = nullptr);
+		/**
+		 *	\brief Remove every entry and the query
+		 *
+		 *	\note Elements keep the visibility they were last given.
+		 */
+		void clear();
+		/**
+		 *	\brief Get the number of entries
+		 */
+		size_t size();
+
+		/**
+		 *	\brief Filter the entries by a substring
+		 *
+		 *	\param query Text each result must contain. An empty query matches everything.
+		 */
+		void setQuery(const std::string &query);
+		/**
+		 *	\brief Get the current query
+		 *
+		 *	\returns The query, lowercased
+		 */
+		std::string getQuery();
+		/**
+		 *	\brief Get the entries matching the current query
+		 *
+		 *	\returns Ids of the matching entries, in ascending order
+		 */
+		const std::vector<Uint32>& getResults();
+		/**
+		 *	\brief Get the element paired with an entry
+		 *
+		 *	\param id Id of the entry.
+		 *
+		 *	\returns The element, or nullptr if there is none
+		 */
+		element* getElement(size_t id);
+	};
+};
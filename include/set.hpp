@@ -1,6 +1,7 @@
 #pragma once
 
 #include "./element.hpp"
+#include "./displayList.hpp"
 
 extern "C" {
 #include <SDL2/SDL.h>
@@ -8,8 +9,14 @@ extern "C" {
 #include <array>
 #include <vector>
 #include <mutex>
+#include <atomic>
+#include <future>
+#include <unordered_map>
 
 namespace lui {
+	class scrollBar;
+	class animator;
+	class surfaceBackend;
 
 	/**
 	 *	\brief A collection visible elements
@@ -29,22 +36,120 @@ namespace lui {
 	 *	\sa hui::scrollBar
 	 */
 	class set : public element {
+		friend class element; //Elements hand us their held back notifications
+		friend class scrollBar; //Scroll bars attach themselves to m_scrollBars
 	private:
-		std::recursive_mutex m_elementsMutex; //Mutex for m_elements & m_focusedElements
+		std::recursive_mutex m_elementsMutex; //Mutex for m_elements, m_focusedElements & the content bounds
 			/**
 			 *	The two top-most elements under the cursor
 			 *	[0]: The top element. This element knows it is the top element.
 			 *	[1]: The 2nd-top element. This element does NOT know it's Z position.
 			 */
-			std::array<element*, 2> m_focusedElements;
+			std::array<element*, 2> m_focusedElements = {{ nullptr, nullptr }};
 			std::vector<element*> m_elements;
 
 		bool m_updateFocusElements = true; //Read, acted on, and set to false inside the `userLogic` function
+		SDL_Point m_focusPoint = { 0, 0 }; //Cursor position, in local coordinates, m_focusedElements were last found for
+		bool m_focusResolved = false; //m_focusPoint has been set
+		SDL_FRect m_contentBounds = { 0.f, 0.f, 0.f, 0.f }; //Bounding box of the children
+		bool m_contentStale = false; //A child on the edge of m_contentBounds moved or left, so it may need to shrink
+		std::atomic<Uint32> m_contentGeneration{ 0 }; //Bumped whenever the content, our size, or our scrolling changes
+		std::vector<scrollBar*> m_scrollBars; //Scroll bars attached to us
+		animator *m_animator = nullptr; //Created when first asked for
+		void m_contentChanged(const SDL_FRect *before, const SDL_FRect *after); //A child's bounding box changed, nullptr when added or removed
+		bool m_coalesceEvents = false; //Merge motion and wheel events before handing them to children
+		static std::atomic<Uint32> m_transformGeneration; //Bumped whenever any set moves, turns, scrolls, or any element changes set
+		static std::atomic<Uint32> m_everyTransformStamp; //m_transformGeneration when invalidateTransforms() was last called, as if every set moved
+		std::atomic<Uint32> m_transformStamp{ 0 }; //m_transformGeneration when we last moved, turned, scrolled, or changed set
+		std::atomic<Uint32> m_membershipStamp{ 0 }; //m_transformGeneration when an element last joined or left us
 
 		std::recursive_mutex m_textureMutex; //Mutex for m_texture and m_renderCorner
 			SDL_Texture *m_texture = nullptr; //Texture, used only when acting as a subset to another set
 			Uint8 m_r = 255, m_g = 255, m_b = 255, m_a = 0;
-			SDL_FPoint m_renderCorner; //Corner, in local coordinates, to use as origin when rendering
+			SDL_FPoint m_renderCorner = { 0.f, 0.f }; //Corner, in local coordinates, to use as origin when rendering
+			bool m_directRendering = true; //Draw straight onto the parent's target, clipped, when nothing needs m_texture
+			Uint32 m_regionFrame = 0; //Damage frame m_texture was last drawn in, so the rest of the frame's regions reuse it
+
+			/**
+			 *	A square of content, in local coordinates, cached in its own texture
+			 */
+			struct tile {
+				SDL_Texture *texture = nullptr;
+				bool dirty = true; //Content changed since it was drawn
+				Uint32 lastUsed = 0; //m_tileFrame when it was last on screen
+			};
+			bool m_tileCaching = false;
+			int m_tileSize = 256;
+			size_t m_maxTiles = 0; //0 to keep four times the tiles on screen
+			Uint32 m_tileFrame = 0;
+			std::unordered_map<Uint64, tile> m_tiles; //Key is the column in the upper 32 bits and the row in the lower
+			std::vector<SDL_Texture*> m_spareTiles; //Textures of evicted tiles, reused before creating new ones
+
+			bool m_threadedRendering = false;
+			SDL_Surface *m_workerSurface = nullptr; //The subtree is drawn here on a worker thread, then uploaded to m_texture
+			surfaceBackend *m_workerBackend = nullptr; //Draws into m_workerSurface
+			std::future<void> m_workerDone; //Valid from when the worker is started until its drawing is composited
+			std::vector<set*> m_threadedSets; //Threaded children, whose workers are started before any child is drawn; may hold sets since removed
+			set *m_threadedParent = nullptr; //Set whose m_threadedSets we are in
+
+			std::vector<element*> m_drawList; //Children left to draw after culling, front to back; scratch for m_renderChildren
+			std::vector<SDL_FRect> m_occluders; //Dstrects of the largest opaque children in front; scratch for m_renderChildren
+			bool m_retainedRendering = false;
+			displayList m_displayList; //Children recorded with occlusion culling, replayed until one changes
+			std::atomic<bool> m_displayListStale{ true }; //A child changed since m_displayList was recorded
+
+			bool m_damageRendering = false;
+			std::vector<SDL_Rect> m_damage; //Target pixels to draw again at the next render, merged into a few regions
+			bool m_damageEverything = true; //Draw the whole target again at the next render
+			std::vector<SDL_Rect> m_lastDamage; //Drawn again by the last render
+			std::vector<SDL_Rect> m_overlayDamage; //Where the overlay was drawn by the last render
+			/**
+			 *	How the set was placed when last drawn; a change means everything moved
+			 */
+			struct placement {
+				SDL_FRect dstrect;
+				SDL_FPoint renderCorner;
+				double angle;
+				SDL_RendererFlip flip;
+				SDL_Color mod;
+
+				bool operator==(const placement &o) const {
+					return dstrect.x == o.dstrect.x && dstrect.y == o.dstrect.y && dstrect.w == o.dstrect.w && dstrect.h == o.dstrect.h
+						&& renderCorner.x == o.renderCorner.x && renderCorner.y == o.renderCorner.y && angle == o.angle && flip == o.flip
+						&& mod.r == o.mod.r && mod.g == o.mod.g && mod.b == o.mod.b && mod.a == o.mod.a;
+				}
+			} m_damagePlacement = {};
+			void m_addDamage(const SDL_FRect &rect); //Damage the target pixels under rect, in local coordinates
+			void m_renderDamage(SDL_Renderer *renderer); //Draw again only what was damaged
+
+		void m_renderContent(SDL_Renderer *renderer); //Draw the children and the overlay, however the set draws them
+		bool m_rendersDirectly(); //Unrotated, unflipped, unmodulated, and not tile cached
+		void m_renderDirect(SDL_Renderer *renderer); //Draw the children onto the current target, clipped to our dstrect
+		void m_renderOffscreen(SDL_Renderer *renderer); //Draw the children into m_texture, and it onto the current target
+		void m_renderTexture(SDL_Renderer *renderer); //Draw m_texture as it is onto the current target
+		void m_cullChildren(const SDL_FRect *area); //Fill m_drawList with the visible children, skipping those outside area if not nullptr or behind opaque ones
+		void m_renderChildren(SDL_Renderer *renderer, const SDL_FRect *area); //Render or replay the children m_cullChildren() leaves
+		void m_renderTiles(SDL_Renderer *renderer); //Composite the tiles on screen onto the render target, drawing the dirty ones first
+		void m_joinThreadedParent(set *parent); //Move into parent's m_threadedSets, or out of any if nullptr
+		void m_startWorker(); //Start drawing the subtree on a worker, unless already started
+		void m_drawOnWorker();
+		void m_renderThreaded(SDL_Renderer *renderer); //Wait for the worker, upload its drawing, and composite it
+		void m_stopWorker(); //Free the worker's surface and backend, and what children made with it
+		void m_clearTiles(); //Destroy every tile
+		void m_forgetFocus(element *e); //Take a removed element out of m_focusedElements
+
+		std::vector<element*> m_pendingElements; //Children with notifications to deliver when our update ends
+		std::vector<SDL_FRect> m_pendingRects; //Invalidated while updating
+		bool m_pendingEverything = false; //Everything was invalidated while updating
+		bool m_pendingTransforms = false; //Moved, turned, or scrolled while updating
+		void m_addPending(element *e);
+		void m_forgetPending(element *e);
+		void m_dirtyTiles(const SDL_FRect &rect, bool everything); //Mark the tiles overlapping rect as dirty
+		void m_passInvalidation(SDL_FRect rect, bool everything); //Invalidate whatever shows rect of our content
+		void m_transformsChanged(); //Bump the transform generation, now or when our update ends
+
+		std::vector<element*> m_overlay; //Elements from any set inside of this one, drawn above everything else
+		void m_renderOverlay(SDL_Renderer *renderer);
 	public:
 		/**
 		 *	\brief Construct the set
@@ -63,6 +168,16 @@ namespace lui {
 		 *	\param *renderer Renderer to use for rendering.
 		 */
 		void render(SDL_Renderer *renderer);
+		/**
+		 *	\brief Free the set's textures, and those of its children
+		 */
+		void releaseTextures();
+		/**
+		 *	\brief Does the set hide everything under its dstrect
+		 *
+		 *	\return true if set opaque, or if the set has a size and an opaque, unrotated child covers all of it, and it is not faded by setAlphaMod()
+		 */
+		bool isOpaque();
 		/**
 		*	\brief Update all elements based on events
 		*
@@ -94,7 +209,26 @@ namespace lui {
 		void onFocusUpdated();
 		void setDstrect(SDL_FRect dr);
 		using element::getDstrect;
-		using element::setAngle;
+		using element::invalidate;
+		void setAngle(double a);
+		/**
+		 *	\brief Start a batch of changes to the set and its children
+		 *
+		 *	Until the matching endUpdate(), children changed through their own functions hold back
+		 *	their notifications as if each were updating (see element::beginUpdate()). Invalidated
+		 *	areas are collected and the cached tiles marked once, and the transform generation is
+		 *	bumped once, when the update ends.
+		 *
+		 *	\code
+		 *	menu.beginUpdate();
+		 *	for (size_t i = 0; i < buttons.size(); i++) {
+		 *		buttons[i]->setDstrect({ 0.f, i * 32.f, 200.f, 32.f });
+		 *	}
+		 *	menu.endUpdate();
+		 *	\endcode
+		 */
+		void beginUpdate();
+		void endUpdate();
 		using element::getAngle;
 		using element::setFlip;
 		using element::getFlip;
@@ -112,6 +246,68 @@ namespace lui {
 		 *	\return The origin corner
 		 */
 		SDL_FPoint getRenderCorner();
+		/**
+		 *	\brief Get a counter of changes to how local coordinates map to the window
+		 *
+		 *	The counter goes up whenever any set is moved, rotated, or scrolled, and whenever any
+		 *	element is moved to another set. Window positions worked out with localToWindow() remain
+		 *	correct for as long as it stays the same.
+		 *
+		 *	\returns The current generation
+		 */
+		static Uint32 getTransformGeneration();
+		/**
+		 *	\brief Bump the transform generation, as if every set moved
+		 *
+		 *	\note Only needed if a set's transform is changed by other means.
+		 */
+		static void invalidateTransforms();
+		/**
+		 *	\brief Get the transform generation at which this set, or any set around it, last moved, rotated, scrolled, or changed set
+		 *
+		 *	Window positions of the set's children worked out with localToWindow() remain correct
+		 *	for as long as it stays the same, whatever other sets do.
+		 *
+		 *	\returns The generation, or 0 if none of them has changed
+		 *
+		 *	\sa getTransformGeneration()
+		 */
+		Uint32 getLastTransformChange();
+		/**
+		 *	\brief Get the transform generation at which an element last joined or left this set
+		 *
+		 *	\returns The generation, or 0 if no element has
+		 */
+		Uint32 getLastMembershipChange();
+		/**
+		 *	\brief Get the bounding box of all children
+		 *
+		 *	Kept up to date as children are added, moved, and rotated. It grows right away,
+		 *	and is only worked out again from every child, once, when a child on its edge
+		 *	moves inward or is removed and the box is next asked for.
+		 *
+		 *	\returns The box, in local coordinates, or an empty rectangle if the set has no children
+		 *
+		 *	\sa scrollBar::attachSet()
+		 */
+		SDL_FRect getContentBounds();
+		/**
+		 *	\brief Get a counter of changes to what can be scrolled to
+		 *
+		 *	The counter goes up whenever the content bounds may have changed, and whenever the
+		 *	set is resized or scrolled.
+		 *
+		 *	\returns The current generation
+		 */
+		Uint32 getContentGeneration();
+		/**
+		 *	\brief Get the animator for the set and its children
+		 *
+		 *	The animator is stepped at the start of loopLogic().
+		 *
+		 *	\returns The animator, created on first use
+		 */
+		animator& getAnimator();
 		/**
 		 *	\brief Add an element to the set
 		 *
@@ -154,6 +350,47 @@ namespace lui {
 		 *	\brief Signal the set to update the focusedElements the next time userLogic() is called
 		 */
 		void setUpdateFocusElements();
+		/**
+		 *	\brief Signal the set to update the focusedElements if a changed element is, or was, under the cursor
+		 *
+		 *	Elements call this when moved, rotated, shown, or hidden, so animations away from the cursor
+		 *	don't make the set hit test its children every frame while the cursor is still.
+		 *
+		 *	\param before Bounding box of the element before the change, in local coordinates.
+		 *	\param after Bounding box of the element after the change, in local coordinates.
+		 */
+		void setUpdateFocusElements(const SDL_FRect &before, const SDL_FRect &after);
+		/**
+		 *	\brief Get the outermost set this set is inside of
+		 *
+		 *	\returns The outermost set, or this set if it has no parent
+		 */
+		set* getRoot();
+		/**
+		 *	\brief Draw an element above everything else
+		 *
+		 *	The element stays in its own set, which skips drawing it and giving it events; this set
+		 *	draws it last instead, at the same place on screen, and gives it events and focus before
+		 *	anything else, so the sets around it can not take its focus away. Moving an
+		 *	overlaid element does not invalidate its set, so the set's cached content stays valid
+		 *	and it costs a single draw per frame. Used while dragging items.
+		 *
+		 *	\param *e Element inside of this set, or any set inside of it.
+		 *
+		 *	\returns true if the element is overlaid. Fails if this set has a parent, the element
+		 *	is not inside of it, or a set around the element is rotated.
+		 *
+		 *	\note Overlaid elements are not clipped by the sets around them.
+		 */
+		bool addOverlay(element *e);
+		/**
+		 *	\brief Return an overlaid element to being drawn by its own set
+		 *
+		 *	\param *e The element.
+		 *
+		 *	\returns true if the element was overlaid
+		 */
+		bool removeOverlay(element *e);
 
 		/**
 		 *	\brief Convert coordinates from window space to local space
@@ -209,5 +446,198 @@ namespace lui {
 		 *	\sa windowToLocal
 		 */
 		SDL_Point localToWindow(SDL_Point localPoint);
+		/**
+		 *	\brief Convert many points from window space to local space
+		 *
+		 *	Each set between the window and this one turns every point at once.
+		 *
+		 *	\param *windowPoints Points relative to the window.
+		 *	\param count Number of points.
+		 *	\param *localPoints Filled with count points in this set's coordinate system; may be the same array as windowPoints.
+		 *	\sa windowToLocal(SDL_FPoint)
+		 */
+		void windowToLocal(const SDL_FPoint *windowPoints, size_t count, SDL_FPoint *localPoints);
+		/**
+		 *	\brief Convert many points from local space to window space
+		 *
+		 *	Each set between this one and the window turns every point at once.
+		 *
+		 *	\param *localPoints Points relative to this set.
+		 *	\param count Number of points.
+		 *	\param *windowPoints Filled with count points in the window's coordinate system; may be the same array as localPoints.
+		 *	\sa localToWindow(SDL_FPoint)
+		 */
+		void localToWindow(const SDL_FPoint *localPoints, size_t count, SDL_FPoint *windowPoints);
+
+		/**
+		 *	\brief Cache the content of the set in tiles
+		 *
+		 *	Children are drawn into fixed-size tiles in local coordinates. Each render then
+		 *	only draws the tiles which came on screen or were invalidated, and copies the rest,
+		 *	so scrolling with setRenderCorner() costs about one row of tiles per frame.
+		 *
+		 *	\param enable Should the content be cached.
+		 *	\param tileSize Width and height of each tile, in pixels.
+		 *	\param maxTiles Most tiles to keep, or 0 to keep four times as many as fit on screen.
+		 *
+		 *	\note Only sets with a size render to their own texture, so caching has no effect on sets with no size.
+		 *	\note Children whose appearance changes without a call to one of their own functions
+		 *	must be invalidated with element::invalidate().
+		 */
+		void setTileCaching(bool enable, int tileSize = 256, size_t maxTiles = 0);
+		/**
+		 *	\brief Is the content cached in tiles
+		 *
+		 *	\return true if tile caching is enabled.
+		 */
+		bool getTileCaching();
+		/**
+		 *	\brief Draw the children straight onto the parent's render target when possible
+		 *
+		 *	Sets with a size otherwise draw their children into a texture of their own, which is
+		 *	cleared, and drawn onto the parent, every frame. A set with no angle, no flip, no color
+		 *	or alpha modulation, and no tile caching draws its children where they go instead,
+		 *	clipped to its dstrect with a clip rectangle, and needs no texture. Children entirely
+		 *	outside of the clip rectangle are skipped.
+		 *
+		 *	\param direct Should the set draw directly when possible. On by default.
+		 *
+		 *	\note Semi-transparent children look slightly different drawn directly, since they
+		 *	blend with what is under the set instead of with its cleared texture first.
+		 */
+		void setDirectRendering(bool direct);
+		/**
+		 *	\brief May the set draw straight onto the parent's render target
+		 *
+		 *	\return true if direct rendering is allowed.
+		 */
+		bool getDirectRendering();
+		/**
+		 *	\brief Record the children into a display list, and replay it until one changes
+		 *
+		 *	Instead of calling render() on every child each frame, the set asks each child to
+		 *	record its draws with element::record() once, into a flat list which is drawn without
+		 *	calling the children. Draws of the same texture are moved next to each other where
+		 *	nothing between them overlaps. Children which do not record, such as sets and text
+		 *	fields, are called from their place in the list. Anything invalidated in the set
+		 *	records the list again; scrolling does not.
+		 *
+		 *	\param retained Should the set record and replay its children. Off by default.
+		 *
+		 *	\note Changes made without invalidating, such as to a button's srcrect or the blend
+		 *	mode of a texture, are not seen until the set is invalidated.
+		 *	\sa displayList
+		 */
+		void setRetainedRendering(bool retained);
+		/**
+		 *	\brief Does the set record its children into a display list
+		 */
+		bool getRetainedRendering();
+		/**
+		 *	\brief Get the display list recorded from the children, for inspection
+		 *
+		 *	\return The list as last recorded; empty until the set renders with retained rendering
+		 */
+		const displayList& getDisplayList();
+		/**
+		 *	\brief Draw only what changed since the last frame
+		 *
+		 *	For the outermost set. Everything invalidated since the last render(), such as moved
+		 *	elements, new textures, and text and cursor changes, is merged into a few rectangles of
+		 *	the target, and render() only draws those again: each is filled with the renderer's
+		 *	draw color, then drawn with a clip rectangle. getDamage() lists them afterwards, so the
+		 *	application can present or upload only those parts.
+		 *
+		 *	\code
+		 *	root.setDamageRendering(true);
+		 *	//Every frame, without clearing
+		 *	backend.setDrawColor(0, 0, 0, 255); //Background of damaged areas
+		 *	root.render(backend.getRenderer());
+		 *	std::vector<SDL_Rect> rects = root.getDamage();
+		 *	SDL_UpdateWindowSurfaceRects(window, rects.data(), (int)rects.size());
+		 *	\endcode
+		 *
+		 *	\param damage Should render() draw only what changed.
+		 *
+		 *	\note The target must keep what was drawn between frames, such as a target texture or
+		 *	the surface of a surfaceBackend, and must not be drawn on by anything else. Call
+		 *	invalidateRect() with an empty rectangle when it was, or when it was resized.
+		 *	\note Moving, turning, or scrolling the set itself draws everything again. So does
+		 *	damage inside of a flipped set.
+		 */
+		void setDamageRendering(bool damage);
+		/**
+		 *	\brief Does render() draw only what changed
+		 */
+		bool getDamageRendering();
+		/**
+		 *	\brief Get the parts of the target drawn by the last render()
+		 *
+		 *	\return Rectangles, in target pixels, which do not overlap each other; empty if nothing changed
+		 *
+		 *	\note Only filled while damage rendering (setDamageRendering()).
+		 */
+		const std::vector<SDL_Rect>& getDamage();
+		/**
+		 *	\brief Draw the children on a worker thread
+		 *
+		 *	SDL_Renderer may only be used from one thread, so sets normally draw one after
+		 *	another. A threaded set instead draws its children into its own SDL_Surface on a
+		 *	worker thread with a surfaceBackend, and only uploads and draws the result on the
+		 *	thread calling render(). The parent starts every threaded child before drawing any
+		 *	child, so panels side by side draw at the same time as each other and as the rest
+		 *	of the parent.
+		 *
+		 *	\code
+		 *	for (lui::set *panel : panels) {
+		 *		panel->setThreadedRendering(true);
+		 *	}
+		 *	lui::surfaceBackend::shareTexture(buttonTexture, buttonSurface); //Textures not made by the library
+		 *	\endcode
+		 *
+		 *	\param threaded Should the children be drawn on a worker thread.
+		 *
+		 *	\note Only sets with a size render to their own texture, so this has no effect on sets with no size.
+		 *	\note Textures given to children, such as those of buttons, must be given to surfaceBackend::shareTexture().
+		 *	Children must not share textures with color or alpha modulation with elements drawn elsewhere.
+		 *	\note Threaded sets inside of a threaded set draw on its worker.
+		 *	\note Remove the children, or call their releaseTextures(), before destroying a threaded set
+		 *	while they live on; the textures they made on the worker are destroyed with it.
+		 */
+		void setThreadedRendering(bool threaded);
+		/**
+		 *	\brief Are the children drawn on a worker thread
+		 *
+		 *	\return true if rendering is threaded.
+		 */
+		bool getThreadedRendering();
+		/**
+		 *	\brief Redraw part of the content
+		 *
+		 *	Marks the tiles overlapping a rectangle as dirty, and passes the change on to the parent set.
+		 *
+		 *	\param rect Rectangle in local coordinates. A rectangle with no size invalidates everything.
+		 */
+		void invalidateRect(SDL_FRect rect);
+
+		/**
+		 *	\brief Merge runs of mouse motion and wheel events before processing them
+		 *
+		 *	When enabled, userLogic() passes the events through CoalesceEvents() first,
+		 *	so children see at most one motion event between any two other events.
+		 *	Only needed on the outermost set; nested sets receive the merged events.
+		 *
+		 *	\param coalesce Should events be merged.
+		 *
+		 *	\note The events vector given to userLogic() is changed in place.
+		 *	\sa lui::CoalesceEvents()
+		 */
+		void setCoalesceEvents(bool coalesce);
+		/**
+		 *	\brief Are motion and wheel events merged before processing
+		 *
+		 *	\return true if events are coalesced.
+		 */
+		bool getCoalesceEvents();
 	};
 };
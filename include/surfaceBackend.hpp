@@ -0,0 +1,138 @@
+#pragma once
+
+#include "./renderBackend.hpp"
+
+extern "C" {
+#include <SDL2/SDL.h>
+}
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace lui {
+	/**
+	 *	\brief Backend drawing into an SDL_Surface on the CPU
+	 *
+	 *	For machines without a GPU, such as kiosks and CI runners, where SDL's software renderer
+	 *	is slow at rotated copies and blending. Blending, fills, and sampling for rotated and
+	 *	scaled copies are done several pixels at a time with SSE2, AVX2 (picked at run time
+	 *	when the compiler allows it), or NEON.
+	 *
+	 *	The backend makes a software renderer for the surface, which is the handle passed to
+	 *	render(). Textures drawn must be made through the backend (createTexture(),
+	 *	createTextureFromSurface()), which keeps an ARGB8888 copy of each one to draw from;
+	 *	the library's own textures already are. Textures made elsewhere, such as those of
+	 *	buttons drawn by a set rendered on a worker thread, can be drawn once their pixels are
+	 *	given with shareTexture().
+	 *
+	 *	\code
+	 *	SDL_Surface *screen = SDL_CreateRGBSurfaceWithFormat(0, 1280, 720, 32, SDL_PIXELFORMAT_ARGB8888);
+	 *	lui::surfaceBackend backend(screen);
+	 *	backend.attach();
+	 *	SDL_Texture *icon = backend.createTextureFromSurface(iconSurface);
+	 *	root.render(backend.getRenderer());
+	 *	\endcode
+	 *
+	 *	\note The surface must be ARGB8888 or RGB888, and must not need locking (SDL_MUSTLOCK()).
+	 *	Sampling is nearest neighbour, like SDL's software renderer.
+	 */
+	class surfaceBackend : public renderBackend {
+	private:
+		std::recursive_mutex m_mutex; //Mutex for the targets and copies below, since renderBackend::destroyTexture() may forget a texture from any thread
+			SDL_Surface *m_surface = nullptr; //Default target
+			SDL_Surface *m_target = nullptr; //Surface drawn into now
+			SDL_Texture *m_targetTexture = nullptr;
+			std::unordered_map<SDL_Texture*, SDL_Surface*> m_copies; //ARGB8888 copy of every texture made through us
+		SDL_Color m_drawColor = { 0, 0, 0, 255 };
+		SDL_BlendMode m_drawBlendMode = SDL_BLENDMODE_NONE;
+		SDL_Rect m_clip = { 0, 0, 0, 0 };
+		bool m_clipEnabled = false;
+		SDL_Rect m_defaultClip = { 0, 0, 0, 0 }; //Clip of the default target while drawing into a texture
+		bool m_defaultClipEnabled = false;
+		std::vector<Uint32> m_row; //Scratch, one row of sampled pixels
+
+		static SDL_Renderer* m_makeRenderer(SDL_Surface *surface);
+		void m_forgetTexture(SDL_Texture *texture);
+		SDL_Surface* m_copyOf(SDL_Texture *texture);
+		SDL_Rect m_drawable(); //Part of the target which may be drawn on
+		Uint32 m_drawPixel();
+		void m_fillPixels(const SDL_Rect &rect, Uint32 color, SDL_BlendMode mode);
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+		void m_triangle(SDL_Surface *source, SDL_BlendMode mode, const SDL_Vertex &a, const SDL_Vertex &b, const SDL_Vertex &c);
+#endif
+	public:
+		/**
+		 *	\brief Construct a backend drawing into a surface
+		 *
+		 *	\param *surface The surface, which must outlive the backend.
+		 */
+		surfaceBackend(SDL_Surface *surface);
+		/**
+		 *	\brief Deconstruct the backend, its software renderer, and its copies of textures
+		 *
+		 *	\note Destroy textures made through the backend first.
+		 */
+		~surfaceBackend();
+
+		/**
+		 *	\brief Get the surface drawn into by default
+		 */
+		SDL_Surface* getSurface();
+		/**
+		 *	\brief Draw into another surface by default
+		 *
+		 *	Textures made through the backend are kept, so this is cheaper than a new backend
+		 *	when the surface is resized.
+		 *
+		 *	\param *surface The surface, which must outlive the backend or be replaced first.
+		 *
+		 *	\returns 0 on success, or -1 if the surface is not ARGB8888 or RGB888
+		 */
+		int setSurface(SDL_Surface *surface);
+		/**
+		 *	\brief Let every surfaceBackend draw a texture made elsewhere
+		 *
+		 *	\param *texture The texture, made by any renderer.
+		 *	\param *pixels What the texture looks like; an ARGB8888 copy is kept.
+		 *
+		 *	\returns 0 on success, or -1 if the pixels could not be copied
+		 *
+		 *	\note The copy is freed when the texture is destroyed through renderBackend::destroyTexture(),
+		 *	or with unshareTexture(). Neither may happen while a surfaceBackend is drawing it.
+		 */
+		static int shareTexture(SDL_Texture *texture, SDL_Surface *pixels);
+		/**
+		 *	\brief Free the copy kept of a texture by shareTexture()
+		 *
+		 *	\param *texture The texture.
+		 */
+		static void unshareTexture(SDL_Texture *texture);
+		/**
+		 *	\brief Get which instruction set the drawing kernels use
+		 *
+		 *	\returns "AVX2", "SSE2", "NEON", or "scalar"
+		 */
+		static const char* getKernels();
+
+		SDL_Texture* createTexture(Uint32 format, int access, int w, int h);
+		SDL_Texture* createTextureFromSurface(SDL_Surface *surface);
+		int updateTexture(SDL_Texture *texture, const SDL_Rect *rect, const void *pixels, int pitch);
+		int setTarget(SDL_Texture *texture);
+		SDL_Texture* getTarget();
+		int getOutputSize(int *w, int *h);
+		int setClipRect(const SDL_Rect *rect);
+		bool getClipRect(SDL_Rect *rect);
+		int setDrawColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+		int getDrawColor(Uint8 *r, Uint8 *g, Uint8 *b, Uint8 *a);
+		int setDrawBlendMode(SDL_BlendMode mode);
+		int getDrawBlendMode(SDL_BlendMode *mode);
+		int clear();
+		int fillRect(const SDL_FRect *rect);
+		int drawRect(const SDL_FRect *rect);
+		int drawLines(const SDL_FPoint *points, int count);
+		int copy(SDL_Texture *texture, const SDL_Rect *srcrect, const SDL_FRect *dstrect, double angle = 0, const SDL_FPoint *center = nullptr, SDL_RendererFlip flip = SDL_FLIP_NONE);
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+		int geometry(SDL_Texture *texture, const SDL_Vertex *vertices, int numVertices, const int *indices, int numIndices);
+#endif
+	};
+};
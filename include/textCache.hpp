@@ -0,0 +1,178 @@
+#pragma once
+
+extern "C" {
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+}
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace lui {
+	/**
+	 *	\brief A process-wide cache of measured and rasterized strings
+	 *
+	 *	Entries are keyed by font, font size, font style, color, and a hash of the string.
+	 *	Measurements are shared by every renderer and color, while rasterized textures are
+	 *	kept per renderer. Once the stored textures exceed the byte budget, the least
+	 *	recently used entries are destroyed.
+	 *
+	 *	\note Textures returned by the cache are owned by the cache and may be evicted by
+	 *	any later call. Look them up again every render instead of storing them.
+	 *	\note Textures are only evicted by getTexture() calls for their own renderer, so a
+	 *	thread drawing with one renderer never has its textures destroyed by another.
+	 *	\note A texture too large for the budget is still handed out, but not cached; the last
+	 *	one of each renderer is kept outside of the budget until another one replaces it.
+	 *	\note All strings used in this class are formatted with UTF-8.
+	 */
+	class textCache {
+	private:
+		struct entryKey {
+			SDL_Renderer *renderer; //nullptr for measurement-only entries
+			TTF_Font *font;
+			int size, style;
+			Uint32 color; //RGBA packed, 0 for measurement-only entries
+			size_t hash;
+
+			bool operator==(const entryKey &other) const {
+				return renderer == other.renderer && font == other.font && size == other.size && style == other.style && color == other.color && hash == other.hash;
+			}
+		};
+		struct entryKeyHash {
+			size_t operator()(const entryKey &k) const;
+		};
+		struct entry {
+			entryKey key;
+			std::string text; //Compared on lookup so a hash collision is treated as a miss
+			int w = 0, h = 0;
+			SDL_Texture *texture = nullptr;
+			size_t bytes = 0;
+		};
+
+		std::mutex m_mutex; //Mutex for everything below, and held around every SDL_ttf call
+			std::list<entry> m_entries; //Front is the most recently used
+			std::unordered_map<entryKey, std::list<entry>::iterator, entryKeyHash> m_index;
+			size_t m_byteBudget = 32 * 1024 * 1024;
+			size_t m_bytesUsed = 0;
+			Uint64 m_hits = 0, m_misses = 0;
+			std::unordered_map<SDL_Renderer*, entry> m_oversized; //Last texture per renderer too large to cache, kept until the next one
+
+		entryKey m_makeKey(SDL_Renderer *renderer, TTF_Font *font, size_t hash, Uint32 color);
+		entry* m_find(const entryKey &k, const std::string &text); //Moves a hit to the front
+		entry* m_insert(const entryKey &k, const std::string &text);
+		void m_erase(std::list<entry>::iterator it);
+		void m_trim(SDL_Renderer *renderer, bool anyRenderer = false, size_t reserve = 0); //Evict least recently used entries until within budget with reserve bytes to spare, keeping textures of other renderers unless anyRenderer
+		void m_eraseOversized(std::unordered_map<SDL_Renderer*, entry>::iterator it);
+	public:
+		textCache();
+		~textCache();
+		textCache(const textCache&) = delete;
+		textCache& operator=(const textCache&) = delete;
+
+		/**
+		 *	\brief Get the cache shared by the whole process
+		 */
+		static textCache& global();
+		/**
+		 *	\brief Hash a string the same way the cache does
+		 *
+		 *	Elements displaying a fixed string can store this value so a lookup costs no hashing.
+		 */
+		static size_t hashString(const std::string &text);
+
+		/**
+		 *	\brief Measure a string
+		 *
+		 *	\param *font Font to measure with.
+		 *	\param text String to measure.
+		 *	\param *w Filled with the width of the string, if not nullptr.
+		 *	\param *h Filled with the height of the string, if not nullptr.
+		 *
+		 *	\returns 0 on success, or -1 on error
+		 */
+		int size(TTF_Font *font, const std::string &text, int *w, int *h);
+		/**
+		 *	\brief Measure a string with a precomputed hash
+		 *
+		 *	\sa textCache::hashString
+		 */
+		int size(TTF_Font *font, const std::string &text, size_t hash, int *w, int *h);
+		/**
+		 *	\brief Get a texture of the rasterized string
+		 *
+		 *	\param *renderer Renderer the texture will be used with.
+		 *	\param *font Font to rasterize with.
+		 *	\param text String to rasterize.
+		 *	\param color Color of the text.
+		 *	\param *w Filled with the width of the texture, if not nullptr.
+		 *	\param *h Filled with the height of the texture, if not nullptr.
+		 *
+		 *	\returns The texture, or nullptr on error or for an empty string
+		 */
+		SDL_Texture* getTexture(SDL_Renderer *renderer, TTF_Font *font, const std::string &text, SDL_Color color, int *w = nullptr, int *h = nullptr);
+		/**
+		 *	\brief Get a texture of the rasterized string with a precomputed hash
+		 *
+		 *	\sa textCache::hashString
+		 */
+		SDL_Texture* getTexture(SDL_Renderer *renderer, TTF_Font *font, const std::string &text, size_t hash, SDL_Color color, int *w = nullptr, int *h = nullptr);
+
+		/**
+		 *	\brief Set the maximum number of bytes of texture memory the cache may hold
+		 *
+		 *	\param bytes The budget, in bytes. Entries are evicted immediately if over it.
+		 *
+		 *	\note Textures of every renderer may be evicted, so no other thread may be drawing.
+		 */
+		void setByteBudget(size_t bytes);
+		/**
+		 *	\brief Get the maximum number of bytes the cache may hold
+		 */
+		size_t getByteBudget();
+		/**
+		 *	\brief Get the number of bytes the cache currently holds
+		 */
+		size_t getBytesUsed();
+		/**
+		 *	\brief Get the number of lookups which were served from the cache
+		 */
+		Uint64 getHits();
+		/**
+		 *	\brief Get the number of lookups which had to measure or rasterize
+		 */
+		Uint64 getMisses();
+		/**
+		 *	\brief Reset the hit and miss counters to 0
+		 */
+		void resetCounters();
+
+		/**
+		 *	\brief Get the lock the cache holds around its SDL_ttf calls
+		 *
+		 *	SDL_ttf fonts may not be used by two threads at once, and sets drawn on worker threads
+		 *	(set::setThreadedRendering()) may share fonts with each other and the render thread.
+		 *	Elements calling SDL_ttf themselves should hold this around those calls.
+		 *
+		 *	\note Do not call any other function of the cache while holding it.
+		 */
+		std::mutex& getFontMutex();
+
+		/**
+		 *	\brief Remove every entry
+		 */
+		void clear();
+		/**
+		 *	\brief Remove every entry made with a renderer
+		 *
+		 *	\note Must be called before destroying a renderer the cache was used with.
+		 */
+		void clearRenderer(SDL_Renderer *renderer);
+		/**
+		 *	\brief Remove every entry made with a font
+		 *
+		 *	\note Must be called before closing a font the cache was used with.
+		 */
+		void clearFont(TTF_Font *font);
+	};
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "./element.hpp"
+#include "./utf8.hpp"
 
 extern "C" {
 #include <SDL2/SDL.h>
@@ -24,12 +25,6 @@ namespace lui {
 		//	return utflen;
 		//}
 
-	//Move from a given byte to a grapheme index (In bytes)
-	/**
-	 *	\brief Given a starting byte, find the starting byte of the grapheme X grapheme away
-	 */
-	static size_t getUTF8GraphemeIndex(const std::string &s, int graphemeDistance = 0, size_t fromByte = 0);
-	
 	/**
 	 *	\brief A text entry field
 	 *
@@ -47,8 +42,8 @@ namespace lui {
 	class textField : public element {
 	protected:
 		bool m_updateTextureNextRender = true; //!<Do we need to update the texture next render call?
-		SDL_Texture *m_texture, *m_textureCommitedLeft, *m_textureComposition, *m_textureCommitedRight; //Texture which is rendered and its parts
-		SDL_Surface *m_surfaceCommitedLeft, *m_surfaceComposition, *m_surfaceCommitedRight; //Surfaces for all 3 parts of text, one linked to m_texture
+		SDL_Texture *m_texture = nullptr; //!<Streaming texture which is rendered, only recreated when the size changes
+		SDL_Surface *m_surface = nullptr; //!<Staging surface the field is composed on before uploading to m_texture, same size as m_texture
 		
 		std::array<Uint8, 7>	m_r = { 255, 255, 255, 255, 000, 192, 000 }, //!<Red values of components. \sa textField::Component
 								m_g = { 255, 255, 255, 255, 120, 192, 000 }, //!<Green values of components. \sa textField::Component
@@ -64,10 +59,27 @@ namespace lui {
 		size_t m_cursorIndex = 0, m_compositionCursorIndex = 0; //Where is the cursor among the text, currently.
 		size_t m_selectionIndexBegin = 0, m_selectionIndexEnd = 0, m_selectingFromIndex = 0;
 		std::string m_commitedString = ""; //!<The text in the field (Excluding composition text)
+		graphemeIndex m_commitedGraphemes; //!<Grapheme cluster boundaries of m_commitedString
 		std::string m_compositionString = ""; //!<Composition text
 		std::string m_defaultString = ""; //!<The string which is rendered when there is no text and not focused
+		size_t m_maxLength = 0; //!<Maximum length of m_commitedString in bytes, 0 for no limit
+		std::string m_pasteBuffer = ""; //!<Clipboard text still being pasted
+		size_t m_pasteOffset = 0; //!<How much of m_pasteBuffer has been inserted
+		size_t m_pasteChunkSize = 65536; //!<Bytes of m_pasteBuffer inserted per userLogic call
+		size_t m_viewIndex = 0; //!<First byte of m_commitedString laid out; text before it is scrolled out of view and never measured
+		int m_viewShift = 0; //!<Where m_viewIndex is drawn, left of the field when its cluster is partly scrolled out
 
 		void m_updateTexture(SDL_Renderer *renderer); //!<Update m_texture to reflect current state
+		int m_sizeText(const std::string &s, int *w, int *h); //!<Measure s in m_font, holding the font lock of textCache
+		void m_blitText(const std::string &s, int component, SDL_Rect &dstrect); //!<Rasterize s in the color of a Component and blit it onto m_surface
+		void m_eraseCommited(size_t index, size_t length); //!<Erase from m_commitedString, keeping m_commitedGraphemes in step
+		void m_insertCommited(size_t index, const std::string &s); //!<Insert into m_commitedString, keeping m_commitedGraphemes in step
+		int m_spanWidth(size_t begin, size_t end); //!<Width of m_commitedString from begin up to end
+		size_t m_fitBefore(size_t end, size_t floor, int room); //!<Earliest cluster boundary, no earlier than floor, from which the text up to end fits in room pixels
+		size_t m_fillAfter(size_t begin, int room); //!<Earliest cluster boundary up to which the text from begin is at least room pixels wide, or the end of the string
+		size_t m_remainingLength(); //!<Bytes which may still be added before reaching m_maxLength
+		void m_pasteStep(size_t bytes); //!<Validate and insert up to a number of bytes from m_pasteBuffer
+		void m_finishPaste(); //!<Insert everything left in m_pasteBuffer now
 
 		Uint32 m_cursorTimer = 0; //!<Timer used for tracking the cursor blinking
 	public:
@@ -94,6 +106,7 @@ namespace lui {
 		~textField();
 
 		void render(SDL_Renderer *renderer);
+		void releaseTextures();
 		void userLogic(std::vector<SDL_Event> &events, SDL_Renderer *renderer);
 		void resetUserLogic();
 		void loopLogic(Uint32 ms);
@@ -228,5 +241,44 @@ namespace lui {
 		 *	\return The string currently commited to the text field by user.
 		 */
 		std::string getCommitedString();
+		/**
+		 *	\brief Set the maximum length of the text
+		 *
+		 *	Typed and pasted text past this length is cut off at a code point.
+		 *
+		 *	\param bytes Maximum length in bytes of UTF-8, or 0 for no limit.
+		 */
+		void setMaxLength(size_t bytes);
+		/**
+		 *	\brief Get the maximum length of the text
+		 *
+		 *	\return Maximum length in bytes, or 0 if there is no limit.
+		 */
+		size_t getMaxLength();
+		/**
+		 *	\brief Set how much clipboard text is pasted per frame
+		 *
+		 *	Pasting is spread across userLogic calls so that large clipboards
+		 *	do not stall the program. Invalid UTF-8 is dropped as it is inserted,
+		 *	the texture is updated once the paste is done, and ValueChanged is
+		 *	called once at the end.
+		 *
+		 *	\param bytes Bytes to insert per userLogic call. At least 4.
+		 */
+		void setPasteChunkSize(size_t bytes);
+		/**
+		 *	\brief Get how much clipboard text is pasted per frame
+		 *
+		 *	\return Bytes inserted per userLogic call.
+		 */
+		size_t getPasteChunkSize();
+		/**
+		 *	\brief Is a paste still being inserted
+		 *
+		 *	Any other edit, click, or stopping typing finishes the paste immediately.
+		 *
+		 *	\return True if part of the clipboard text has not been inserted yet.
+		 */
+		bool isPasting();
 	};
 };
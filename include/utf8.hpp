@@ -0,0 +1,137 @@
+#pragma once
+
+extern "C" {
+#include <SDL2/SDL.h>
+}
+#include <string>
+#include <vector>
+
+namespace lui {
+	/**
+	 *	\brief Decode the code point starting at a byte
+	 *
+	 *	\param s UTF-8 string to decode from.
+	 *	\param byte Index of the first byte of the code point.
+	 *	\param *length Filled with the number of bytes the code point uses, if not nullptr.
+	 *
+	 *	\returns The code point, or U+FFFD with a length of 1 if the bytes are not valid UTF-8
+	 */
+	Uint32 UTF8Decode(const std::string &s, size_t byte, size_t *length = nullptr);
+
+	/**
+	 *	\brief Find how many bytes at the start of a buffer are valid UTF-8
+	 *
+	 *	ASCII runs are checked 16 bytes at a time with SSE2 or NEON when available.
+	 *
+	 *	\param *s Buffer to check.
+	 *	\param length Number of bytes in the buffer.
+	 *
+	 *	\returns Length of the longest valid prefix; equal to length if the whole buffer is valid
+	 */
+	size_t UTF8ValidLength(const char *s, size_t length);
+
+	/**
+	 *	\brief Count the code points in a buffer
+	 *
+	 *	Counted 16 bytes at a time with SSE2 or NEON when available.
+	 *
+	 *	\param *s Buffer to count.
+	 *	\param length Number of bytes in the buffer.
+	 *
+	 *	\returns The number of bytes which are not continuation bytes
+	 */
+	size_t UTF8Count(const char *s, size_t length);
+
+	/**
+	 *	\brief Move a number of code points from a given byte
+	 *
+	 *	\param s UTF-8 string to move along.
+	 *	\param fromByte Byte to start from. Moved back to the start of its code point first.
+	 *	\param codePoints How many code points to move. Negative moves backwards.
+	 *
+	 *	\returns Index of the first byte of the resulting code point, clamped to [0, s.size()]
+	 */
+	size_t UTF8Advance(const std::string &s, size_t fromByte, int codePoints);
+
+	/**
+	 *	\brief Index of the grapheme cluster boundaries of a string
+	 *
+	 *	Boundaries follow the extended grapheme cluster rules of UAX #29, so combining marks,
+	 *	emoji ZWJ sequences, flags, and Hangul syllables move and delete as one unit.
+	 *	The index keeps one flag per byte, making next() and previous() cost the length of
+	 *	one cluster no matter how long the string is. Edits re-segment only the clusters
+	 *	around the edit.
+	 *
+	 *	\note The property tables are abridged to the scripts and emoji in common use;
+	 *	unlisted code points are treated as stand-alone characters.
+	 */
+	class graphemeIndex {
+	private:
+		std::vector<Uint8> m_boundaries = { 1 }; //1 at the first byte of every cluster, and at the end of the string
+		size_t m_clusters = 0;
+
+		//Re-segment from a known boundary; stops early once past stopAfter and back in step with the previous segmentation
+		void m_segment(const std::string &s, size_t from, size_t stopAfter);
+	public:
+		/**
+		 *	\brief Construct an index of an empty string
+		 */
+		graphemeIndex();
+		/**
+		 *	\brief Construct an index of a string
+		 *
+		 *	\param s UTF-8 string to index.
+		 */
+		graphemeIndex(const std::string &s);
+
+		/**
+		 *	\brief Index a whole string, discarding the previous index
+		 *
+		 *	\param s UTF-8 string to index.
+		 */
+		void rebuild(const std::string &s);
+		/**
+		 *	\brief Update the index after part of the string was replaced
+		 *
+		 *	\param s The string after the edit.
+		 *	\param position Byte at which the edit happened.
+		 *	\param erased Number of bytes which were removed at position.
+		 *	\param inserted Number of bytes which were inserted at position.
+		 */
+		void replace(const std::string &s, size_t position, size_t erased, size_t inserted);
+
+		/**
+		 *	\brief Get the start of the cluster after the one at a byte
+		 *
+		 *	\returns The next boundary, or the length of the string
+		 */
+		size_t next(size_t byte) const;
+		/**
+		 *	\brief Get the start of the cluster before the one at a byte
+		 *
+		 *	\returns The previous boundary, or 0
+		 */
+		size_t previous(size_t byte) const;
+		/**
+		 *	\brief Move a number of clusters from a byte
+		 *
+		 *	\param byte Byte to start from.
+		 *	\param clusters How many clusters to move. Negative moves backwards.
+		 *
+		 *	\returns The boundary which was reached
+		 */
+		size_t move(size_t byte, int clusters) const;
+		/**
+		 *	\brief Get the start of the cluster containing a byte
+		 */
+		size_t floor(size_t byte) const;
+		/**
+		 *	\brief Is a byte the start of a cluster (Or the end of the string)
+		 */
+		bool isBoundary(size_t byte) const;
+		/**
+		 *	\brief Get the number of clusters in the string
+		 */
+		size_t count() const;
+	};
+};
@@ -0,0 +1,168 @@
+#include "./alphaMaskCache.hpp"
+
+extern "C" {
+#include <SDL2/SDL.h>
+}
+#include <algorithm>
+#include <cmath>
+#include <iterator> //std::prev
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LUI_MASK_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define LUI_MASK_NEON
+#include <arm_neon.h>
+#endif
+
+namespace lui {
+
+	namespace {
+		//Bits of up to 64 ARGB8888 pixels, set where alpha is at least threshold
+		Uint64 PackAlpha(const Uint32 *pixels, int count, Uint32 threshold) {
+			Uint64 word = 0;
+			int x = 0;
+#if defined(LUI_MASK_SSE2)
+			const __m128i below = _mm_set1_epi32((int)threshold - 1);
+			for (; x + 4 <= count; x += 4) {
+				__m128i alpha = _mm_srli_epi32(_mm_loadu_si128((const __m128i*)(pixels + x)), 24);
+				int solid = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(alpha, below)));
+				word |= (Uint64)solid << x;
+			}
+#elif defined(LUI_MASK_NEON)
+			const uint32x4_t least = vdupq_n_u32(threshold);
+			const uint32x4_t weights = { 1, 2, 4, 8 };
+			for (; x + 4 <= count; x += 4) {
+				uint32x4_t alpha = vshrq_n_u32(vld1q_u32(pixels + x), 24);
+				uint32x4_t solid = vandq_u32(vcgeq_u32(alpha, least), weights);
+				word |= (Uint64)vaddvq_u32(solid) << x;
+			}
+#endif
+			for (; x < count; x++) {
+				word |= (Uint64)((pixels[x] >> 24) >= threshold) << x;
+			}
+			return word;
+		}
+	}
+
+	alphaMaskCache::alphaMaskCache() {}
+
+	alphaMaskCache& alphaMaskCache::global() {
+		//Never destroyed; elements may hit test during static destruction
+		static alphaMaskCache *cache = new alphaMaskCache();
+		return *cache;
+	}
+
+	int alphaMaskCache::add(SDL_Texture *texture, SDL_Surface *surface, Uint8 threshold) {
+		if (texture == nullptr || surface == nullptr) {
+			return -1;
+		}
+		SDL_Surface *argb = surface;
+		if (surface->format->format != SDL_PIXELFORMAT_ARGB8888) {
+			argb = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+			if (argb == nullptr) {
+				return -1;
+			}
+		}
+		if (SDL_MUSTLOCK(argb) && SDL_LockSurface(argb) != 0) {
+			if (argb != surface) {
+				SDL_FreeSurface(argb);
+			}
+			return -1;
+		}
+		entry made{ texture, mask(), 0 };
+		mask &m = made.bits;
+		m.w = argb->w;
+		m.h = argb->h;
+		m.wordsPerRow = (m.w + 63) / 64;
+		m.bits.resize((size_t)m.wordsPerRow * m.h);
+		for (int y = 0; y < m.h; y++) {
+			const Uint32 *row = (const Uint32*)((const Uint8*)argb->pixels + (size_t)y * argb->pitch);
+			for (int word = 0; word < m.wordsPerRow; word++) {
+				int first = word * 64;
+				m.bits[(size_t)y * m.wordsPerRow + word] = PackAlpha(row + first, std::min(64, m.w - first), threshold);
+			}
+		}
+		if (SDL_MUSTLOCK(argb)) {
+			SDL_UnlockSurface(argb);
+		}
+		if (argb != surface) {
+			SDL_FreeSurface(argb);
+		}
+		made.bytes = m.bits.size() * sizeof(Uint64) + sizeof(entry);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto found = m_index.find(texture);
+		if (found != m_index.end()) {
+			m_erase(found->second);
+		}
+		if (made.bytes > m_byteBudget) {
+			return -1;
+		}
+		m_entries.push_front(std::move(made));
+		m_index[texture] = m_entries.begin();
+		m_bytesUsed += m_entries.front().bytes;
+		m_trim();
+		return 0;
+	}
+	void alphaMaskCache::remove(SDL_Texture *texture) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto found = m_index.find(texture);
+		if (found != m_index.end()) {
+			m_erase(found->second);
+		}
+	}
+	bool alphaMaskCache::has(SDL_Texture *texture) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_index.find(texture) != m_index.end();
+	}
+	int alphaMaskCache::sample(SDL_Texture *texture, const SDL_Rect *srcrect, float u, float v) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto found = m_index.find(texture);
+		if (found == m_index.end()) {
+			return -1;
+		}
+		m_entries.splice(m_entries.begin(), m_entries, found->second);
+		const mask &m = found->second->bits;
+		SDL_Rect src = srcrect != nullptr ? *srcrect : SDL_Rect{ 0, 0, m.w, m.h };
+		if (src.w <= 0 || src.h <= 0) {
+			return 0;
+		}
+		//Clamped, since points rounded onto the edge of the element land just outside of it
+		int x = src.x + std::min(std::max((int)std::floor(u * src.w), 0), src.w - 1);
+		int y = src.y + std::min(std::max((int)std::floor(v * src.h), 0), src.h - 1);
+		return m.test(x, y) ? 1 : 0;
+	}
+	void alphaMaskCache::clear() {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_entries.clear();
+		m_index.clear();
+		m_bytesUsed = 0;
+	}
+
+	void alphaMaskCache::setByteBudget(size_t bytes) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_byteBudget = bytes;
+		m_trim();
+	}
+	size_t alphaMaskCache::getByteBudget() {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_byteBudget;
+	}
+	size_t alphaMaskCache::getBytesUsed() {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_bytesUsed;
+	}
+
+	void alphaMaskCache::m_erase(std::list<entry>::iterator it) {
+		m_bytesUsed -= it->bytes;
+		m_index.erase(it->texture);
+		m_entries.erase(it);
+	}
+	void alphaMaskCache::m_trim() {
+		while (m_bytesUsed > m_byteBudget && !m_entries.empty()) {
+			m_erase(std::prev(m_entries.end()));
+		}
+	}
+
+}
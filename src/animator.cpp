@@ -0,0 +1,373 @@
+#include "./animator.hpp"
+
+extern "C" {
+#include <SDL2/SDL.h>
+}
+#include <algorithm>
+#include <cmath>
+#include "./set.hpp"
+
+namespace lui {
+
+	const Uint32 animator::m_none;
+
+	animator::animator(set *owner) {
+		m_owner = owner;
+	}
+	animator::~animator() {}
+
+	Uint64 animator::tween(element *target, Property p, float to, Uint32 duration, Easing easing, Uint32 delay) {
+		if (target == nullptr || (target != m_owner && target->getSet() != m_owner) || (p >= CornerX && dynamic_cast<set*>(target) == nullptr)) {
+			return 0;
+		}
+		Uint32 slot = m_allocate(target, p, 0.f, to, duration, easing);
+		m_elapsed[slot] = -(float)delay;
+		if (delay == 0) {
+			m_from[slot] = m_current(target, p);
+		}
+		else {
+			m_fromCurrent[slot] = true;
+			m_delayedStarts++;
+		}
+		return ((Uint64)m_serials[slot] << 32) | slot;
+	}
+	Uint64 animator::animate(element *target, Property p, const std::vector<keyframe> &keyframes, Uint32 delay) {
+		if (keyframes.empty() || target == nullptr || (target != m_owner && target->getSet() != m_owner) || (p >= CornerX && dynamic_cast<set*>(target) == nullptr)) {
+			return 0;
+		}
+		//Jump to the first value and hold it until its time, then one track per keyframe after it
+		Uint32 previous = m_allocate(target, p, keyframes[0].value, keyframes[0].value, keyframes[0].time, Linear);
+		m_elapsed[previous] = -(float)delay;
+		for (size_t i = 1; i < keyframes.size(); i++) {
+			Uint32 duration = keyframes[i].time > keyframes[i - 1].time ? keyframes[i].time - keyframes[i - 1].time : 0;
+			Uint32 slot = m_allocate(target, p, keyframes[i - 1].value, keyframes[i].value, duration, keyframes[i].easing);
+			m_waiting[slot] = true;
+			m_next[previous] = slot;
+			m_previous[slot] = previous;
+			previous = slot;
+		}
+		//The last track runs for as long as the animation does
+		return ((Uint64)m_serials[previous] << 32) | previous;
+	}
+	bool animator::stop(Uint64 track) {
+		if (!isRunning(track)) {
+			return false;
+		}
+		//Handles are of the last track of an animation, so stop from the one running now
+		Uint32 slot = (Uint32)track;
+		while (m_previous[slot] != m_none) {
+			slot = m_previous[slot];
+		}
+		m_release(slot);
+		return true;
+	}
+	size_t animator::stop(element *target) {
+		size_t stopped = 0;
+		for (size_t i = 0; i < m_targets.size(); i++) {
+			if (m_targets[i] == target) {
+				m_release((Uint32)i);
+				stopped++;
+			}
+		}
+		return stopped;
+	}
+	size_t animator::stop(element *target, Property p) {
+		size_t stopped = 0;
+		for (size_t i = 0; i < m_targets.size(); i++) {
+			if (m_targets[i] == target && m_properties[i] == p) {
+				m_release((Uint32)i);
+				stopped++;
+			}
+		}
+		return stopped;
+	}
+	bool animator::isRunning(Uint64 track) {
+		Uint32 slot = (Uint32)track;
+		return slot < m_targets.size() && m_targets[slot] != nullptr && m_serials[slot] == (Uint32)(track >> 32);
+	}
+	size_t animator::size() {
+		return m_running;
+	}
+
+	void animator::step(Uint32 ms) {
+		size_t count = m_targets.size();
+		if (m_running == 0) {
+			return;
+		}
+		float *elapsed = m_elapsed.data(), *inverseDuration = m_inverseDuration.data(), *progress = m_progress.data();
+		float *from = m_from.data(), *to = m_to.data(), *values = m_values.data();
+
+		//Advance time; free and waiting slots are advanced too, and reset when they start
+		for (size_t i = 0; i < count; i++) {
+			elapsed[i] += (float)ms;
+			progress[i] = std::min(std::max(elapsed[i] * inverseDuration[i], 0.f), 1.f);
+		}
+		//Delayed tweens start from wherever the property is when they start
+		if (m_delayedStarts > 0) {
+			for (size_t i = 0; i < count; i++) {
+				if (m_fromCurrent[i] && m_targets[i] != nullptr && elapsed[i] >= 0.f) {
+					from[i] = m_current(m_targets[i], (Property)m_properties[i]);
+					m_fromCurrent[i] = false;
+					m_delayedStarts--;
+				}
+			}
+		}
+		//Ease runs of tracks sharing a curve together
+		for (size_t i = 0; i < count;) {
+			size_t end = i + 1;
+			while (end < count && m_easings[end] == m_easings[i]) {
+				end++;
+			}
+			if (m_easings[i] != Linear) {
+				Easing easing = (Easing)m_easings[i];
+				for (size_t j = i; j < end; j++) {
+					progress[j] = ease(easing, progress[j]);
+				}
+			}
+			i = end;
+		}
+		for (size_t i = 0; i < count; i++) {
+			values[i] = from[i] + (to[i] - from[i]) * progress[i];
+		}
+
+		m_owner->beginUpdate();
+		m_apply(0, count);
+		m_owner->endUpdate();
+
+		//Free finished tracks, then start whatever is chained after them; started after the loop,
+		//so a chained track is applied at least once before it can be freed, even if already past its end
+		m_starting.clear();
+		for (size_t i = 0; i < count; i++) {
+			if (m_targets[i] != nullptr && !m_waiting[i] && !m_fromCurrent[i] && elapsed[i] * inverseDuration[i] >= 1.f) {
+				Uint32 next = m_next[i];
+				float overshoot = elapsed[i] - 1.f / inverseDuration[i];
+				m_next[i] = m_none;
+				m_release((Uint32)i);
+				if (next != m_none) {
+					m_starting.push_back(std::make_pair(next, overshoot));
+				}
+			}
+		}
+		for (const std::pair<Uint32, float> &start : m_starting) {
+			m_previous[start.first] = m_none;
+			m_waiting[start.first] = false;
+			m_elapsed[start.first] = start.second;
+		}
+	}
+
+	float animator::ease(Easing easing, float t) {
+		switch (easing) {
+		case QuadIn:
+			return t * t;
+		case QuadOut:
+			return t * (2.f - t);
+		case QuadInOut:
+			return t < 0.5f ? 2.f * t * t : 1.f - 2.f * (1.f - t) * (1.f - t);
+		case CubicIn:
+			return t * t * t;
+		case CubicOut:
+			t = 1.f - t;
+			return 1.f - t * t * t;
+		case CubicInOut:
+			return t < 0.5f ? 4.f * t * t * t : 1.f - 4.f * (1.f - t) * (1.f - t) * (1.f - t);
+		case SineInOut:
+			return 0.5f - 0.5f * std::cos(t * (float)M_PI);
+		case BackOut: {
+			const float c1 = 1.70158f, c3 = c1 + 1.f;
+			t -= 1.f;
+			return 1.f + c3 * t * t * t + c1 * t * t;
+		}
+		default:
+			return t;
+		}
+	}
+
+
+
+	Uint32 animator::m_allocate(element *target, Property p, float from, float to, Uint32 duration, Easing easing) {
+		Uint32 slot;
+		if (!m_free.empty()) {
+			slot = m_free.back();
+			m_free.pop_back();
+		}
+		else {
+			slot = (Uint32)m_targets.size();
+			m_targets.push_back(nullptr);
+			m_properties.push_back(0);
+			m_easings.push_back(Linear);
+			m_waiting.push_back(false);
+			m_fromCurrent.push_back(false);
+			m_from.push_back(0.f);
+			m_to.push_back(0.f);
+			m_elapsed.push_back(0.f);
+			m_inverseDuration.push_back(0.f);
+			m_progress.push_back(0.f);
+			m_values.push_back(0.f);
+			m_next.push_back(m_none);
+			m_previous.push_back(m_none);
+			m_serials.push_back(0);
+		}
+		m_targets[slot] = target;
+		m_properties[slot] = (Uint8)p;
+		m_easings[slot] = (Uint8)easing;
+		m_waiting[slot] = false;
+		m_fromCurrent[slot] = false;
+		m_from[slot] = from;
+		m_to[slot] = to;
+		m_elapsed[slot] = 0.f;
+		m_inverseDuration[slot] = 1.f / (float)std::max(duration, (Uint32)1);
+		m_next[slot] = m_none;
+		m_previous[slot] = m_none;
+		m_serials[slot]++;
+		if (m_serials[slot] == 0) { //Handles are never 0
+			m_serials[slot] = 1;
+		}
+		m_running++;
+		return slot;
+	}
+	void animator::m_release(Uint32 slot) {
+		if (m_previous[slot] != m_none) { //Whatever ran before it finishes the animation
+			m_next[m_previous[slot]] = m_none;
+			m_previous[slot] = m_none;
+		}
+		while (slot != m_none && m_targets[slot] != nullptr) {
+			if (m_fromCurrent[slot]) {
+				m_fromCurrent[slot] = false;
+				m_delayedStarts--;
+			}
+			m_targets[slot] = nullptr;
+			m_easings[slot] = Linear;
+			m_free.push_back(slot);
+			m_running--;
+			Uint32 next = m_next[slot];
+			m_next[slot] = m_none;
+			if (next != m_none) {
+				m_previous[next] = m_none;
+			}
+			slot = next; //Tracks waiting on this one would never start
+		}
+	}
+	float animator::m_current(element *target, Property p) {
+		SDL_FRect dstrect = target->getDstrect();
+		switch (p) {
+		case X:
+			return dstrect.x;
+		case Y:
+			return dstrect.y;
+		case Width:
+			return dstrect.w;
+		case Height:
+			return dstrect.h;
+		case Angle:
+			return (float)target->getAngle();
+		case Red:
+			return target->getColorMod().r;
+		case Green:
+			return target->getColorMod().g;
+		case Blue:
+			return target->getColorMod().b;
+		case Alpha:
+			return target->getAlphaMod();
+		case CornerX:
+			return ((set*)target)->getRenderCorner().x;
+		case CornerY:
+			return ((set*)target)->getRenderCorner().y;
+		}
+		return 0.f;
+	}
+	void animator::m_apply(size_t first, size_t last) {
+		//Gather every property of an element before setting it, since tracks on one element are usually next to each other
+		element *target = nullptr;
+		SDL_FRect dstrect;
+		double angle = 0;
+		SDL_Color mod;
+		SDL_FPoint corner;
+		bool dstrectChanged = false, angleChanged = false, modChanged = false, cornerChanged = false;
+		auto flush = [&]() {
+			if (target == nullptr) {
+				return;
+			}
+			if (dstrectChanged) {
+				target->setDstrect(dstrect);
+			}
+			if (angleChanged) {
+				target->setAngle(angle);
+			}
+			if (modChanged) {
+				target->setColorMod(mod.r, mod.g, mod.b);
+				target->setAlphaMod(mod.a);
+			}
+			if (cornerChanged) {
+				((set*)target)->setRenderCorner(corner);
+			}
+			dstrectChanged = angleChanged = modChanged = cornerChanged = false;
+		};
+		for (size_t i = first; i < last; i++) {
+			if (m_targets[i] == nullptr || m_waiting[i] || m_elapsed[i] < 0.f) {
+				continue;
+			}
+			if (m_targets[i] != target) {
+				flush();
+				target = m_targets[i];
+				dstrect = target->getDstrect();
+				angle = target->getAngle();
+				mod = target->getColorMod();
+			}
+			float value = m_values[i];
+			switch ((Property)m_properties[i]) {
+			case X:
+				dstrect.x = value;
+				dstrectChanged = true;
+				break;
+			case Y:
+				dstrect.y = value;
+				dstrectChanged = true;
+				break;
+			case Width:
+				dstrect.w = value;
+				dstrectChanged = true;
+				break;
+			case Height:
+				dstrect.h = value;
+				dstrectChanged = true;
+				break;
+			case Angle:
+				angle = value;
+				angleChanged = true;
+				break;
+			case Red:
+				mod.r = m_toByte(value);
+				modChanged = true;
+				break;
+			case Green:
+				mod.g = m_toByte(value);
+				modChanged = true;
+				break;
+			case Blue:
+				mod.b = m_toByte(value);
+				modChanged = true;
+				break;
+			case Alpha:
+				mod.a = m_toByte(value);
+				modChanged = true;
+				break;
+			case CornerX:
+				if (!cornerChanged) {
+					corner = ((set*)target)->getRenderCorner();
+				}
+				corner.x = value;
+				cornerChanged = true;
+				break;
+			case CornerY:
+				if (!cornerChanged) {
+					corner = ((set*)target)->getRenderCorner();
+				}
+				corner.y = value;
+				cornerChanged = true;
+				break;
+			}
+		}
+		flush();
+	}
+
+}
@@ -1,4 +1,5 @@
 #include "./button.hpp"
+#include "./displayList.hpp"
 
 extern "C" {
 #include <SDL2/SDL.h>
@@ -18,7 +19,14 @@ namespace lui {
 	button::~button() {}
 
 	void button::render(SDL_Renderer *renderer) {
-		SDL_RenderCopyExF(renderer, m_texture, srcrect, &m_dstrect, m_angle, &(zeroFPoint), m_flip);
+		SDL_FRect dstrect = m_renderDstrect();
+		m_applyMod(m_texture);
+		renderBackend::get(renderer)->copy(m_texture, srcrect, &dstrect, m_angle, &(zeroFPoint), m_flip);
+		m_clearMod(m_texture);
+	}
+	bool button::record(displayList &list) {
+		list.copy(m_texture, srcrect, m_dstrect, m_angle, m_flip, m_mod);
+		return true;
 	}
 	void button::userLogic(std::vector<SDL_Event> &events, SDL_Renderer *renderer) {
 		element::userLogic(events, renderer);
@@ -26,9 +34,20 @@ namespace lui {
 
 	void button::setTexture(SDL_Texture *texture) {
 		m_texture = texture;
+		invalidate();
 	}
 	SDL_Texture* button::getTexture() {
 		return m_texture;
 	}
+	bool button::pointInElement(const SDL_Point point) {
+		return m_pointOnTexture(point, m_texture, srcrect);
+	}
+	bool button::isOpaque() {
+		if (element::isOpaque()) {
+			return true;
+		}
+		SDL_BlendMode mode;
+		return m_texture != nullptr && srcrect == nullptr && SDL_GetTextureBlendMode(m_texture, &mode) == 0 && mode == SDL_BLENDMODE_NONE;
+	}
 
 }
@@ -0,0 +1,105 @@
+#include "./displayList.hpp"
+#include "./element.hpp"
+#include "./extra.hpp"
+#include "./renderBackend.hpp"
+
+extern "C" {
+#include <SDL2/SDL.h>
+}
+#include <algorithm>
+
+namespace lui {
+
+	namespace {
+		const size_t GroupLookback = 64; //Commands searched back for the same texture
+
+		//Padded by a pixel, since draws touching along a fractional edge may share pixels
+		bool MayOverlap(const SDL_FRect &a, const SDL_FRect &b) {
+			if (a.w <= 0 || a.h <= 0 || b.w <= 0 || b.h <= 0) {
+				return true;
+			}
+			SDL_FRect padded{ a.x - 1.f, a.y - 1.f, a.w + 2.f, a.h + 2.f };
+			return RectsOverlap(padded, b);
+		}
+	}
+
+	void displayList::clear() {
+		m_commands.clear();
+	}
+	void displayList::copy(SDL_Texture *texture, const SDL_Rect *srcrect, const SDL_FRect &dstrect, double angle, SDL_RendererFlip flip, SDL_Color mod) {
+		if (texture == nullptr) {
+			return;
+		}
+		command c;
+		c.texture = texture;
+		if (srcrect != nullptr) {
+			c.srcrect = *srcrect;
+			c.wholeTexture = false;
+		}
+		c.dstrect = dstrect;
+		c.angle = angle;
+		c.flip = flip;
+		c.mod = mod;
+		c.bounds = BoundingBox(dstrect, angle);
+		m_commands.push_back(c);
+	}
+	void displayList::render(element *e) {
+		command c;
+		c.immediate = e;
+		SDL_FRect dr = e->getDstrect();
+		if (dr.w > 0 && dr.h > 0) { //Elements with no size may draw anywhere
+			c.bounds = BoundingBox(dr, e->getRotation());
+		}
+		m_commands.push_back(c);
+	}
+	void displayList::groupByTexture() {
+		for (size_t i = 1; i < m_commands.size(); i++) {
+			const command &c = m_commands[i];
+			if (c.immediate != nullptr || m_commands[i - 1].texture == c.texture) {
+				continue;
+			}
+			//Find the last command with our texture, giving up at anything we may draw over
+			size_t stop = i > GroupLookback ? i - GroupLookback : 0;
+			for (size_t k = i - 1; k + 1 > stop; k--) {
+				const command &other = m_commands[k];
+				if (other.immediate != nullptr || (other.texture != c.texture && MayOverlap(other.bounds, c.bounds))) {
+					break;
+				}
+				if (other.texture == c.texture) {
+					std::rotate(m_commands.begin() + k + 1, m_commands.begin() + i, m_commands.begin() + i + 1);
+					break;
+				}
+			}
+		}
+	}
+	void displayList::replay(SDL_Renderer *renderer, SDL_FPoint offset, const SDL_FRect *area) {
+		renderBackend *backend = renderBackend::get(renderer);
+		for (const command &c : m_commands) {
+			if (area != nullptr && c.bounds.w > 0 && c.bounds.h > 0 && !RectsOverlap(c.bounds, *area)) {
+				continue;
+			}
+			if (c.immediate != nullptr) {
+				c.immediate->render(renderer);
+				continue;
+			}
+			SDL_FRect dstrect{ c.dstrect.x + offset.x, c.dstrect.y + offset.y, c.dstrect.w, c.dstrect.h };
+			bool modulated = (c.mod.r & c.mod.g & c.mod.b & c.mod.a) != 255;
+			SDL_Color saved = { 255, 255, 255, 255 }; //Textures may be shared, so their own modulation is put back
+			if (modulated) {
+				SDL_GetTextureColorMod(c.texture, &saved.r, &saved.g, &saved.b);
+				SDL_GetTextureAlphaMod(c.texture, &saved.a);
+				SDL_SetTextureColorMod(c.texture, c.mod.r, c.mod.g, c.mod.b);
+				SDL_SetTextureAlphaMod(c.texture, c.mod.a);
+			}
+			backend->copy(c.texture, c.wholeTexture ? nullptr : &c.srcrect, &dstrect, c.angle, &zeroFPoint, c.flip);
+			if (modulated) {
+				SDL_SetTextureColorMod(c.texture, saved.r, saved.g, saved.b);
+				SDL_SetTextureAlphaMod(c.texture, saved.a);
+			}
+		}
+	}
+	const std::vector<displayList::command>& displayList::getCommands() const {
+		return m_commands;
+	}
+
+}
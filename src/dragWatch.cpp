@@ -0,0 +1,106 @@
+#include "./dragWatch.hpp"
+
+extern "C" {
+#include <SDL2/SDL.h>
+}
+
+namespace lui {
+
+	dragWatch::dragWatch() {}
+	dragWatch::~dragWatch() {}
+
+	dragWatch& dragWatch::global() {
+		//Never destroyed; the event watch may still fire during shutdown
+		static dragWatch *watch = new dragWatch();
+		return *watch;
+	}
+
+	void dragWatch::setEnabled(bool enabled) {
+		std::lock_guard<std::mutex> enabling(m_enableMutex);
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (enabled == m_enabled) {
+				return;
+			}
+			m_enabled = enabled;
+			if (!enabled) {
+				m_target = nullptr;
+				m_move = nullptr;
+			}
+		}
+		//Outside of the lock, since SDL holds its own lock while calling the watch, which takes ours
+		if (enabled) {
+			SDL_AddEventWatch(m_watch, this);
+		}
+		else {
+			SDL_DelEventWatch(m_watch, this);
+		}
+	}
+	bool dragWatch::isEnabled() {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_enabled;
+	}
+
+	bool dragWatch::begin(const element *target, std::function<void(SDL_FPoint)> move) {
+		int x = 0, y = 0;
+		SDL_GetMouseState(&x, &y);
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_enabled) {
+			return false;
+		}
+		m_target = target;
+		m_move = move;
+		m_position = SDL_FPoint{ (float)x, (float)y };
+		m_moved = false;
+		return true;
+	}
+	void dragWatch::end(const element *target) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_target == target) {
+			m_target = nullptr;
+			m_move = nullptr;
+		}
+	}
+	bool dragWatch::isDragging(const element *target) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_target != nullptr && m_target == target;
+	}
+	void dragWatch::latch(bool pump) {
+		if (pump) {
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (m_target == nullptr) {
+					return; //Don't pump events for nothing
+				}
+			}
+			SDL_PumpEvents(); //The watch is called for each event queued here
+		}
+		std::function<void(SDL_FPoint)> move;
+		SDL_FPoint position;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_target == nullptr || !m_moved) {
+				return;
+			}
+			m_moved = false;
+			move = m_move;
+			position = m_position;
+		}
+		move(position); //Outside of the lock, moving may end the drag
+	}
+
+
+
+	int dragWatch::m_watch(void *userdata, SDL_Event *e) {
+		if (e->type == SDL_MOUSEMOTION) {
+			dragWatch *watch = (dragWatch*)userdata;
+			std::lock_guard<std::mutex> lock(watch->m_mutex);
+			if (watch->m_target != nullptr) {
+				watch->m_position = SDL_FPoint{ (float)e->motion.x, (float)e->motion.y };
+				watch->m_moved = true;
+			}
+		}
+		return 0;
+	}
+
+}
@@ -1,5 +1,8 @@
 #include "./element.hpp"
 #include "./set.hpp"
+#include "./animator.hpp"
+#include "./extra.hpp"
+#include "./alphaMaskCache.hpp"
 
 extern "C" {
 #include <SDL2/SDL.h>
@@ -11,6 +14,8 @@ namespace lui {
 	const SDL_Point zeroPoint{ 0, 0 };
 	const SDL_FPoint zeroFPoint{ 0.f, 0.f };
 
+	thread_local SDL_FPoint element::m_renderOffset{ 0.f, 0.f };
+
 
 
 	element::element() {}
@@ -19,7 +24,17 @@ namespace lui {
 		setAngle(angle);
 		setFlip(flip);
 	}
-	element::~element() {}
+	element::~element() {
+		if (m_parentSet != nullptr && m_parentSet->m_animator != nullptr) {
+			m_parentSet->m_animator->stop(this);
+		}
+		if (m_overlaySet != nullptr) {
+			m_overlaySet->removeOverlay(this);
+		}
+		if (m_pendingListed && m_parentSet != nullptr) {
+			m_parentSet->m_forgetPending(this);
+		}
+	}
 
 	void element::render(SDL_Renderer *renderer) {
 		//Uint8 r, g, b, a;
@@ -32,6 +47,10 @@ namespace lui {
 		//SDL_RenderDrawRect(renderer, &m_dstrect);
 		//SDL_SetRenderDrawColor(renderer, r, g, b, a);
 	}
+	void element::releaseTextures() {}
+	bool element::record(displayList& /*list*/) {
+		return false;
+	}
 	void element::userLogic(std::vector<SDL_Event> &events, SDL_Renderer *renderer) {
 		for (SDL_Event &e : events) {
 			if (m_hasFocus) {
@@ -101,10 +120,33 @@ namespace lui {
 	}
 
 	void element::setSet(set* s) {
-		if (m_parentSet != nullptr) {
-			m_parentSet->removeElement(this);
+		if (m_updatePending && m_parentSet != s) { //Deliver to the set we were in
+			if (m_pendingListed && m_parentSet != nullptr) {
+				m_parentSet->m_forgetPending(this);
+			}
+			m_commitUpdate();
+		}
+		if (m_overlaySet != nullptr && m_parentSet != s) { //Overlays are drawn relative to the parent set
+			m_overlaySet->removeOverlay(this);
+		}
+		Uint32 generation = ++set::m_transformGeneration;
+		if (m_parentSet != nullptr && m_parentSet != s) {
+			set *previous = m_parentSet;
+			m_parentSet = nullptr; //Keeps removeElement() from coming back here
+			previous->m_membershipStamp = generation;
+			previous->removeElement(this);
+		}
+		if (s != nullptr) {
+			s->m_membershipStamp = generation;
 		}
 		m_parentSet = s;
+		set *asSet = dynamic_cast<set*>(this);
+		if (asSet != nullptr) { //Everything inside of us moved in the window
+			asSet->m_transformStamp = generation;
+		}
+	}
+	set* element::getSet() {
+		return m_parentSet;
 	}
 	void element::setFocus(bool hasFocus) {
 		if (hasFocus != m_hasFocus) { //Change detected
@@ -122,9 +164,20 @@ namespace lui {
 	}
 	void element::onFocusUpdated() {}
 	void element::setDstrect(SDL_FRect dr) {
+		if (m_deferring()) {
+			m_deferChange();
+			m_dstrect = dr;
+			m_pendingInvalidate = m_pendingFocus = m_pendingDestRect = true;
+			return;
+		}
+		SDL_FRect before = BoundingBox(m_dstrect, m_rotation);
+		invalidate(); //Where it was
 		m_dstrect = dr;
+		invalidate(); //Where it is
 		if (m_parentSet != nullptr) {
-			m_parentSet->setUpdateFocusElements();
+			SDL_FRect after = BoundingBox(m_dstrect, m_rotation);
+			m_parentSet->setUpdateFocusElements(before, after);
+			m_parentSet->m_contentChanged(&before, &after);
 		}
 		m_callEventFunction(DestRectChanged);
 	}
@@ -132,9 +185,22 @@ namespace lui {
 		return m_dstrect;
 	}
 	void element::setAngle(double a) {
+		if (m_deferring()) {
+			m_deferChange();
+			m_angle = a;
+			m_rotation = rotation(a);
+			m_pendingInvalidate = m_pendingFocus = true;
+			return;
+		}
+		SDL_FRect before = BoundingBox(m_dstrect, m_rotation);
+		invalidate();
 		m_angle = a;
+		m_rotation = rotation(a);
+		invalidate();
 		if (m_parentSet != nullptr) {
-			m_parentSet->setUpdateFocusElements();
+			SDL_FRect after = BoundingBox(m_dstrect, m_rotation);
+			m_parentSet->setUpdateFocusElements(before, after);
+			m_parentSet->m_contentChanged(&before, &after);
 		}
 		//DEPRECATED, Now calls to parent set to indicate potential focus change
 		//Push a SDL_MOUSEMOTION event so the focus is updated in the next frame
@@ -147,18 +213,161 @@ namespace lui {
 	double element::getAngle() {
 		return m_angle;
 	}
+	const rotation& element::getRotation() {
+		return m_rotation;
+	}
 	void element::setFlip(SDL_RendererFlip flip) {
 		m_flip = flip;
+		invalidate();
 	}
 	SDL_RendererFlip element::getFlip() {
 		return m_flip;
 	}
+	void element::setColorMod(Uint8 r, Uint8 g, Uint8 b) {
+		if (r != m_mod.r || g != m_mod.g || b != m_mod.b) {
+			m_mod.r = r;
+			m_mod.g = g;
+			m_mod.b = b;
+			invalidate();
+		}
+	}
+	SDL_Color element::getColorMod() {
+		return m_mod;
+	}
+	void element::setAlphaMod(Uint8 a) {
+		if (a != m_mod.a) {
+			m_mod.a = a;
+			invalidate();
+		}
+	}
+	Uint8 element::getAlphaMod() {
+		return m_mod.a;
+	}
+	void element::m_applyMod(SDL_Texture *texture) {
+		if (texture != nullptr && (m_mod.r & m_mod.g & m_mod.b & m_mod.a) != 255) {
+			SDL_GetTextureColorMod(texture, &m_savedMod.r, &m_savedMod.g, &m_savedMod.b);
+			SDL_GetTextureAlphaMod(texture, &m_savedMod.a);
+			SDL_SetTextureColorMod(texture, m_mod.r, m_mod.g, m_mod.b);
+			SDL_SetTextureAlphaMod(texture, m_mod.a);
+		}
+	}
+	void element::m_clearMod(SDL_Texture *texture) {
+		if (texture != nullptr && (m_mod.r & m_mod.g & m_mod.b & m_mod.a) != 255) {
+			SDL_SetTextureColorMod(texture, m_savedMod.r, m_savedMod.g, m_savedMod.b);
+			SDL_SetTextureAlphaMod(texture, m_savedMod.a);
+		}
+	}
+	void element::setVisible(bool visible) {
+		if (visible != m_visible && m_deferring()) {
+			m_deferChange();
+			m_visible = visible;
+			m_pendingInvalidate = m_pendingFocus = true;
+		}
+		else if (visible != m_visible) {
+			m_visible = visible;
+			invalidate();
+			if (m_parentSet != nullptr) {
+				SDL_FRect bounds = BoundingBox(m_dstrect, m_rotation);
+				m_parentSet->setUpdateFocusElements(bounds, bounds);
+			}
+		}
+	}
+	bool element::isVisible() {
+		return m_visible;
+	}
+	void element::setOpaque(bool opaque) {
+		if (opaque != m_opaque) {
+			m_opaque = opaque;
+			invalidate(); //What is drawn behind it changes
+		}
+	}
+	bool element::isOpaque() {
+		return m_opaque && m_mod.a == 255;
+	}
+	void element::invalidate() {
+		if (m_deferring()) {
+			m_deferChange();
+			m_pendingInvalidate = true;
+			return;
+		}
+		if (m_parentSet != nullptr && m_overlaySet == nullptr) { //The overlay is drawn fresh every frame
+			m_parentSet->invalidateRect(BoundingBox(m_dstrect, m_rotation));
+		}
+	}
+	void element::beginUpdate() {
+		m_updateDepth++;
+	}
+	void element::endUpdate() {
+		if (m_updateDepth > 0 && --m_updateDepth == 0 && m_updatePending) {
+			if (!m_deferring()) {
+				m_commitUpdate();
+			}
+			else if (!m_pendingListed) { //Our set is still updating, let it deliver them
+				m_parentSet->m_addPending(this);
+			}
+		}
+	}
+	bool element::isUpdating() {
+		return m_updateDepth > 0;
+	}
+	bool element::m_deferring() {
+		return m_updateDepth > 0 || (m_parentSet != nullptr && m_parentSet->m_updateDepth > 0);
+	}
+	void element::m_deferChange() {
+		if (!m_updatePending) {
+			m_updatePending = true;
+			m_pendingBounds = BoundingBox(m_dstrect, m_rotation);
+		}
+		if (m_updateDepth == 0 && !m_pendingListed) { //Only held back for our set, so it has to deliver them
+			m_parentSet->m_addPending(this);
+		}
+	}
+	void element::m_commitUpdate() {
+		if (!m_updatePending) {
+			return;
+		}
+		m_updatePending = false;
+		if (m_pendingInvalidate && m_parentSet != nullptr && m_overlaySet == nullptr) {
+			m_parentSet->invalidateRect(m_pendingBounds); //Where it was
+			m_parentSet->invalidateRect(BoundingBox(m_dstrect, m_rotation)); //Where it is
+		}
+		if (m_pendingFocus && m_parentSet != nullptr) {
+			SDL_FRect after = BoundingBox(m_dstrect, m_rotation);
+			m_parentSet->setUpdateFocusElements(m_pendingBounds, after);
+			m_parentSet->m_contentChanged(&m_pendingBounds, &after);
+		}
+		bool destRectChanged = m_pendingDestRect;
+		m_pendingInvalidate = m_pendingFocus = m_pendingDestRect = false;
+		if (destRectChanged) {
+			m_callEventFunction(DestRectChanged);
+		}
+	}
+	bool element::isOverlaid() {
+		return m_overlaySet != nullptr;
+	}
 
+	bool element::m_pointOnTexture(const SDL_Point point, SDL_Texture *texture, const SDL_Rect *srcrect) {
+		if (!element::pointInElement(point)) {
+			return false;
+		}
+		if (texture == nullptr) {
+			return true;
+		}
+		//Undo the angle, then the flip, which SDL applies first
+		SDL_FPoint unrotated = m_rotation.applyInverse({ (float)point.x, (float)point.y }, { m_dstrect.x, m_dstrect.y });
+		float u = (unrotated.x - m_dstrect.x) / m_dstrect.w, v = (unrotated.y - m_dstrect.y) / m_dstrect.h;
+		if (m_flip & SDL_FLIP_HORIZONTAL) {
+			u = 1.f - u;
+		}
+		if (m_flip & SDL_FLIP_VERTICAL) {
+			v = 1.f - v;
+		}
+		return alphaMaskCache::global().sample(texture, srcrect, u, v) != 0; //No mask counts the whole rectangle
+	}
 	bool element::pointInElement(const SDL_Point point) {
 		SDL_Rect temp{ (int)std::round(m_dstrect.x), (int)std::round(m_dstrect.y), (int)std::round(m_dstrect.w), (int)std::round(m_dstrect.h) };
-		SDL_Point translatedPoint;
-		translatedPoint.x = (int)std::round(std::cos(-m_angle * M_PI / 180) * (point.x - m_dstrect.x) - std::sin(-m_angle * M_PI / 180) * (point.y - m_dstrect.y) + m_dstrect.x);
-		translatedPoint.y = (int)std::round(std::sin(-m_angle * M_PI / 180) * (point.x - m_dstrect.x) + std::cos(-m_angle * M_PI / 180) * (point.y - m_dstrect.y) + m_dstrect.y);
+		SDL_FPoint rotated = m_rotation.applyInverse({ (float)point.x, (float)point.y }, { m_dstrect.x, m_dstrect.y });
+		SDL_Point translatedPoint{ (int)std::round(rotated.x), (int)std::round(rotated.y) };
 		return SDL_PointInRect(&translatedPoint, &temp);
 	}
 
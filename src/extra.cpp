@@ -1,9 +1,20 @@
 #include "./extra.hpp"
+#include "./renderBackend.hpp"
 
 extern "C" {
 #include <SDL2/SDL.h>
 }
 #include <cmath> //sin and cos
+#include <algorithm> //min and max
+#include <cstring> //memcmp and memmove
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LUI_EXTRA_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define LUI_EXTRA_NEON
+#include <arm_neon.h>
+#endif
 
 namespace lui {
 	SDL_FPoint PointAlongLine(const SDL_FPoint p1, const SDL_FPoint p2, const float progress) {
@@ -32,36 +43,435 @@ namespace lui {
 		if (segments < 3) {
 			return -1; //Cannot create a curve with no segments, and 1 or 2 segments results in line
 		}
-		
-		SDL_FPoint pPrev = p1; //Previous point is used for connecting the new point to the old, forming a line segment
-		SDL_FPoint pCurr = p1; //Current point used for connecting with previous
+		unsigned int drawn = segmentsToDraw == 0 ? segments : std::min(segments, segmentsToDraw - 1);
+		if (drawn == 0) {
+			return 0;
+		}
 
-		for (unsigned int i = 1; i <= segments && (i < segmentsToDraw || segmentsToDraw == 0); i++) {
-			pPrev = pCurr;
-			pCurr = PointAlongBezierCurve(p1, p1c, p2c, p2, (float)i/segments);
-			SDL_RenderDrawLineF(renderer, pPrev.x, pPrev.y, pCurr.x, pCurr.y);
+		//Forward differencing: step the cubic's polynomial form with three additions per point
+		//instead of solving de Casteljau's construction every time
+		float h = 1.f / segments, h2 = h * h, h3 = h2 * h;
+		SDL_FPoint a = { p2.x - 3.f * p2c.x + 3.f * p1c.x - p1.x, p2.y - 3.f * p2c.y + 3.f * p1c.y - p1.y };
+		SDL_FPoint b = { 3.f * (p2c.x - 2.f * p1c.x + p1.x), 3.f * (p2c.y - 2.f * p1c.y + p1.y) };
+		SDL_FPoint c = { 3.f * (p1c.x - p1.x), 3.f * (p1c.y - p1.y) };
+		SDL_FPoint d1 = { a.x * h3 + b.x * h2 + c.x * h, a.y * h3 + b.y * h2 + c.y * h };
+		SDL_FPoint d2 = { 6.f * a.x * h3 + 2.f * b.x * h2, 6.f * a.y * h3 + 2.f * b.y * h2 };
+		SDL_FPoint d3 = { 6.f * a.x * h3, 6.f * a.y * h3 };
+
+		static thread_local std::vector<SDL_FPoint> points;
+		points.resize(drawn + 1);
+		SDL_FPoint p = p1;
+		points[0] = p;
+		for (unsigned int i = 1; i <= drawn; i++) {
+			p.x += d1.x;
+			p.y += d1.y;
+			d1.x += d2.x;
+			d1.y += d2.y;
+			d2.x += d3.x;
+			d2.y += d3.y;
+			points[i] = p;
+		}
+		if (drawn == segments) {
+			points[drawn] = p2; //No rounding error at the end
 		}
+		return renderBackend::get(renderer)->drawLines(points.data(), (int)points.size());
+	}
 
-		return 0;
+	size_t FlattenBezierCurve(std::vector<SDL_FPoint> &points, const SDL_FPoint p1, const SDL_FPoint p1c, const SDL_FPoint p2c, const SDL_FPoint p2, float tolerance) {
+		size_t before = points.size();
+		if (points.empty() || points.back().x != p1.x || points.back().y != p1.y) {
+			points.push_back(p1);
+		}
+		//A curve stays inside the hull of its points, so it is flat enough once both control points are close enough to the chord
+		float limit = tolerance * tolerance;
+		auto distanceToChord = [](SDL_FPoint p, SDL_FPoint a, SDL_FPoint b) {
+			float dx = b.x - a.x, dy = b.y - a.y, length = dx * dx + dy * dy;
+			float t = length > 0.f ? std::min(std::max(((p.x - a.x) * dx + (p.y - a.y) * dy) / length, 0.f), 1.f) : 0.f;
+			float x = a.x + dx * t - p.x, y = a.y + dy * t - p.y;
+			return x * x + y * y; //Squared
+		};
+		bezierCurve stack[17]; //Each split pushes one half, so the depth limit bounds it
+		int depths[17];
+		int top = 0;
+		stack[0] = bezierCurve{ p1, p1c, p2c, p2 };
+		depths[0] = 0;
+		while (top >= 0) {
+			bezierCurve curve = stack[top];
+			int depth = depths[top];
+			top--;
+			if (depth >= 16 || std::max(distanceToChord(curve.p1c, curve.p1, curve.p2), distanceToChord(curve.p2c, curve.p1, curve.p2)) <= limit) {
+				points.push_back(curve.p2);
+				continue;
+			}
+			//Split at the middle; push the second half first so the first is flattened first
+			SDL_FPoint a = PointAlongLine(curve.p1, curve.p1c), b = PointAlongLine(curve.p1c, curve.p2c), c = PointAlongLine(curve.p2c, curve.p2);
+			SDL_FPoint d = PointAlongLine(a, b), e = PointAlongLine(b, c);
+			SDL_FPoint mid = PointAlongLine(d, e);
+			top++;
+			stack[top] = bezierCurve{ mid, e, c, curve.p2 };
+			depths[top] = depth + 1;
+			top++;
+			stack[top] = bezierCurve{ curve.p1, a, d, mid };
+			depths[top] = depth + 1;
+		}
+		return points.size() - before;
+	}
+
+	int RenderBezierCurves(SDL_Renderer* renderer, const std::vector<bezierCurve> &curves, float tolerance) {
+		static thread_local std::vector<SDL_FPoint> points;
+		renderBackend *backend = renderBackend::get(renderer);
+		int result = 0;
+		for (const bezierCurve &curve : curves) {
+			points.clear();
+			FlattenBezierCurve(points, curve.p1, curve.p1c, curve.p2c, curve.p2, tolerance);
+			if (backend->drawLines(points.data(), (int)points.size()) != 0) {
+				result = -1;
+			}
+		}
+		return result;
+	}
+
+	int RenderThickBezierCurves(SDL_Renderer* renderer, const std::vector<bezierCurve> &curves, float thickness, SDL_Color color, float tolerance) {
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+		static thread_local std::vector<SDL_FPoint> points;
+		static thread_local std::vector<SDL_Vertex> vertices;
+		static thread_local std::vector<int> indices;
+		vertices.clear();
+		indices.clear();
+		//Solid core, then a pixel fading out on each side. Thinner than a pixel fades the core instead
+		float core = std::max(thickness / 2.f - 0.5f, 0.f), fringe = core + 1.f;
+		SDL_Color solid = color, clear = color;
+		if (thickness < 1.f) {
+			solid.a = (Uint8)(color.a * std::max(thickness, 0.f));
+		}
+		clear.a = 0;
+		for (const bezierCurve &curve : curves) {
+			points.clear();
+			FlattenBezierCurve(points, curve.p1, curve.p1c, curve.p2c, curve.p2, tolerance);
+			size_t count = points.size();
+			if (count < 2) {
+				continue;
+			}
+			int first = (int)vertices.size();
+			for (size_t i = 0; i < count; i++) {
+				//Normal of the segments on either side, mitred where they meet
+				SDL_FPoint in = i > 0 ? SDL_FPoint{ points[i].x - points[i - 1].x, points[i].y - points[i - 1].y } : SDL_FPoint{ points[1].x - points[0].x, points[1].y - points[0].y };
+				SDL_FPoint out = i + 1 < count ? SDL_FPoint{ points[i + 1].x - points[i].x, points[i + 1].y - points[i].y } : in;
+				float inLength = std::sqrt(in.x * in.x + in.y * in.y), outLength = std::sqrt(out.x * out.x + out.y * out.y);
+				SDL_FPoint inNormal = inLength > 0.f ? SDL_FPoint{ -in.y / inLength, in.x / inLength } : SDL_FPoint{ 0.f, 0.f };
+				SDL_FPoint outNormal = outLength > 0.f ? SDL_FPoint{ -out.y / outLength, out.x / outLength } : inNormal;
+				SDL_FPoint normal = { inNormal.x + outNormal.x, inNormal.y + outNormal.y };
+				float normalLength = std::sqrt(normal.x * normal.x + normal.y * normal.y);
+				float miter = 1.f;
+				if (normalLength > 0.f) {
+					normal.x /= normalLength;
+					normal.y /= normalLength;
+					float cosine = normal.x * outNormal.x + normal.y * outNormal.y;
+					miter = std::min(1.f / std::max(cosine, 0.01f), 2.f); //Keep sharp turns from spiking
+				}
+				else {
+					normal = outNormal;
+				}
+				const float offsets[4] = { -fringe, -core, core, fringe };
+				for (int j = 0; j < 4; j++) {
+					SDL_Vertex v;
+					v.position = SDL_FPoint{ points[i].x + normal.x * offsets[j] * miter, points[i].y + normal.y * offsets[j] * miter };
+					v.color = j == 0 || j == 3 ? clear : solid;
+					v.tex_coord = SDL_FPoint{ 0.f, 0.f };
+					vertices.push_back(v);
+				}
+				if (i > 0) { //Three strips between this point and the last: fringe, core, fringe
+					int previous = first + (int)(i - 1) * 4, current = previous + 4;
+					for (int j = 0; j < 3; j++) {
+						const int quad[6] = { previous + j, previous + j + 1, current + j + 1, previous + j, current + j + 1, current + j };
+						indices.insert(indices.end(), quad, quad + 6);
+					}
+				}
+			}
+		}
+		if (indices.empty()) {
+			return 0;
+		}
+		return renderBackend::get(renderer)->geometry(nullptr, vertices.data(), (int)vertices.size(), indices.data(), (int)indices.size());
+#else
+		renderBackend *backend = renderBackend::get(renderer);
+		Uint8 r, g, b, a;
+		backend->getDrawColor(&r, &g, &b, &a);
+		backend->setDrawColor(color.r, color.g, color.b, color.a);
+		int result = RenderBezierCurves(renderer, curves, tolerance);
+		backend->setDrawColor(r, g, b, a);
+		return result;
+#endif
 	}
 
 
+	static_assert(sizeof(bezierCurve) == 8 * sizeof(float), "bezierCurve must be eight packed floats to be loaded four curves at a time");
+
+	void PointsAlongBezierCurves(const bezierCurve *curves, const float *t, size_t count, SDL_FPoint *positions, SDL_FPoint *tangents) {
+		size_t i = 0;
+#if defined(LUI_EXTRA_SSE2)
+		const __m128 one = _mm_set1_ps(1.f), three = _mm_set1_ps(3.f), six = _mm_set1_ps(6.f);
+		for (; i + 4 <= count; i += 4) {
+			//Four curves in, one vector per coordinate out
+			const float *c = (const float*)(curves + i);
+			__m128 p1x = _mm_loadu_ps(c), p1y = _mm_loadu_ps(c + 8), p1cx = _mm_loadu_ps(c + 16), p1cy = _mm_loadu_ps(c + 24);
+			__m128 p2cx = _mm_loadu_ps(c + 4), p2cy = _mm_loadu_ps(c + 12), p2x = _mm_loadu_ps(c + 20), p2y = _mm_loadu_ps(c + 28);
+			_MM_TRANSPOSE4_PS(p1x, p1y, p1cx, p1cy);
+			_MM_TRANSPOSE4_PS(p2cx, p2cy, p2x, p2y);
+
+			__m128 tt = _mm_loadu_ps(t + i), u = _mm_sub_ps(one, tt);
+			__m128 uu = _mm_mul_ps(u, u), tt2 = _mm_mul_ps(tt, tt);
+			__m128 w0 = _mm_mul_ps(uu, u), w1 = _mm_mul_ps(_mm_mul_ps(three, uu), tt), w2 = _mm_mul_ps(_mm_mul_ps(three, u), tt2), w3 = _mm_mul_ps(tt2, tt);
+			__m128 x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(w0, p1x), _mm_mul_ps(w1, p1cx)), _mm_add_ps(_mm_mul_ps(w2, p2cx), _mm_mul_ps(w3, p2x)));
+			__m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(w0, p1y), _mm_mul_ps(w1, p1cy)), _mm_add_ps(_mm_mul_ps(w2, p2cy), _mm_mul_ps(w3, p2y)));
+			_mm_storeu_ps((float*)(positions + i), _mm_unpacklo_ps(x, y));
+			_mm_storeu_ps((float*)(positions + i + 2), _mm_unpackhi_ps(x, y));
+
+			if (tangents != nullptr) {
+				__m128 d0 = _mm_mul_ps(three, uu), d1 = _mm_mul_ps(_mm_mul_ps(six, u), tt), d2 = _mm_mul_ps(three, tt2);
+				x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(d0, _mm_sub_ps(p1cx, p1x)), _mm_mul_ps(d1, _mm_sub_ps(p2cx, p1cx))), _mm_mul_ps(d2, _mm_sub_ps(p2x, p2cx)));
+				y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(d0, _mm_sub_ps(p1cy, p1y)), _mm_mul_ps(d1, _mm_sub_ps(p2cy, p1cy))), _mm_mul_ps(d2, _mm_sub_ps(p2y, p2cy)));
+				_mm_storeu_ps((float*)(tangents + i), _mm_unpacklo_ps(x, y));
+				_mm_storeu_ps((float*)(tangents + i + 2), _mm_unpackhi_ps(x, y));
+			}
+		}
+#elif defined(LUI_EXTRA_NEON)
+		for (; i + 4 <= count; i += 4) {
+			//Four curves in, one vector per coordinate out
+			const float *c = (const float*)(curves + i);
+			float32x4_t low[4], high[4];
+			for (int j = 0; j < 4; j++) {
+				low[j] = vld1q_f32(c + j * 8);
+				high[j] = vld1q_f32(c + j * 8 + 4);
+			}
+			float32x4x2_t l01 = vtrnq_f32(low[0], low[1]), l23 = vtrnq_f32(low[2], low[3]);
+			float32x4x2_t h01 = vtrnq_f32(high[0], high[1]), h23 = vtrnq_f32(high[2], high[3]);
+			float32x4_t p1x = vcombine_f32(vget_low_f32(l01.val[0]), vget_low_f32(l23.val[0])), p1y = vcombine_f32(vget_low_f32(l01.val[1]), vget_low_f32(l23.val[1]));
+			float32x4_t p1cx = vcombine_f32(vget_high_f32(l01.val[0]), vget_high_f32(l23.val[0])), p1cy = vcombine_f32(vget_high_f32(l01.val[1]), vget_high_f32(l23.val[1]));
+			float32x4_t p2cx = vcombine_f32(vget_low_f32(h01.val[0]), vget_low_f32(h23.val[0])), p2cy = vcombine_f32(vget_low_f32(h01.val[1]), vget_low_f32(h23.val[1]));
+			float32x4_t p2x = vcombine_f32(vget_high_f32(h01.val[0]), vget_high_f32(h23.val[0])), p2y = vcombine_f32(vget_high_f32(h01.val[1]), vget_high_f32(h23.val[1]));
+
+			float32x4_t tt = vld1q_f32(t + i), u = vsubq_f32(vdupq_n_f32(1.f), tt);
+			float32x4_t uu = vmulq_f32(u, u), tt2 = vmulq_f32(tt, tt);
+			float32x4_t w0 = vmulq_f32(uu, u), w1 = vmulq_n_f32(vmulq_f32(uu, tt), 3.f), w2 = vmulq_n_f32(vmulq_f32(u, tt2), 3.f), w3 = vmulq_f32(tt2, tt);
+			float32x4x2_t out;
+			out.val[0] = vmlaq_f32(vmlaq_f32(vmlaq_f32(vmulq_f32(w0, p1x), w1, p1cx), w2, p2cx), w3, p2x);
+			out.val[1] = vmlaq_f32(vmlaq_f32(vmlaq_f32(vmulq_f32(w0, p1y), w1, p1cy), w2, p2cy), w3, p2y);
+			vst2q_f32((float*)(positions + i), out);
+
+			if (tangents != nullptr) {
+				float32x4_t d0 = vmulq_n_f32(uu, 3.f), d1 = vmulq_n_f32(vmulq_f32(u, tt), 6.f), d2 = vmulq_n_f32(tt2, 3.f);
+				out.val[0] = vmlaq_f32(vmlaq_f32(vmulq_f32(d0, vsubq_f32(p1cx, p1x)), d1, vsubq_f32(p2cx, p1cx)), d2, vsubq_f32(p2x, p2cx));
+				out.val[1] = vmlaq_f32(vmlaq_f32(vmulq_f32(d0, vsubq_f32(p1cy, p1y)), d1, vsubq_f32(p2cy, p1cy)), d2, vsubq_f32(p2y, p2cy));
+				vst2q_f32((float*)(tangents + i), out);
+			}
+		}
+#endif
+		for (; i < count; i++) {
+			const bezierCurve &c = curves[i];
+			float tt = t[i], u = 1.f - tt;
+			float w0 = u * u * u, w1 = 3.f * u * u * tt, w2 = 3.f * u * tt * tt, w3 = tt * tt * tt;
+			positions[i].x = w0 * c.p1.x + w1 * c.p1c.x + w2 * c.p2c.x + w3 * c.p2.x;
+			positions[i].y = w0 * c.p1.y + w1 * c.p1c.y + w2 * c.p2c.y + w3 * c.p2.y;
+			if (tangents != nullptr) {
+				float d0 = 3.f * u * u, d1 = 6.f * u * tt, d2 = 3.f * tt * tt;
+				tangents[i].x = d0 * (c.p1c.x - c.p1.x) + d1 * (c.p2c.x - c.p1c.x) + d2 * (c.p2.x - c.p2c.x);
+				tangents[i].y = d0 * (c.p1c.y - c.p1.y) + d1 * (c.p2c.y - c.p1c.y) + d2 * (c.p2.y - c.p2c.y);
+			}
+		}
+	}
+
+	arcLengthTable::arcLengthTable(const bezierCurve &curve, unsigned int samples) {
+		build(curve, samples);
+	}
+	bool arcLengthTable::build(const bezierCurve &curve, unsigned int samples) {
+		samples = std::max(samples, 1u);
+		if (m_lengths.size() == samples + 1 && std::memcmp(&curve, &m_curve, sizeof(bezierCurve)) == 0) {
+			return false;
+		}
+		m_curve = curve;
+		static thread_local std::vector<bezierCurve> curves;
+		static thread_local std::vector<float> t;
+		static thread_local std::vector<SDL_FPoint> points;
+		curves.assign(samples + 1, curve);
+		t.resize(samples + 1);
+		points.resize(samples + 1);
+		for (unsigned int i = 0; i <= samples; i++) {
+			t[i] = (float)i / samples;
+		}
+		PointsAlongBezierCurves(curves.data(), t.data(), samples + 1, points.data());
+		m_lengths.resize(samples + 1);
+		m_lengths[0] = 0.f;
+		for (unsigned int i = 1; i <= samples; i++) {
+			m_lengths[i] = m_lengths[i - 1] + std::hypot(points[i].x - points[i - 1].x, points[i].y - points[i - 1].y);
+		}
+		return true;
+	}
+	float arcLengthTable::getLength() const {
+		return m_lengths.empty() ? 0.f : m_lengths.back();
+	}
+	float arcLengthTable::parameterAt(float distance) const {
+		if (m_lengths.size() < 2 || distance <= 0.f) {
+			return 0.f;
+		}
+		if (distance >= m_lengths.back()) {
+			return 1.f;
+		}
+		//First sample past the distance, then straight between it and the one before
+		size_t after = std::upper_bound(m_lengths.begin(), m_lengths.end(), distance) - m_lengths.begin();
+		float start = m_lengths[after - 1], span = m_lengths[after] - start;
+		float within = span > 0.f ? (distance - start) / span : 0.f;
+		return ((float)(after - 1) + within) / (float)(m_lengths.size() - 1);
+	}
+	void arcLengthTable::parametersAt(const float *distances, size_t count, float *t) const {
+		for (size_t i = 0; i < count; i++) {
+			t[i] = parameterAt(distances[i]);
+		}
+	}
+
 	SDL_FPoint RotatePoint(SDL_FPoint point, double degrees, SDL_FPoint pivot) {
-		if (std::fmod(degrees, 360.) == 0) {
-			return point;
+		return rotation(degrees).apply(point, pivot);
+	}
+
+	SDL_FRect BoundingBox(SDL_FRect rect, double degrees) {
+		return BoundingBox(rect, rotation(degrees));
+	}
+
+	rotation::rotation(double deg) {
+		degrees = deg;
+		if (std::fmod(deg, 360.) != 0) {
+			double rad = deg / 180 * M_PI;
+			cosine = (float)std::cos(rad);
+			sine = (float)std::sin(rad);
+			identity = false;
 		}
-		SDL_FPoint returnPoint;
-		double rad = degrees / 180 * M_PI;
+	}
 
-		point.x -= pivot.x;
-		point.y -= pivot.y;
+	SDL_FRect BoundingBox(SDL_FRect rect, const rotation &r) {
+		if (r.identity) {
+			return rect;
+		}
+		//The pivot corner doesn't move, and the other three are offset by the turned width, the turned height, or both
+		float wx = rect.w * r.cosine, wy = rect.w * r.sine, hx = -rect.h * r.sine, hy = rect.h * r.cosine;
+		float minX = rect.x + std::min(wx, 0.f) + std::min(hx, 0.f), maxX = rect.x + std::max(wx, 0.f) + std::max(hx, 0.f);
+		float minY = rect.y + std::min(wy, 0.f) + std::min(hy, 0.f), maxY = rect.y + std::max(wy, 0.f) + std::max(hy, 0.f);
+		return SDL_FRect{ minX, minY, maxX - minX, maxY - minY };
+	}
 
-		returnPoint.x = point.x*std::cos(rad) - point.y*std::sin(rad);
-		returnPoint.y = point.y*std::cos(rad) + point.x*std::sin(rad);
+	void RotatePoints(const rotation &r, const SDL_FPoint *points, size_t count, SDL_FPoint *rotated, SDL_FPoint pivot) {
+		size_t i = 0;
+		if (r.identity) {
+			if (rotated != points) {
+				std::memmove(rotated, points, count * sizeof(SDL_FPoint));
+			}
+			return;
+		}
+#if defined(LUI_EXTRA_SSE2)
+		//Two points per vector: (x, y) * cosine + (y, x) * (-sine, sine)
+		const __m128 cosine = _mm_set1_ps(r.cosine), sine = _mm_setr_ps(-r.sine, r.sine, -r.sine, r.sine);
+		const __m128 center = _mm_setr_ps(pivot.x, pivot.y, pivot.x, pivot.y);
+		for (; i + 2 <= count; i += 2) {
+			__m128 p = _mm_sub_ps(_mm_loadu_ps((const float*)(points + i)), center);
+			__m128 swapped = _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 3, 0, 1));
+			_mm_storeu_ps((float*)(rotated + i), _mm_add_ps(_mm_add_ps(_mm_mul_ps(p, cosine), _mm_mul_ps(swapped, sine)), center));
+		}
+#elif defined(LUI_EXTRA_NEON)
+		const float32x4_t cx = vdupq_n_f32(pivot.x), cy = vdupq_n_f32(pivot.y);
+		for (; i + 4 <= count; i += 4) {
+			float32x4x2_t p = vld2q_f32((const float*)(points + i));
+			float32x4_t x = vsubq_f32(p.val[0], cx), y = vsubq_f32(p.val[1], cy);
+			p.val[0] = vaddq_f32(vmlsq_n_f32(vmulq_n_f32(x, r.cosine), y, r.sine), cx);
+			p.val[1] = vaddq_f32(vmlaq_n_f32(vmulq_n_f32(y, r.cosine), x, r.sine), cy);
+			vst2q_f32((float*)(rotated + i), p);
+		}
+#endif
+		for (; i < count; i++) {
+			float x = points[i].x - pivot.x, y = points[i].y - pivot.y;
+			rotated[i].x = x * r.cosine - y * r.sine + pivot.x;
+			rotated[i].y = y * r.cosine + x * r.sine + pivot.y;
+		}
+	}
+
+	void RectCorners(const rotation &r, const SDL_FRect *rects, size_t count, SDL_FPoint *corners) {
+		size_t i = 0;
+		//Upper-right is the corner plus the turned width, lower-left plus the turned height, lower-right plus both
+#if defined(LUI_EXTRA_SSE2)
+		const __m128 widthTop = _mm_setr_ps(0.f, 0.f, r.cosine, r.sine), widthBottom = _mm_setr_ps(r.cosine, r.sine, 0.f, 0.f);
+		const __m128 height = _mm_setr_ps(-r.sine, r.cosine, -r.sine, r.cosine);
+		for (; i < count; i++) {
+			__m128 rect = _mm_loadu_ps((const float*)(rects + i));
+			__m128 xy = _mm_movelh_ps(rect, rect), w = _mm_shuffle_ps(rect, rect, _MM_SHUFFLE(2, 2, 2, 2)), h = _mm_shuffle_ps(rect, rect, _MM_SHUFFLE(3, 3, 3, 3));
+			_mm_storeu_ps((float*)(corners + i * 4), _mm_add_ps(xy, _mm_mul_ps(w, widthTop)));
+			_mm_storeu_ps((float*)(corners + i * 4 + 2), _mm_add_ps(_mm_add_ps(xy, _mm_mul_ps(w, widthBottom)), _mm_mul_ps(h, height)));
+		}
+#elif defined(LUI_EXTRA_NEON)
+		const float widthTopValues[4] = { 0.f, 0.f, r.cosine, r.sine }, widthBottomValues[4] = { r.cosine, r.sine, 0.f, 0.f };
+		const float heightValues[4] = { -r.sine, r.cosine, -r.sine, r.cosine };
+		const float32x4_t widthTop = vld1q_f32(widthTopValues), widthBottom = vld1q_f32(widthBottomValues), height = vld1q_f32(heightValues);
+		for (; i < count; i++) {
+			float32x2_t corner = vld1_f32((const float*)(rects + i));
+			float32x4_t xy = vcombine_f32(corner, corner);
+			vst1q_f32((float*)(corners + i * 4), vmlaq_n_f32(xy, widthTop, rects[i].w));
+			vst1q_f32((float*)(corners + i * 4 + 2), vmlaq_n_f32(vmlaq_n_f32(xy, widthBottom, rects[i].w), height, rects[i].h));
+		}
+#endif
+		for (; i < count; i++) {
+			const SDL_FRect &rect = rects[i];
+			float wx = rect.w * r.cosine, wy = rect.w * r.sine, hx = -rect.h * r.sine, hy = rect.h * r.cosine;
+			SDL_FPoint *c = corners + i * 4;
+			c[0] = SDL_FPoint{ rect.x, rect.y };
+			c[1] = SDL_FPoint{ rect.x + wx, rect.y + wy };
+			c[2] = SDL_FPoint{ rect.x + wx + hx, rect.y + wy + hy };
+			c[3] = SDL_FPoint{ rect.x + hx, rect.y + hy };
+		}
+	}
 
-		returnPoint.x += pivot.x;
-		returnPoint.y += pivot.y;
+	bool RectsOverlap(const SDL_FRect &a, const SDL_FRect &b) {
+		return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+	}
+	SDL_FRect UnionRect(const SDL_FRect &a, const SDL_FRect &b) {
+		float x = std::min(a.x, b.x), y = std::min(a.y, b.y);
+		return SDL_FRect{ x, y, std::max(a.x + a.w, b.x + b.w) - x, std::max(a.y + a.h, b.y + b.h) - y };
+	}
+	bool RectContains(const SDL_FRect &outer, const SDL_FRect &inner) {
+		return inner.x >= outer.x && inner.y >= outer.y && inner.x + inner.w <= outer.x + outer.w && inner.y + inner.h <= outer.y + outer.h;
+	}
 
-		return returnPoint;
+	size_t CoalesceEvents(std::vector<SDL_Event> &events) {
+		size_t kept = 0;
+		for (size_t i = 0; i < events.size(); i++) {
+			SDL_Event &e = events[i];
+			if (kept > 0) {
+				SDL_Event &last = events[kept - 1];
+				if (e.type == SDL_MOUSEMOTION && last.type == SDL_MOUSEMOTION && e.motion.windowID == last.motion.windowID && e.motion.which == last.motion.which) {
+					Sint32 xrel = last.motion.xrel + e.motion.xrel, yrel = last.motion.yrel + e.motion.yrel;
+					last = e; //Latest position, state, and timestamp
+					last.motion.xrel = xrel;
+					last.motion.yrel = yrel;
+					continue;
+				}
+				if (e.type == SDL_MOUSEWHEEL && last.type == SDL_MOUSEWHEEL && e.wheel.windowID == last.wheel.windowID && e.wheel.which == last.wheel.which && e.wheel.direction == last.wheel.direction) {
+					last.wheel.timestamp = e.wheel.timestamp;
+					last.wheel.x += e.wheel.x;
+					last.wheel.y += e.wheel.y;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+					last.wheel.preciseX += e.wheel.preciseX;
+					last.wheel.preciseY += e.wheel.preciseY;
+#endif
+#if SDL_VERSION_ATLEAST(2, 26, 0)
+					last.wheel.mouseX = e.wheel.mouseX;
+					last.wheel.mouseY = e.wheel.mouseY;
+#endif
+					continue;
+				}
+			}
+			if (kept != i) {
+				events[kept] = e;
+			}
+			kept++;
+		}
+		size_t removed = events.size() - kept;
+		events.resize(kept);
+		return removed;
 	}
 };
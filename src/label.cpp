@@ -0,0 +1,80 @@
+#include "./label.hpp"
+#include "./textCache.hpp"
+
+extern "C" {
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+}
+#include <algorithm>
+#include <cmath>
+
+namespace lui {
+
+	label::label(TTF_Font *font, const std::string &text) {
+		setFont(font);
+		setText(text);
+	}
+	label::label(TTF_Font *font, const std::string &text, const SDL_FRect dstrect, const double angle, const SDL_RendererFlip flip) {
+		setFont(font);
+		setText(text);
+		setDstrect(dstrect);
+		setAngle(angle);
+		setFlip(flip);
+	}
+	label::~label() {}
+
+	void label::render(SDL_Renderer *renderer) {
+		int w = 0, h = 0;
+		SDL_Texture *texture = textCache::global().getTexture(renderer, m_font, m_text, m_textHash, m_color, &w, &h);
+		if (texture == nullptr) {
+			return; //Nothing to show
+		}
+		SDL_Rect srcrect{ 0, 0, w, h };
+		if (m_dstrect.w > 0 && m_dstrect.h > 0) { //Clip to dstrect
+			srcrect.w = std::min(w, (int)std::round(m_dstrect.w));
+			srcrect.h = std::min(h, (int)std::round(m_dstrect.h));
+		}
+		SDL_FRect dstrect = m_renderDstrect();
+		dstrect.w = (float)srcrect.w;
+		dstrect.h = (float)srcrect.h;
+		m_applyMod(texture);
+		renderBackend::get(renderer)->copy(texture, &srcrect, &dstrect, m_angle, &zeroFPoint, m_flip);
+		m_clearMod(texture);
+	}
+
+	void label::setText(const std::string &text) {
+		m_text = text;
+		m_textHash = textCache::hashString(m_text);
+		invalidate();
+	}
+	std::string label::getText() {
+		return m_text;
+	}
+	void label::setFont(TTF_Font *font) {
+		m_font = font;
+		invalidate();
+	}
+	TTF_Font* label::getFont() {
+		return m_font;
+	}
+	void label::setColor(SDL_Color clr) {
+		m_color = clr;
+		invalidate();
+	}
+	SDL_Color label::getColor() {
+		return m_color;
+	}
+	SDL_Point label::getTextSize() {
+		SDL_Point size{ 0, 0 };
+		textCache::global().size(m_font, m_text, m_textHash, &size.x, &size.y);
+		return size;
+	}
+	void label::fitToText() {
+		SDL_Point size = getTextSize();
+		SDL_FRect dr = m_dstrect;
+		dr.w = (float)size.x;
+		dr.h = (float)size.y;
+		setDstrect(dr);
+	}
+
+}
@@ -0,0 +1,181 @@
+#include "./renderBackend.hpp"
+#include "./surfaceBackend.hpp" //surfaceBackend::unshareTexture
+#include "./alphaMaskCache.hpp"
+
+extern "C" {
+#include <SDL2/SDL.h>
+}
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace lui {
+
+	namespace {
+		struct backendRegistry {
+			std::recursive_mutex mutex; //Recursive, since backends register and unregister themselves while the registry is changed
+			std::unordered_map<SDL_Renderer*, renderBackend*> backends;
+			std::unordered_map<SDL_Renderer*, std::unique_ptr<renderBackend>> defaults; //sdlBackends made by get()
+			std::atomic<Uint32> generation{ 1 }; //Bumped on every change, so threads know their last lookup is stale
+		};
+		backendRegistry& Registry() {
+			//Never destroyed; backends may outlive static destruction
+			static backendRegistry *registry = new backendRegistry();
+			return *registry;
+		}
+	}
+
+	renderBackend::renderBackend(SDL_Renderer *renderer) {
+		m_renderer = renderer;
+	}
+	renderBackend::~renderBackend() {
+		detach();
+	}
+	void renderBackend::m_forgetTexture(SDL_Texture* /*texture*/) {}
+
+	void renderBackend::attach() {
+		backendRegistry &registry = Registry();
+		std::lock_guard<std::recursive_mutex> lock(registry.mutex);
+		registry.backends[m_renderer] = this;
+		registry.generation++;
+		auto made = registry.defaults.find(m_renderer);
+		if (made != registry.defaults.end() && made->second.get() != this) { //Replaced
+			std::unique_ptr<renderBackend> old = std::move(made->second);
+			registry.defaults.erase(made);
+		}
+	}
+	void renderBackend::detach() {
+		backendRegistry &registry = Registry();
+		std::lock_guard<std::recursive_mutex> lock(registry.mutex);
+		auto found = registry.backends.find(m_renderer);
+		if (found != registry.backends.end() && found->second == this) {
+			registry.backends.erase(found);
+			registry.generation++;
+		}
+	}
+
+	renderBackend* renderBackend::get(SDL_Renderer *renderer) {
+		thread_local SDL_Renderer *lastRenderer = nullptr;
+		thread_local renderBackend *lastBackend = nullptr;
+		thread_local Uint32 lastGeneration = 0;
+		backendRegistry &registry = Registry();
+		Uint32 generation = registry.generation.load();
+		if (renderer == lastRenderer && generation == lastGeneration && lastBackend != nullptr) {
+			return lastBackend;
+		}
+		std::lock_guard<std::recursive_mutex> lock(registry.mutex);
+		auto found = registry.backends.find(renderer);
+		renderBackend *backend = nullptr;
+		if (found != registry.backends.end()) {
+			backend = found->second;
+		}
+		else {
+			backend = new sdlBackend(renderer);
+			registry.defaults[renderer].reset(backend);
+			backend->attach();
+		}
+		lastRenderer = renderer;
+		lastBackend = backend;
+		lastGeneration = registry.generation.load();
+		return backend;
+	}
+	void renderBackend::clearRenderer(SDL_Renderer *renderer) {
+		backendRegistry &registry = Registry();
+		std::lock_guard<std::recursive_mutex> lock(registry.mutex);
+		auto made = registry.defaults.find(renderer);
+		if (made != registry.defaults.end()) {
+			std::unique_ptr<renderBackend> old = std::move(made->second);
+			registry.defaults.erase(made);
+		}
+	}
+	void renderBackend::destroyTexture(SDL_Texture *texture) {
+		if (texture == nullptr) {
+			return;
+		}
+		backendRegistry &registry = Registry();
+		{
+			std::lock_guard<std::recursive_mutex> lock(registry.mutex);
+			for (auto &b : registry.backends) {
+				b.second->m_forgetTexture(texture);
+			}
+		}
+		surfaceBackend::unshareTexture(texture);
+		alphaMaskCache::global().remove(texture);
+		SDL_DestroyTexture(texture);
+	}
+
+	SDL_Renderer* renderBackend::getRenderer() {
+		return m_renderer;
+	}
+
+
+
+	sdlBackend::sdlBackend(SDL_Renderer *renderer) : renderBackend(renderer) {}
+
+	SDL_Texture* sdlBackend::createTexture(Uint32 format, int access, int w, int h) {
+		return SDL_CreateTexture(getRenderer(), format, access, w, h);
+	}
+	SDL_Texture* sdlBackend::createTextureFromSurface(SDL_Surface *surface) {
+		return SDL_CreateTextureFromSurface(getRenderer(), surface);
+	}
+	int sdlBackend::updateTexture(SDL_Texture *texture, const SDL_Rect *rect, const void *pixels, int pitch) {
+		return SDL_UpdateTexture(texture, rect, pixels, pitch);
+	}
+	int sdlBackend::setTarget(SDL_Texture *texture) {
+		return SDL_SetRenderTarget(getRenderer(), texture);
+	}
+	SDL_Texture* sdlBackend::getTarget() {
+		return SDL_GetRenderTarget(getRenderer());
+	}
+	int sdlBackend::getOutputSize(int *w, int *h) {
+		SDL_Texture *target = SDL_GetRenderTarget(getRenderer());
+		if (target != nullptr) {
+			return SDL_QueryTexture(target, nullptr, nullptr, w, h);
+		}
+		return SDL_GetRendererOutputSize(getRenderer(), w, h);
+	}
+	int sdlBackend::setClipRect(const SDL_Rect *rect) {
+		return SDL_RenderSetClipRect(getRenderer(), rect);
+	}
+	bool sdlBackend::getClipRect(SDL_Rect *rect) {
+		SDL_RenderGetClipRect(getRenderer(), rect);
+		return SDL_RenderIsClipEnabled(getRenderer()) == SDL_TRUE;
+	}
+	int sdlBackend::setDrawColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
+		return SDL_SetRenderDrawColor(getRenderer(), r, g, b, a);
+	}
+	int sdlBackend::getDrawColor(Uint8 *r, Uint8 *g, Uint8 *b, Uint8 *a) {
+		return SDL_GetRenderDrawColor(getRenderer(), r, g, b, a);
+	}
+	int sdlBackend::setDrawBlendMode(SDL_BlendMode mode) {
+		return SDL_SetRenderDrawBlendMode(getRenderer(), mode);
+	}
+	int sdlBackend::getDrawBlendMode(SDL_BlendMode *mode) {
+		return SDL_GetRenderDrawBlendMode(getRenderer(), mode);
+	}
+	int sdlBackend::clear() {
+		return SDL_RenderClear(getRenderer());
+	}
+	int sdlBackend::fillRect(const SDL_FRect *rect) {
+		return SDL_RenderFillRectF(getRenderer(), rect);
+	}
+	int sdlBackend::drawRect(const SDL_FRect *rect) {
+		return SDL_RenderDrawRectF(getRenderer(), rect);
+	}
+	int sdlBackend::drawLines(const SDL_FPoint *points, int count) {
+		return SDL_RenderDrawLinesF(getRenderer(), points, count);
+	}
+	int sdlBackend::copy(SDL_Texture *texture, const SDL_Rect *srcrect, const SDL_FRect *dstrect, double angle, const SDL_FPoint *center, SDL_RendererFlip flip) {
+		if (angle == 0 && flip == SDL_FLIP_NONE) {
+			return SDL_RenderCopyF(getRenderer(), texture, srcrect, dstrect);
+		}
+		return SDL_RenderCopyExF(getRenderer(), texture, srcrect, dstrect, angle, center, flip);
+	}
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	int sdlBackend::geometry(SDL_Texture *texture, const SDL_Vertex *vertices, int numVertices, const int *indices, int numIndices) {
+		return SDL_RenderGeometry(getRenderer(), texture, vertices, numVertices, indices, numIndices);
+	}
+#endif
+
+}
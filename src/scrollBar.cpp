@@ -3,7 +3,10 @@
 extern "C" {
 #include <SDL2/SDL.h>
 }
-#include "./extra.hpp" //RotatePoint
+#include <algorithm>
+#include "./extra.hpp" //rotation, UnionRect
+#include "./set.hpp"
+#include "./dragWatch.hpp"
 
 namespace lui {
 
@@ -18,13 +21,27 @@ namespace lui {
 		setGripDstrect(dstrectGrip);
 		setAngle(angle);
 	}
-	scrollBar::~scrollBar() {}
+	scrollBar::~scrollBar() {
+		dragWatch::global().end(this);
+		attachSet(nullptr);
+	}
 
 	void scrollBar::render(SDL_Renderer *renderer) {
-		SDL_RenderCopyExF(renderer, m_textureTrack, srcrectTrack, &m_dstrect, m_angle, &zeroFPoint, m_flip);
-		SDL_RenderCopyExF(renderer, m_textureGrip, srcrectGrip, &m_dstrectGrip, m_angle, &zeroFPoint, m_flip);
+		SDL_FRect dstrectTrack = m_renderDstrect(), dstrectGrip = m_offsetRect(m_dstrectGrip);
+		renderBackend *backend = renderBackend::get(renderer);
+		m_applyMod(m_textureTrack);
+		backend->copy(m_textureTrack, srcrectTrack, &dstrectTrack, m_angle, &zeroFPoint, m_flip);
+		m_clearMod(m_textureTrack);
+		m_applyMod(m_textureGrip);
+		backend->copy(m_textureGrip, srcrectGrip, &dstrectGrip, m_angle, &zeroFPoint, m_flip);
+		m_clearMod(m_textureGrip);
 	}
 	void scrollBar::userLogic(std::vector<SDL_Event> &events, SDL_Renderer *renderer) {
+		m_syncAttached();
+		bool watched = m_gripMoving && dragWatch::global().isDragging(this);
+		if (watched) {
+			dragWatch::global().latch(false);
+		}
 		for (SDL_Event &e : events) {
 			if (m_hasFocus) {
 				switch (e.type) {
@@ -79,12 +96,18 @@ namespace lui {
 						if (m_gripHasFocus) {
 							//Start dragging grip.
 							m_gripMoving = true;
+							int x = 0, y = 0;
+							SDL_GetMouseState(&x, &y);
+							SDL_FPoint windowPoint = { (float)x, (float)y };
+							m_grabPoint = m_parentSet != nullptr ? m_parentSet->windowToLocal(windowPoint) : windowPoint;
+							m_gripGrabPos = m_gripPos;
+							watched = dragWatch::global().begin(this, [this](SDL_FPoint p) { m_dragGripTo(p); });
 							m_callGripEventFunction(Event::LMBDown, &e);
 						}
 						else {
 							//Jump in the direction of the press (Jump distance is equal to the size of the grip)
 							//Get the vector the click was in, relative to the track and grip
-							SDL_FPoint clickLocal = RotatePoint({ (float)e.button.x, (float)e.button.y }, -m_angle, { m_dstrect.x, m_dstrect.y });
+							SDL_FPoint clickLocal = m_rotation.applyInverse({ (float)e.button.x, (float)e.button.y }, { m_dstrect.x, m_dstrect.y });
 							clickLocal.x -= m_dstrect.x;
 							clickLocal.y -= m_dstrect.y;
 							SDL_FPoint gripLocalCenter{ m_gripPos.x * (m_dstrect.w - m_dstrectGrip.w) + m_dstrectGrip.w / 2,
@@ -205,12 +228,14 @@ namespace lui {
 			if (m_gripMoving && e.type == SDL_MOUSEBUTTONUP) {
 				if (e.button.button == SDL_BUTTON_LEFT) {
 					m_gripMoving = false;
+					watched = false;
+					dragWatch::global().end(this);
 				}
 			}
-			//Move grip, keep in track.
-			if (m_gripMoving && e.type == SDL_MOUSEMOTION) {
+			//Move grip, keep in track. The drag watch moves it instead when enabled
+			if (m_gripMoving && !watched && e.type == SDL_MOUSEMOTION) {
 				//Translate motion.(x/y)rel to account for our angle
-				SDL_FPoint xyrel = RotatePoint({ (float)e.motion.xrel, (float)e.motion.yrel }, -m_angle);
+				SDL_FPoint xyrel = m_rotation.applyInverse({ (float)e.motion.xrel, (float)e.motion.yrel });
 
 				setGripPosition({ m_gripPos.x + (xyrel.x / (m_dstrect.w - m_dstrectGrip.w)), m_gripPos.y + (xyrel.y / (m_dstrect.h - m_dstrectGrip.h)) });
 			}
@@ -233,6 +258,11 @@ namespace lui {
 	void scrollBar::resetUserLogic() {
 		setGripPosition({ 0, 0 });
 		m_gripMoving = false;
+		dragWatch::global().end(this);
+	}
+	void scrollBar::loopLogic(Uint32 ms) {
+		element::loopLogic(ms);
+		m_syncAttached(); //Catch changes made since userLogic() before the set is rendered
 	}
 	bool scrollBar::bind(Event e, eventFunction func, Component c) {
 		switch (c) {
@@ -279,12 +309,14 @@ namespace lui {
 	}
 	void scrollBar::setTrackTexture(SDL_Texture *texture) {
 		m_textureTrack = texture;
+		invalidate();
 	}
 	SDL_Texture* scrollBar::getTrackTexture() {
 		return m_textureTrack;
 	}
 	void scrollBar::setGripTexture(SDL_Texture *texture) {
 		m_textureGrip = texture;
+		invalidate();
 	}
 	SDL_Texture* scrollBar::getGripTexture() {
 		return m_textureGrip;
@@ -303,15 +335,67 @@ namespace lui {
 		pos.x = std::max(0.f, std::min(pos.x, 1.f));
 		pos.y = std::max(0.f, std::min(pos.y, 1.f));
 		m_gripPos = pos;
-		SDL_FPoint gripPos = RotatePoint({ m_gripPos.x * (m_dstrect.w - m_dstrectGrip.w), m_gripPos.y * (m_dstrect.h - m_dstrectGrip.h) }, m_angle);
+		SDL_FPoint gripPos = m_rotation.apply({ m_gripPos.x * (m_dstrect.w - m_dstrectGrip.w), m_gripPos.y * (m_dstrect.h - m_dstrectGrip.h) });
 		m_dstrectGrip.x = gripPos.x + m_dstrect.x;
 		m_dstrectGrip.y = gripPos.y + m_dstrect.y;
+		invalidate(); //The grip is drawn inside of the track
+		if (m_attachedSet != nullptr) {
+			SDL_FRect area;
+			SDL_FPoint range;
+			m_attachedArea(area, range);
+			m_attachedSet->setRenderCorner({ -(area.x + m_gripPos.x * range.x), -(area.y + m_gripPos.y * range.y) });
+			m_attachedGeneration = m_attachedSet->getContentGeneration(); //Our own scrolling needs no sync
+		}
 		m_callGripEventFunction(Event::ValueChanged);
 		m_updateGripFocus = true;
 	}
 	SDL_FPoint scrollBar::getGripPosition() {
 		return m_gripPos;
 	}
+	void scrollBar::m_dragGripTo(SDL_FPoint windowPoint) {
+		SDL_FPoint local = m_parentSet != nullptr ? m_parentSet->windowToLocal(windowPoint) : windowPoint;
+		//Distance moved along the track's own axes
+		SDL_FPoint moved = m_rotation.applyInverse({ local.x - m_grabPoint.x, local.y - m_grabPoint.y });
+		float travelX = m_dstrect.w - m_dstrectGrip.w, travelY = m_dstrect.h - m_dstrectGrip.h;
+		setGripPosition({ travelX > 0.f ? m_gripGrabPos.x + moved.x / travelX : m_gripGrabPos.x, travelY > 0.f ? m_gripGrabPos.y + moved.y / travelY : m_gripGrabPos.y });
+	}
+	void scrollBar::attachSet(set *s) {
+		if (s == m_attachedSet) {
+			return;
+		}
+		if (m_attachedSet != nullptr) {
+			std::vector<scrollBar*> &bars = m_attachedSet->m_scrollBars;
+			bars.erase(std::remove(bars.begin(), bars.end(), this), bars.end());
+		}
+		m_attachedSet = s;
+		if (m_attachedSet != nullptr) {
+			m_attachedSet->m_scrollBars.push_back(this);
+			m_attachedGeneration = m_attachedSet->getContentGeneration() - 1; //Sync right away
+			m_syncAttached();
+		}
+	}
+	set* scrollBar::getAttachedSet() {
+		return m_attachedSet;
+	}
+	void scrollBar::m_attachedArea(SDL_FRect &area, SDL_FPoint &range) {
+		SDL_FRect content = m_attachedSet->getContentBounds(), view = m_attachedSet->getDstrect();
+		area = UnionRect(content, SDL_FRect{ 0.f, 0.f, std::max(view.w, 0.f), std::max(view.h, 0.f) });
+		range.x = std::max(area.w - view.w, 0.f);
+		range.y = std::max(area.h - view.h, 0.f);
+	}
+	void scrollBar::m_syncAttached() {
+		if (m_attachedSet == nullptr || m_attachedSet->getContentGeneration() == m_attachedGeneration) {
+			return;
+		}
+		SDL_FRect area, view = m_attachedSet->getDstrect();
+		SDL_FPoint range, corner = m_attachedSet->getRenderCorner();
+		m_attachedArea(area, range);
+		//Grip shows how much of the area fits in the set
+		m_dstrectGrip.w = view.w > 0.f && area.w > 0.f ? m_dstrect.w * std::min(view.w / area.w, 1.f) : m_dstrect.w;
+		m_dstrectGrip.h = view.h > 0.f && area.h > 0.f ? m_dstrect.h * std::min(view.h / area.h, 1.f) : m_dstrect.h;
+		//Keep showing the same content, moved back in range if it shrank
+		setGripPosition({ range.x > 0.f ? (-corner.x - area.x) / range.x : 0.f, range.y > 0.f ? (-corner.y - area.y) / range.y : 0.f });
+	}
 	//DEPREACTED:
 	/*
 	bool scrollBar::attachScrollWindow(scrollWindow *sw) {
@@ -348,7 +432,7 @@ namespace lui {
 						(int)std::round(m_dstrectGrip.w),
 						(int)std::round(m_dstrectGrip.h) };
 
-		SDL_FPoint rotatedPoint = RotatePoint({ (float)point.x, (float)point.y }, -m_angle, { m_dstrect.x, m_dstrect.y });
+		SDL_FPoint rotatedPoint = m_rotation.applyInverse({ (float)point.x, (float)point.y }, { m_dstrect.x, m_dstrect.y });
 		SDL_Point translatedPoint{ (int)std::round(rotatedPoint.x), (int)std::round(rotatedPoint.y) };
 		return SDL_PointInRect(&translatedPoint, &temp);
 	}
@@ -0,0 +1,233 @@
+#include "./searchIndex.hpp"
+
+extern "C" {
+#include <SDL2/SDL.h>
+}
+#include <algorithm>
+#include <iterator>
+#include <cstring>
+
+namespace lui {
+
+	searchIndex::searchIndex() {}
+	searchIndex::~searchIndex() {}
+
+	void searchIndex::reserve(size_t entries, size_t labelBytes) {
+		m_offsets.reserve(entries + 1);
+		m_elements.reserve(entries);
+		m_labels.reserve(labelBytes);
+	}
+	size_t searchIndex::addEntry(const std::string &label, element *e) {
+		Uint32 id = (Uint32)m_elements.size();
+		std::string lower = m_lower(label);
+		m_labels += lower;
+		m_offsets.push_back((Uint32)m_labels.size());
+		m_elements.push_back(e);
+
+		//List the entry once under each of its 1, 2, and 3 byte runs; ids only grow, so the lists stay sorted
+		std::vector<Uint32> grams;
+		for (size_t n = 1; n <= 3; n++) {
+			for (size_t i = 0; i + n <= lower.size(); i++) {
+				grams.push_back(m_gram(lower.data() + i, n));
+			}
+		}
+		std::sort(grams.begin(), grams.end());
+		grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+		for (Uint32 g : grams) {
+			m_postings[g].push_back(id);
+		}
+
+		//Keep the current and kept results up to date
+		for (auto &h : m_history) {
+			if (m_contains(id, h.first)) {
+				h.second.push_back(id);
+			}
+		}
+		bool match = m_contains(id, m_query);
+		if (match) {
+			m_results.push_back(id);
+		}
+		if (e != nullptr) {
+			e->setVisible(match);
+		}
+		return id;
+	}
+	void searchIndex::clear() {
+		m_labels.clear();
+		m_offsets.assign(1, 0);
+		m_elements.clear();
+		m_postings.clear();
+		m_query.clear();
+		m_results.clear();
+		m_history.clear();
+	}
+	size_t searchIndex::size() {
+		return m_elements.size();
+	}
+
+	void searchIndex::setQuery(const std::string &query) {
+		std::string q = m_lower(query);
+		if (q == m_query) {
+			return;
+		}
+		std::vector<Uint32> results;
+		if (q.size() > m_query.size() && q.compare(0, m_query.size(), m_query) == 0) { //Typed onto the end, so only the current results can match
+			m_match(q, &m_results, results);
+			m_swapResults(results);
+			m_history.emplace_back(m_query, std::move(results));
+			m_query = q;
+			return;
+		}
+
+		//Deleted from the end, or replaced part of the query; find the longest kept query still a prefix
+		while (!m_history.empty() && (m_history.back().first.size() > q.size() || q.compare(0, m_history.back().first.size(), m_history.back().first) != 0)) {
+			m_history.pop_back();
+		}
+		if (!m_history.empty() && m_history.back().first == q) { //Seen it already
+			results = std::move(m_history.back().second);
+			m_history.pop_back();
+		}
+		else if (!m_history.empty()) {
+			m_match(q, &m_history.back().second, results);
+		}
+		else {
+			m_match(q, nullptr, results);
+		}
+		m_swapResults(results);
+		m_query = q;
+	}
+	std::string searchIndex::getQuery() {
+		return m_query;
+	}
+	const std::vector<Uint32>& searchIndex::getResults() {
+		return m_results;
+	}
+	element* searchIndex::getElement(size_t id) {
+		return id < m_elements.size() ? m_elements[id] : nullptr;
+	}
+
+
+
+	std::string searchIndex::m_lower(const std::string &s) {
+		std::string lower = s;
+		for (char &c : lower) {
+			if (c >= 'A' && c <= 'Z') {
+				c += 'a' - 'A';
+			}
+		}
+		return lower;
+	}
+	Uint32 searchIndex::m_gram(const char *p, size_t n) {
+		Uint32 gram = (Uint32)n << 24; //Length in the top byte keeps "ab" and "ab\0" apart
+		for (size_t i = 0; i < n; i++) {
+			gram |= (Uint32)(Uint8)p[i] << (i * 8);
+		}
+		return gram;
+	}
+	bool searchIndex::m_contains(Uint32 id, const std::string &query) {
+		if (query.empty()) {
+			return true;
+		}
+		const char *begin = m_labels.data() + m_offsets[id], *end = m_labels.data() + m_offsets[id + 1];
+		return std::search(begin, end, query.begin(), query.end()) != end;
+	}
+	void searchIndex::m_intersect(const std::vector<Uint32> &a, const std::vector<Uint32> &b, std::vector<Uint32> &out) {
+		out.clear();
+		out.reserve(std::min(a.size(), b.size()));
+		const std::vector<Uint32> &shorter = a.size() <= b.size() ? a : b, &longer = a.size() <= b.size() ? b : a;
+		if (shorter.size() * 16 < longer.size()) { //Binary search the longer list instead of walking it
+			auto it = longer.begin();
+			for (Uint32 v : shorter) {
+				it = std::lower_bound(it, longer.end(), v);
+				if (it == longer.end()) {
+					break;
+				}
+				if (*it == v) {
+					out.push_back(v);
+				}
+			}
+		}
+		else {
+			std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(out));
+		}
+	}
+	void searchIndex::m_match(const std::string &query, const std::vector<Uint32> *candidates, std::vector<Uint32> &out) {
+		out.clear();
+		if (query.empty()) { //Everything matches
+			if (candidates != nullptr) {
+				out = *candidates;
+			}
+			else {
+				out.resize(m_elements.size());
+				for (Uint32 id = 0; id < out.size(); id++) {
+					out[id] = id;
+				}
+			}
+			return;
+		}
+
+		//Gather the lists of the query's runs, as long as the query allows; a missing one means nothing matches
+		size_t n = std::min(query.size(), (size_t)3);
+		std::vector<const std::vector<Uint32>*> lists;
+		for (size_t i = 0; i + n <= query.size(); i++) {
+			auto found = m_postings.find(m_gram(query.data() + i, n));
+			if (found == m_postings.end()) {
+				return;
+			}
+			lists.push_back(&found->second);
+		}
+		std::sort(lists.begin(), lists.end(), [](const std::vector<Uint32> *l, const std::vector<Uint32> *r) {
+			return l->size() < r->size() || (l->size() == r->size() && l < r);
+		});
+		lists.erase(std::unique(lists.begin(), lists.end()), lists.end());
+
+		//Rarest first, so every step is as short as possible
+		std::vector<Uint32> narrowed, scratch;
+		if (candidates != nullptr && candidates->size() < m_elements.size()) { //A candidate list of everything narrows nothing
+			m_intersect(*candidates, *lists[0], narrowed);
+		}
+		else {
+			narrowed = *lists[0];
+		}
+		for (size_t i = 1; i < lists.size() && !narrowed.empty(); i++) {
+			m_intersect(narrowed, *lists[i], scratch);
+			narrowed.swap(scratch);
+		}
+		if (query.size() <= 3) { //Holding the whole query as one run is an exact match
+			out.swap(narrowed);
+			return;
+		}
+
+		//Holding every trigram doesn't mean they are in order, so check what is left directly
+		out.reserve(narrowed.size());
+		for (Uint32 id : narrowed) {
+			if (m_contains(id, query)) {
+				out.push_back(id);
+			}
+		}
+	}
+	void searchIndex::m_swapResults(std::vector<Uint32> &results) {
+		//Both lists are sorted, so walk them together and only touch what differs
+		size_t i = 0, j = 0;
+		while (i < m_results.size() || j < results.size()) {
+			if (j == results.size() || (i < m_results.size() && m_results[i] < results[j])) { //No longer matches
+				if (m_elements[m_results[i]] != nullptr) {
+					m_elements[m_results[i]]->setVisible(false);
+				}
+				i++;
+			}
+			else if (i == m_results.size() || results[j] < m_results[i]) { //Newly matches
+				if (m_elements[results[j]] != nullptr) {
+					m_elements[results[j]]->setVisible(true);
+				}
+				j++;
+			}
+			else {
+				i++;
+				j++;
+			}
+		}
+		m_results.swap(results);
+	}
+
+}
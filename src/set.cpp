@@ -2,10 +2,115 @@
 #include "./element.hpp"
 #include "./item.hpp"
 #include "./itemHolder.hpp"
+#include "./extra.hpp"
+#include "./dragWatch.hpp"
+#include "./scrollBar.hpp"
+#include "./animator.hpp"
+#include "./surfaceBackend.hpp"
+#include "./textCache.hpp"
 #include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <thread>
 
 namespace lui {
 
+	namespace {
+		thread_local bool OnWorker = false; //Threaded sets inside of a threaded set draw inline on its worker
+		thread_local Uint32 DamageFrame = 0; //Numbers the frame while the outermost set draws damaged regions, 0 otherwise
+
+		//Threads drawing threaded sets
+		struct renderWorkers {
+			std::mutex mutex;
+			std::condition_variable wake;
+			std::deque<std::function<void()>> tasks;
+
+			renderWorkers() {
+				unsigned count = std::max(std::thread::hardware_concurrency(), 2u) - 1; //One core is left for the render thread
+				for (unsigned i = 0; i < count; i++) {
+					std::thread([this]() { run(); }).detach();
+				}
+			}
+			void run() {
+				OnWorker = true;
+				while (true) {
+					std::function<void()> task;
+					{
+						std::unique_lock<std::mutex> lock(mutex);
+						wake.wait(lock, [this]() { return !tasks.empty(); });
+						task = std::move(tasks.front());
+						tasks.pop_front();
+					}
+					task();
+				}
+			}
+			void push(std::function<void()> task) {
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					tasks.push_back(std::move(task));
+				}
+				wake.notify_one();
+			}
+		};
+		renderWorkers& Workers() {
+			//Never destroyed; the threads never stop
+			static renderWorkers *workers = new renderWorkers();
+			return *workers;
+		}
+
+		const size_t MaxDamageRegions = 8; //Every region draws the tree again, so keep few
+
+		Sint64 Area(const SDL_Rect &r) {
+			return (Sint64)r.w * r.h;
+		}
+		SDL_Rect Union(const SDL_Rect &a, const SDL_Rect &b) {
+			int x = std::min(a.x, b.x), y = std::min(a.y, b.y);
+			return SDL_Rect{ x, y, std::max(a.x + a.w, b.x + b.w) - x, std::max(a.y + a.h, b.y + b.h) - y };
+		}
+		//Add a rectangle to regions which never overlap, merging it with those it touches or nearly touches
+		void AddRegion(std::vector<SDL_Rect> &regions, SDL_Rect rect) {
+			const Sint64 slack = 32 * 32; //Area worth drawing twice to save a region
+			bool merged = true;
+			while (merged) {
+				merged = false;
+				for (size_t i = 0; i < regions.size(); i++) {
+					SDL_Rect both = Union(regions[i], rect);
+					if (Area(both) <= Area(regions[i]) + Area(rect) + slack) { //Overlapping, touching, or close
+						rect = both;
+						regions.erase(regions.begin() + i);
+						merged = true;
+						break;
+					}
+				}
+			}
+			regions.push_back(rect);
+			if (regions.size() > MaxDamageRegions) { //Merge the pair which grows least, and anything it now overlaps
+				size_t bestA = 0, bestB = 1;
+				Sint64 bestGrowth = -1;
+				for (size_t a = 0; a < regions.size(); a++) {
+					for (size_t b = a + 1; b < regions.size(); b++) {
+						Sint64 growth = Area(Union(regions[a], regions[b])) - Area(regions[a]) - Area(regions[b]);
+						if (bestGrowth < 0 || growth < bestGrowth) {
+							bestGrowth = growth;
+							bestA = a;
+							bestB = b;
+						}
+					}
+				}
+				SDL_Rect both = Union(regions[bestA], regions[bestB]);
+				regions.erase(regions.begin() + bestB);
+				regions.erase(regions.begin() + bestA);
+				AddRegion(regions, both);
+			}
+		}
+	}
+
+	std::atomic<Uint32> set::m_transformGeneration{ 0 };
+	std::atomic<Uint32> set::m_everyTransformStamp{ 0 };
+
 	set::set(std::vector<element*> elements) {
 		m_hasFocus = true;
 		for (element* e : elements) {
@@ -13,57 +118,105 @@ namespace lui {
 		}
 	}
 	set::~set() {
-		SDL_DestroyTexture(m_texture);
+		for (element *e : m_elements) { //Children destroyed after us must not reach back into us
+			e->m_parentSet = nullptr;
+		}
+		for (element *e : m_overlay) {
+			e->m_overlaySet = nullptr;
+		}
+		for (element *e : m_pendingElements) {
+			e->m_pendingListed = false;
+		}
+		for (scrollBar *bar : m_scrollBars) {
+			bar->m_attachedSet = nullptr;
+		}
+		for (set *s : m_threadedSets) {
+			if (s->m_threadedParent == this) {
+				s->m_threadedParent = nullptr;
+			}
+		}
+		m_joinThreadedParent(nullptr);
+		if (m_workerDone.valid()) {
+			m_workerDone.wait();
+		}
+		delete m_animator;
+		renderBackend::destroyTexture(m_texture);
+		m_clearTiles();
+		if (m_workerBackend != nullptr) {
+			textCache::global().clearRenderer(m_workerBackend->getRenderer());
+			delete m_workerBackend; //Along with the textures children made on the worker
+			SDL_FreeSurface(m_workerSurface);
+		}
 	}
 
 	void set::render(SDL_Renderer *renderer) {
-		SDL_Texture *prevRenderTarget = nullptr;
-		//If dstrect size > 0
-		//	Lock renderer mutex
-		//	If no texture
-		//		Create texture
-		//	Set renderer target to our texture
-		//Else
-		//	If texture
-		//		Remove texture
-		if (m_dstrect.w > 0 && m_dstrect.h > 0) {
-			m_textureMutex.lock();
-			if (m_texture == nullptr) {
-				m_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, m_dstrect.w, m_dstrect.h);
-				SDL_SetTextureBlendMode(m_texture, SDL_BLENDMODE_BLEND);
+		if (m_parentSet == nullptr) { //Move anything being dragged to where the cursor is now, as late as possible
+			dragWatch::global().latch();
+		}
+		if (m_parentSet == nullptr && m_damageRendering) {
+			m_renderDamage(renderer);
+		}
+		else {
+			m_renderContent(renderer);
+		}
+	}
+	void set::m_renderContent(SDL_Renderer *renderer) {
+		bool sized = m_dstrect.w > 0 && m_dstrect.h > 0;
+		bool threaded = sized && m_threadedRendering && !OnWorker;
+		if (threaded || (sized && !m_rendersDirectly())) {
+			if (DamageFrame != 0 && m_regionFrame == DamageFrame) { //Drawn whole for an earlier region this frame
+				m_renderTexture(renderer);
 			}
-			prevRenderTarget = SDL_GetRenderTarget(renderer);
-			SDL_SetRenderTarget(renderer, m_texture);
-			Uint8 r, g, b, a;
-			SDL_GetRenderDrawColor(renderer, &r, &g, &b, &a);
-			SDL_SetRenderDrawColor(renderer, m_r, m_g, m_b, m_a);
-			SDL_RenderClear(renderer);
-			SDL_SetRenderDrawColor(renderer, r, g, b, a);
+			else if (threaded) {
+				m_renderThreaded(renderer);
+			}
+			else {
+				m_renderOffscreen(renderer);
+			}
+			m_regionFrame = DamageFrame;
 		}
-		else if (m_texture != nullptr && m_dstrect.w <= 0 && m_dstrect.h <= 0) {
-			SDL_DestroyTexture(m_texture);
-			m_texture = nullptr;
+		else if (sized) {
+			m_renderDirect(renderer);
 		}
-		//Render to target
-		for (element* &e : m_elements) {
-			SDL_FRect prevDst = e->getDstrect(), tempDst = prevDst;
-			tempDst.x += m_renderCorner.x;
-			tempDst.y += m_renderCorner.y;
-			e->setDstrect(tempDst); //TODO: Remove this line and find an efficient way to translate children; This line causes focus re-evaluation.
-			e->render(renderer);
-			e->setDstrect(prevDst); //TODO: Remove this line and find an efficient way to translate children; This line causes focus re-evaluation.
+		else {
+			m_renderOffscreen(renderer);
 		}
-		//If dstrect size > 0
-		//	Set renderer target back to previous
-		//	Draw our texture in desired location
-		//	Free mutex
-		if (m_dstrect.w > 0 && m_dstrect.h > 0) {
-			SDL_SetRenderTarget(renderer, prevRenderTarget);
-			m_textureMutex.unlock();
-			SDL_RenderCopyExF(renderer, m_texture, NULL, &m_dstrect, m_angle, &zeroFPoint, m_flip);
+		if (!m_overlay.empty()) {
+			m_renderOverlay(renderer);
+		}
+	}
+	void set::releaseTextures() {
+		if (m_workerDone.valid()) { //Started but not drawn; the worker holds m_textureMutex until done
+			m_workerDone.wait();
+		}
+		m_textureMutex.lock();
+		renderBackend::destroyTexture(m_texture);
+		m_texture = nullptr;
+		m_clearTiles();
+		m_textureMutex.unlock();
+		for (element *e : m_elements) {
+			e->releaseTextures();
+		}
+	}
+	bool set::isOpaque() {
+		if (element::isOpaque()) {
+			return true;
+		}
+		if (m_dstrect.w <= 0 || m_dstrect.h <= 0 || m_mod.a != 255) {
+			return false;
+		}
+		SDL_FRect shown{ -m_renderCorner.x, -m_renderCorner.y, m_dstrect.w, m_dstrect.h }; //In local coordinates
+		for (element *e : m_elements) { //Such as the background of a page
+			if (e->isVisible() && e->m_overlaySet == nullptr && e->getRotation().identity && RectContains(e->getDstrect(), shown) && e->isOpaque()) {
+				return true;
+			}
 		}
+		return false;
 	}
 	void set::userLogic(std::vector<SDL_Event> &events, SDL_Renderer *renderer) {
+		if (m_coalesceEvents) {
+			CoalesceEvents(events);
+		}
 		if (m_hasFocus) {
 			m_elementsMutex.lock();
 
@@ -71,11 +224,14 @@ namespace lui {
 			bool updateFocusElements = m_updateFocusElements;
 			m_updateFocusElements = false;
 			SDL_Point mousePoint = { 0, 0 };
+			std::vector<SDL_Event> windowEvents; //Untranslated, for the overlay
+			if (!m_overlay.empty()) {
+				windowEvents = events;
+			}
 
 			std::vector<SDL_Event> translatedEvents;
 			for (SDL_Event &e : events) {
 				if (e.type == SDL_MOUSEMOTION) {
-					updateFocusElements = true;
 					mousePoint.x = e.button.x;
 					mousePoint.y = e.button.y;
 				}
@@ -83,7 +239,7 @@ namespace lui {
 				//Rotate all points around m_dstrect(x,y) by -m_angle
 				//Then subtract m_dstrect(x,y) to get translated point
 				if (e.type == SDL_MOUSEBUTTONDOWN || e.type == SDL_MOUSEBUTTONUP || e.type == SDL_MOUSEMOTION) {
-					SDL_FPoint translatedPoint = RotatePoint({ (float)e.button.x, (float)e.button.y }, -m_angle, { m_dstrect.x, m_dstrect.y });
+					SDL_FPoint translatedPoint = m_rotation.applyInverse({ (float)e.button.x, (float)e.button.y }, { m_dstrect.x, m_dstrect.y });
 					e.button.x = translatedPoint.x - m_dstrect.x - m_renderCorner.x;
 					e.button.y = translatedPoint.y - m_dstrect.y - m_renderCorner.y;
 				}
@@ -94,14 +250,65 @@ namespace lui {
 			if (mousePoint.x == 0 && mousePoint.y == 0) {
 				SDL_GetMouseState(&mousePoint.x, &mousePoint.y);
 			}
+			SDL_Point windowMouse = mousePoint;
 
 			SDL_FPoint mousePointF = windowToLocal(SDL_FPoint{ (float)mousePoint.x, (float)mousePoint.y });
 			mousePoint.x = std::round(mousePointF.x);
 			mousePoint.y = std::round(mousePointF.y);
+			//The cursor moved over our content, by itself or because we moved
+			if (!m_focusResolved || mousePoint.x != m_focusPoint.x || mousePoint.y != m_focusPoint.y) {
+				updateFocusElements = true;
+			}
+			if (updateFocusElements) {
+				m_focusPoint = mousePoint;
+				m_focusResolved = true;
+			}
+
+			//The overlay is above everything, so it is hit and routed first, in its own set's coordinates
+			std::vector<element*> overlay = m_overlay;
+			for (auto it = overlay.rbegin(); it != overlay.rend(); ++it) {
+				element *current = *it;
+				if (std::find(m_overlay.begin(), m_overlay.end(), current) == m_overlay.end() || !current->isVisible()) { //Dropped by an earlier one
+					continue;
+				}
+				set *parent = current->m_parentSet;
+				std::vector<SDL_Event> localEvents = windowEvents;
+				for (SDL_Event &e : localEvents) {
+					if (e.type == SDL_MOUSEBUTTONDOWN || e.type == SDL_MOUSEBUTTONUP || e.type == SDL_MOUSEMOTION) {
+						SDL_FPoint local = parent->windowToLocal(SDL_FPoint{ (float)e.button.x, (float)e.button.y });
+						e.button.x = std::round(local.x);
+						e.button.y = std::round(local.y);
+					}
+				}
+				current->userLogic(localEvents, renderer);
+				if (current->m_overlaySet != this) { //It was dropped during its logic
+					continue;
+				}
+				if (updateFocusElements && m_cursorDepth < m_focusedElements.size() && current->pointInElement(parent->windowToLocal(windowMouse))) {
+					if (m_cursorDepth == 0 && m_focusedElements[m_cursorDepth] != current) {
+						if (m_focusedElements[m_cursorDepth] != nullptr) {
+							m_focusedElements[m_cursorDepth]->setFocus(false);
+						}
+						m_focusedElements[m_cursorDepth] = current;
+						current->setFocus(true);
+					}
+					else {
+						m_focusedElements[m_cursorDepth] = current;
+					}
+					m_cursorDepth++;
+				}
+			}
 
 			for (int i = m_elements.size() - 1; i >= 0; i--) {
+				if (!m_elements[i]->isVisible() || m_elements[i]->m_overlaySet != nullptr) { //Hidden elements neither get events nor focus, and the overlay got its own above
+					continue;
+				}
 				//Run the logic for the element
-				(m_elements[i])->userLogic(translatedEvents, renderer);
+				element *current = m_elements[i];
+				current->userLogic(translatedEvents, renderer);
+				if ((size_t)i >= m_elements.size() || m_elements[i] != current) { //It removed itself, or was removed, during its logic
+					continue;
+				}
 
 				//If we are updating elements AND there is room for more, find check if this element is the next in line
 				if (updateFocusElements && m_cursorDepth < m_focusedElements.size()) {
@@ -145,10 +352,19 @@ namespace lui {
 		}
 	}
 	void set::loopLogic(Uint32 ms) {
+		if (m_animator != nullptr) {
+			m_animator->step(ms);
+		}
 		for (element* &e : m_elements) {
 			e->loopLogic(ms);
 		}
 	}
+	animator& set::getAnimator() {
+		if (m_animator == nullptr) {
+			m_animator = new animator(this);
+		}
+		return *m_animator;
+	}
 	void set::resetLoopLogic() {
 		for (element* &e : m_elements) {
 			e->resetLoopLogic();
@@ -176,19 +392,158 @@ namespace lui {
 	}
 	void set::setDstrect(SDL_FRect dr) {
 		if (m_texture != nullptr && (dr.w != m_dstrect.w || dr.h != m_dstrect.h)) {
-			SDL_DestroyTexture(m_texture);
+			renderBackend::destroyTexture(m_texture);
 			m_texture = nullptr;
 			//No texture created here because we don't have the render target, and it will be automatically created (if needed) in render()
 		}
 		element::setDstrect(dr);
+		m_transformsChanged();
+		m_contentGeneration++; //How much of the content is shown changed
+	}
+	void set::setAngle(double a) {
+		element::setAngle(a);
+		m_transformsChanged();
 	}
 	void set::setRenderCorner(SDL_FPoint shift) {
 		m_renderCorner = shift;
+		m_transformsChanged();
+		m_contentGeneration++;
 		setUpdateFocusElements();
+		invalidate(); //Tiles stay valid, but what we show in the parent set changed
 	}
 	SDL_FPoint set::getRenderCorner() {
 		return m_renderCorner;
 	}
+	Uint32 set::getTransformGeneration() {
+		return m_transformGeneration;
+	}
+	void set::invalidateTransforms() {
+		m_everyTransformStamp = ++m_transformGeneration;
+	}
+	Uint32 set::getLastTransformChange() {
+		Uint32 last = m_everyTransformStamp;
+		for (set *s = this; s != nullptr; s = s->m_parentSet) {
+			last = std::max(last, s->m_transformStamp.load());
+		}
+		return last;
+	}
+	Uint32 set::getLastMembershipChange() {
+		return m_membershipStamp;
+	}
+	SDL_FRect set::getContentBounds() {
+		m_elementsMutex.lock();
+		if (m_contentStale) {
+			m_contentStale = false;
+			m_contentBounds = { 0.f, 0.f, 0.f, 0.f };
+			for (size_t i = 0; i < m_elements.size(); i++) {
+				SDL_FRect box = BoundingBox(m_elements[i]->getDstrect(), m_elements[i]->getRotation());
+				m_contentBounds = i == 0 ? box : UnionRect(m_contentBounds, box);
+			}
+		}
+		SDL_FRect bounds = m_contentBounds;
+		m_elementsMutex.unlock();
+		return bounds;
+	}
+	Uint32 set::getContentGeneration() {
+		return m_contentGeneration;
+	}
+	void set::m_contentChanged(const SDL_FRect *before, const SDL_FRect *after) {
+		std::lock_guard<std::recursive_mutex> lock(m_elementsMutex);
+		m_contentGeneration++;
+		if (m_elements.empty()) {
+			m_contentBounds = { 0.f, 0.f, 0.f, 0.f };
+			m_contentStale = false;
+			return;
+		}
+		if (m_contentStale) { //Worked out from scratch when next asked for anyway
+			return;
+		}
+		//Growing is cheap, but only a child touching the edge can make the box shrink
+		if (before != nullptr && (before->x <= m_contentBounds.x || before->y <= m_contentBounds.y ||
+			before->x + before->w >= m_contentBounds.x + m_contentBounds.w || before->y + before->h >= m_contentBounds.y + m_contentBounds.h)) {
+			m_contentStale = true;
+			return;
+		}
+		if (after != nullptr) {
+			m_contentBounds = m_elements.size() == 1 && before == nullptr ? *after : UnionRect(m_contentBounds, *after);
+		}
+	}
+	void set::m_transformsChanged() {
+		if (m_updateDepth > 0) {
+			m_pendingTransforms = true;
+		}
+		else {
+			m_transformStamp = ++m_transformGeneration;
+		}
+	}
+
+	void set::beginUpdate() {
+		m_updateDepth++;
+	}
+	void set::endUpdate() {
+		if (m_updateDepth == 0) {
+			return;
+		}
+		if (m_updateDepth > 1) {
+			m_updateDepth--;
+			return;
+		}
+		//Deliver the children's notifications while still collecting what they invalidate
+		while (!m_pendingElements.empty()) {
+			std::vector<element*> pending;
+			pending.swap(m_pendingElements); //Event functions may change more children
+			for (element *e : pending) {
+				e->m_pendingListed = false;
+				if (e->m_updateDepth == 0) { //Otherwise it delivers them when its own update ends
+					e->m_commitUpdate();
+				}
+			}
+		}
+		m_updateDepth = 0;
+
+		//Mark the tiles once for everything invalidated, then pass it on once
+		if (m_pendingEverything) {
+			invalidateRect(SDL_FRect{ 0.f, 0.f, 0.f, 0.f });
+		}
+		else if (!m_pendingRects.empty()) {
+			SDL_FRect bounds = m_pendingRects[0];
+			m_textureMutex.lock();
+			for (const SDL_FRect &rect : m_pendingRects) {
+				m_dirtyTiles(rect, false);
+				bounds = UnionRect(bounds, rect);
+			}
+			m_textureMutex.unlock();
+			m_passInvalidation(bounds, false);
+		}
+		m_pendingRects.clear();
+		m_pendingEverything = false;
+		if (m_pendingTransforms) {
+			m_pendingTransforms = false;
+			m_transformStamp = ++m_transformGeneration;
+		}
+
+		//Then our own, as for any other element
+		if (m_updatePending) {
+			if (!m_deferring()) {
+				m_commitUpdate();
+			}
+			else if (!m_pendingListed) {
+				m_parentSet->m_addPending(this);
+			}
+		}
+	}
+	void set::m_addPending(element *e) {
+		if (!e->m_pendingListed) {
+			e->m_pendingListed = true;
+			m_pendingElements.push_back(e);
+		}
+	}
+	void set::m_forgetPending(element *e) {
+		if (e->m_pendingListed) {
+			e->m_pendingListed = false;
+			m_pendingElements.erase(std::remove(m_pendingElements.begin(), m_pendingElements.end(), e), m_pendingElements.end());
+		}
+	}
 	bool set::addElement(element *e) {
 		if (e == this) { //Cannot add self as child
 			return false;
@@ -196,9 +551,13 @@ namespace lui {
 		m_elementsMutex.lock();
 		if (std::find(m_elements.begin(), m_elements.end(), e) == m_elements.end()) { //No duplicates allowed
 			m_elements.push_back(e);
+			m_displayListStale = true; //Even while the element holds back its invalidation
 			e->setSet(this);
 			e->setFocus(false);
+			e->invalidate();
 			setUpdateFocusElements();
+			SDL_FRect box = BoundingBox(e->getDstrect(), e->getRotation());
+			m_contentChanged(nullptr, &box);
 			m_elementsMutex.unlock();
 			return true;
 		}
@@ -219,25 +578,94 @@ namespace lui {
 		size_t elementsBefore = m_elements.size();
 		for (auto it = m_elements.begin(); it != m_elements.end(); it++) { //Find the element we want to remove
 			if (*it == e) { //If this is the one to remove
-				e->setSet(nullptr);
+				e->invalidate();
 				m_elements.erase(it); //Remove it
+				m_displayListStale = true;
+				m_forgetFocus(e);
+				m_forgetPending(e);
+				if (m_animator != nullptr) {
+					m_animator->stop(e);
+				}
+				e->setSet(nullptr);
+				SDL_FRect box = BoundingBox(e->getDstrect(), e->getRotation());
+				m_contentChanged(&box, nullptr);
 				break;
 			}
 		}
 		m_elementsMutex.unlock();
-		return (elementsBefore < m_elements.size());
+		return (elementsBefore > m_elements.size());
 	}
 	element* set::removeElement(size_t position) {
 		m_elementsMutex.lock();
 		element* removedElement = nullptr;
 		if (position < m_elements.size()) {
 			removedElement = m_elements[position];
-			m_elements[position]->setSet(nullptr);
+			removedElement->invalidate();
 			m_elements.erase(m_elements.begin() + position);
+			m_displayListStale = true;
+			m_forgetFocus(removedElement);
+			m_forgetPending(removedElement);
+			if (m_animator != nullptr) {
+				m_animator->stop(removedElement);
+			}
+			removedElement->setSet(nullptr);
+			SDL_FRect box = BoundingBox(removedElement->getDstrect(), removedElement->getRotation());
+			m_contentChanged(&box, nullptr);
 		}
 		m_elementsMutex.unlock();
 		return removedElement;
 	}
+	void set::m_forgetFocus(element *e) {
+		for (size_t i = 0; i < m_focusedElements.size(); i++) {
+			if (m_focusedElements[i] == e) {
+				if (i == 0) {
+					e->setFocus(false);
+				}
+				m_focusedElements[i] = nullptr;
+				setUpdateFocusElements();
+			}
+		}
+	}
+	set* set::getRoot() {
+		set *root = this;
+		while (root->m_parentSet != nullptr) {
+			root = root->m_parentSet;
+		}
+		return root;
+	}
+	bool set::addOverlay(element *e) {
+		if (m_parentSet != nullptr || e->m_overlaySet != nullptr || e->m_parentSet == nullptr) {
+			return e->m_overlaySet == this;
+		}
+		//Overlaid elements are only shifted into place, so nothing around them may be rotated
+		set *s = e->m_parentSet;
+		for (; s != nullptr; s = s->m_parentSet) {
+			if (!s->m_rotation.identity) {
+				return false;
+			}
+			if (s == this) {
+				break;
+			}
+		}
+		if (s != this) {
+			return false;
+		}
+		e->invalidate(); //Clear it from where its set drew it
+		e->m_overlaySet = this;
+		m_overlay.push_back(e);
+		return true;
+	}
+	bool set::removeOverlay(element *e) {
+		auto found = std::find(m_overlay.begin(), m_overlay.end(), e);
+		if (found == m_overlay.end()) {
+			return false;
+		}
+		m_overlay.erase(found);
+		e->m_overlaySet = nullptr;
+		m_forgetFocus(e); //Its own set gives it focus again
+		e->invalidate(); //Its set draws it again, wherever it ended up
+		return true;
+	}
 	std::array<element*, 2> set::getFocusedElements() {
 		m_elementsMutex.lock();
 		std::array<element*, 2> focusedElements = m_focusedElements;
@@ -247,12 +675,24 @@ namespace lui {
 	void set::setUpdateFocusElements() {
 		m_updateFocusElements = true;
 	}
+	void set::setUpdateFocusElements(const SDL_FRect &before, const SDL_FRect &after) {
+		if (m_updateFocusElements || !m_focusResolved) {
+			m_updateFocusElements = true;
+			return;
+		}
+		//Only something which was or now is under the cursor can change what is focused
+		float x = m_focusPoint.x, y = m_focusPoint.y;
+		if ((x >= before.x && y >= before.y && x <= before.x + before.w && y <= before.y + before.h) ||
+			(x >= after.x && y >= after.y && x <= after.x + after.w && y <= after.y + after.h)) {
+			m_updateFocusElements = true;
+		}
+	}
 
 	SDL_Point set::windowToLocal(SDL_Point windowPoint) {
 		if (m_parentSet != nullptr) {
 			windowPoint = m_parentSet->windowToLocal(windowPoint);
 		}
-		SDL_FPoint windowPointRotated = RotatePoint({ (float)windowPoint.x, (float)windowPoint.y }, -m_angle, { m_dstrect.x, m_dstrect.y });
+		SDL_FPoint windowPointRotated = m_rotation.applyInverse({ (float)windowPoint.x, (float)windowPoint.y }, { m_dstrect.x, m_dstrect.y });
 		windowPoint.x = windowPointRotated.x - m_dstrect.x - m_renderCorner.x;
 		windowPoint.y = windowPointRotated.y - m_dstrect.y - m_renderCorner.y;
 
@@ -262,7 +702,7 @@ namespace lui {
 		if (m_parentSet != nullptr) {
 			windowPoint = m_parentSet->windowToLocal(windowPoint);
 		}
-		windowPoint = RotatePoint({ windowPoint.x, windowPoint.y }, -m_angle, { m_dstrect.x, m_dstrect.y });
+		windowPoint = m_rotation.applyInverse(windowPoint, { m_dstrect.x, m_dstrect.y });
 		windowPoint.x += -m_dstrect.x - m_renderCorner.x;
 		windowPoint.y += -m_dstrect.y - m_renderCorner.y;
 
@@ -271,9 +711,10 @@ namespace lui {
 	SDL_Point set::localToWindow(SDL_Point localPoint) {
 		localPoint.x += m_dstrect.x + m_renderCorner.x;
 		localPoint.y += m_dstrect.y + m_renderCorner.y;
-		SDL_FPoint localPointRotated = RotatePoint({ (float)localPoint.x, (float)localPoint.y }, m_angle, { m_dstrect.x, m_dstrect.y });
+		SDL_FPoint localPointRotated = m_rotation.apply({ (float)localPoint.x, (float)localPoint.y }, { m_dstrect.x, m_dstrect.y });
+		localPoint = SDL_Point{ (int)localPointRotated.x, (int)localPointRotated.y };
 		if (m_parentSet != nullptr) {
-			localPoint = m_parentSet->localToWindow(SDL_Point{ (int)localPointRotated.x, (int)localPointRotated.y });
+			localPoint = m_parentSet->localToWindow(localPoint);
 		}
 
 		return localPoint;
@@ -281,12 +722,635 @@ namespace lui {
 	SDL_FPoint set::localToWindow(SDL_FPoint localPoint) {
 		localPoint.x += m_dstrect.x + m_renderCorner.x;
 		localPoint.y += m_dstrect.y + m_renderCorner.y;
-		SDL_FPoint localPointRotated = RotatePoint({ localPoint.x, localPoint.y }, m_angle, { m_dstrect.x, m_dstrect.y });
+		localPoint = m_rotation.apply(localPoint, { m_dstrect.x, m_dstrect.y });
 		if (m_parentSet != nullptr) {
-			localPoint = m_parentSet->localToWindow(SDL_FPoint{ localPointRotated.x, localPointRotated.y });
+			localPoint = m_parentSet->localToWindow(localPoint);
 		}
 
 		return localPoint;
 	}
+	void set::windowToLocal(const SDL_FPoint *windowPoints, size_t count, SDL_FPoint *localPoints) {
+		if (m_parentSet != nullptr) {
+			m_parentSet->windowToLocal(windowPoints, count, localPoints);
+			windowPoints = localPoints;
+		}
+		RotatePoints(m_rotation.inverse(), windowPoints, count, localPoints, { m_dstrect.x, m_dstrect.y });
+		float dx = -m_dstrect.x - m_renderCorner.x, dy = -m_dstrect.y - m_renderCorner.y;
+		for (size_t i = 0; i < count; i++) {
+			localPoints[i].x += dx;
+			localPoints[i].y += dy;
+		}
+	}
+	void set::localToWindow(const SDL_FPoint *localPoints, size_t count, SDL_FPoint *windowPoints) {
+		float dx = m_dstrect.x + m_renderCorner.x, dy = m_dstrect.y + m_renderCorner.y;
+		for (size_t i = 0; i < count; i++) {
+			windowPoints[i].x = localPoints[i].x + dx;
+			windowPoints[i].y = localPoints[i].y + dy;
+		}
+		RotatePoints(m_rotation, windowPoints, count, windowPoints, { m_dstrect.x, m_dstrect.y });
+		if (m_parentSet != nullptr) {
+			m_parentSet->localToWindow(windowPoints, count, windowPoints);
+		}
+	}
+
+
+	void set::setTileCaching(bool enable, int tileSize, size_t maxTiles) {
+		m_textureMutex.lock();
+		if (enable != m_tileCaching || tileSize != m_tileSize) {
+			m_clearTiles();
+		}
+		m_tileCaching = enable;
+		m_tileSize = std::max(tileSize, 1);
+		m_maxTiles = maxTiles;
+		m_textureMutex.unlock();
+	}
+	bool set::getTileCaching() {
+		return m_tileCaching;
+	}
+	void set::setDirectRendering(bool direct) {
+		m_directRendering = direct;
+	}
+	bool set::getDirectRendering() {
+		return m_directRendering;
+	}
+	void set::setThreadedRendering(bool threaded) {
+		if (threaded == m_threadedRendering) {
+			return;
+		}
+		//Our texture and tiles, and everything the children made, were made for the other renderer
+		releaseTextures();
+		m_threadedRendering = threaded;
+		if (threaded) {
+			m_joinThreadedParent(m_parentSet);
+		}
+		else {
+			m_joinThreadedParent(nullptr);
+			m_stopWorker();
+		}
+	}
+	bool set::getThreadedRendering() {
+		return m_threadedRendering;
+	}
+	void set::invalidateRect(SDL_FRect rect) {
+		bool everything = rect.w <= 0 || rect.h <= 0;
+		m_displayListStale = true;
+		if (m_updateDepth > 0) { //Hold on to it until the update ends
+			if (everything) {
+				m_pendingEverything = true;
+			}
+			else if (!m_pendingEverything) {
+				m_pendingRects.push_back(rect);
+			}
+			return;
+		}
+		m_textureMutex.lock();
+		m_dirtyTiles(rect, everything);
+		m_textureMutex.unlock();
+		m_passInvalidation(rect, everything);
+	}
+	void set::m_dirtyTiles(const SDL_FRect &rect, bool everything) {
+		if (m_tiles.empty()) {
+			return;
+		}
+		if (!everything) {
+			int left = (int)std::floor(rect.x / m_tileSize), right = (int)std::floor((rect.x + rect.w) / m_tileSize);
+			int top = (int)std::floor(rect.y / m_tileSize), bottom = (int)std::floor((rect.y + rect.h) / m_tileSize);
+			if ((Uint64)(right - left + 1) * (Uint64)(bottom - top + 1) < m_tiles.size()) { //Look up the few tiles under the rect
+				for (int column = left; column <= right; column++) {
+					for (int row = top; row <= bottom; row++) {
+						auto t = m_tiles.find(((Uint64)(Uint32)column << 32) | (Uint32)row);
+						if (t != m_tiles.end() && !t->second.dirty) {
+							SDL_FRect tileRect{ (float)column * m_tileSize, (float)row * m_tileSize, (float)m_tileSize, (float)m_tileSize };
+							t->second.dirty = RectsOverlap(rect, tileRect);
+						}
+					}
+				}
+				return;
+			}
+		}
+		for (auto &t : m_tiles) {
+			if (!t.second.dirty) {
+				SDL_FRect tileRect{ (float)(Sint32)(t.first >> 32) * m_tileSize, (float)(Sint32)(t.first & 0xFFFFFFFF) * m_tileSize, (float)m_tileSize, (float)m_tileSize };
+				t.second.dirty = everything || RectsOverlap(rect, tileRect);
+			}
+		}
+	}
+	void set::m_passInvalidation(SDL_FRect rect, bool everything) {
+		if (m_parentSet == nullptr && m_damageRendering) { //Shown on the target itself
+			if (everything) {
+				m_damageEverything = true;
+			}
+			else if (!m_damageEverything) {
+				m_addDamage(rect);
+			}
+		}
+		//Pass it on to whoever shows us
+		if (m_parentSet != nullptr) {
+			if (m_dstrect.w > 0 && m_dstrect.h > 0 && !everything && m_rotation.identity && m_flip == SDL_FLIP_NONE && m_overlaySet == nullptr) {
+				//Only the part of our texture showing rect changed
+				SDL_FRect shown{ rect.x + m_dstrect.x + m_renderCorner.x, rect.y + m_dstrect.y + m_renderCorner.y, rect.w, rect.h };
+				float left = std::max(shown.x, m_dstrect.x), top = std::max(shown.y, m_dstrect.y);
+				float right = std::min(shown.x + shown.w, m_dstrect.x + m_dstrect.w), bottom = std::min(shown.y + shown.h, m_dstrect.y + m_dstrect.h);
+				if (right > left && bottom > top) { //Otherwise it is scrolled out of view
+					m_parentSet->invalidateRect(SDL_FRect{ left, top, right - left, bottom - top });
+				}
+			}
+			else if (m_dstrect.w > 0 && m_dstrect.h > 0) { //Our texture changed wherever it is drawn
+				invalidate();
+			}
+			else if (!everything) { //Children are drawn straight onto the parent's target
+				m_parentSet->invalidateRect(SDL_FRect{ rect.x + m_renderCorner.x, rect.y + m_renderCorner.y, rect.w, rect.h });
+			}
+			else {
+				m_parentSet->invalidateRect(rect);
+			}
+		}
+	}
+
+	void set::setRetainedRendering(bool retained) {
+		m_retainedRendering = retained;
+		m_displayList.clear();
+		m_displayListStale = true;
+	}
+	bool set::getRetainedRendering() {
+		return m_retainedRendering;
+	}
+	const displayList& set::getDisplayList() {
+		return m_displayList;
+	}
+	void set::setDamageRendering(bool damage) {
+		m_damageRendering = damage;
+		m_damage.clear();
+		m_damageEverything = true; //Nothing was tracked until now
+		m_lastDamage.clear();
+		m_overlayDamage.clear();
+	}
+	bool set::getDamageRendering() {
+		return m_damageRendering;
+	}
+	const std::vector<SDL_Rect>& set::getDamage() {
+		return m_lastDamage;
+	}
+	void set::m_addDamage(const SDL_FRect &rect) {
+		bool sized = m_dstrect.w > 0 && m_dstrect.h > 0;
+		if (sized && m_flip != SDL_FLIP_NONE) {
+			m_damageEverything = true;
+			return;
+		}
+		SDL_FRect window = rect;
+		if (sized) {
+			SDL_FPoint corners[4] = { { rect.x, rect.y }, { rect.x + rect.w, rect.y }, { rect.x + rect.w, rect.y + rect.h }, { rect.x, rect.y + rect.h } };
+			localToWindow(corners, 4, corners);
+			float left = corners[0].x, right = corners[0].x, top = corners[0].y, bottom = corners[0].y;
+			for (const SDL_FPoint &p : corners) {
+				left = std::min(left, p.x);
+				right = std::max(right, p.x);
+				top = std::min(top, p.y);
+				bottom = std::max(bottom, p.y);
+			}
+			window = SDL_FRect{ left, top, right - left, bottom - top };
+		}
+		else { //Children are drawn straight onto the target
+			window.x += m_renderCorner.x;
+			window.y += m_renderCorner.y;
+		}
+		//Every pixel touched, with one more around for rounding and smoothed edges
+		int left = (int)std::floor(window.x) - 1, top = (int)std::floor(window.y) - 1;
+		int right = (int)std::ceil(window.x + window.w) + 1, bottom = (int)std::ceil(window.y + window.h) + 1;
+		AddRegion(m_damage, SDL_Rect{ left, top, right - left, bottom - top });
+	}
+	void set::m_renderDamage(SDL_Renderer *renderer) {
+		renderBackend *backend = renderBackend::get(renderer);
+		placement now{ m_dstrect, m_renderCorner, m_angle, m_flip, m_mod };
+		if (!(now == m_damagePlacement)) {
+			m_damageEverything = true; //Moved, turned, scrolled, flipped, or faded as a whole
+			m_damagePlacement = now;
+		}
+		//The overlay is drawn fresh every frame, so where it was and where it is are damaged
+		for (const SDL_Rect &r : m_overlayDamage) {
+			AddRegion(m_damage, r);
+		}
+		m_overlayDamage.clear();
+		for (element *e : m_overlay) {
+			if (e->isVisible()) {
+				SDL_FPoint origin = e->m_parentSet->localToWindow(SDL_FPoint{ 0.f, 0.f });
+				SDL_FRect bounds = BoundingBox(e->getDstrect(), e->getRotation());
+				int left = (int)std::floor(origin.x + bounds.x) - 1, top = (int)std::floor(origin.y + bounds.y) - 1;
+				int right = (int)std::ceil(origin.x + bounds.x + bounds.w) + 1, bottom = (int)std::ceil(origin.y + bounds.y + bounds.h) + 1;
+				m_overlayDamage.push_back(SDL_Rect{ left, top, right - left, bottom - top });
+				AddRegion(m_damage, m_overlayDamage.back());
+			}
+		}
+		int w = 0, h = 0;
+		backend->getOutputSize(&w, &h);
+		SDL_Rect whole{ 0, 0, w, h };
+		m_lastDamage.clear();
+		if (m_damageEverything) {
+			m_lastDamage.push_back(whole);
+		}
+		else {
+			for (SDL_Rect &r : m_damage) {
+				if (SDL_IntersectRect(&r, &whole, &r) == SDL_TRUE) {
+					m_lastDamage.push_back(r);
+				}
+			}
+		}
+		m_damage.clear();
+		m_damageEverything = false;
+
+		SDL_Rect outerClip;
+		bool outerClipped = backend->getClipRect(&outerClip);
+		SDL_BlendMode mode;
+		backend->getDrawBlendMode(&mode);
+		static std::atomic<Uint32> frames{ 0 };
+		DamageFrame = ++frames;
+		if (DamageFrame == 0) { //0 means no damage frame
+			DamageFrame = ++frames;
+		}
+		for (const SDL_Rect &r : m_lastDamage) {
+			backend->setClipRect(&r);
+			SDL_FRect area{ (float)r.x, (float)r.y, (float)r.w, (float)r.h };
+			backend->setDrawBlendMode(SDL_BLENDMODE_NONE);
+			backend->fillRect(&area);
+			backend->setDrawBlendMode(mode);
+			m_renderContent(renderer);
+		}
+		DamageFrame = 0;
+		backend->setClipRect(outerClipped ? &outerClip : nullptr);
+	}
+
+	void set::setCoalesceEvents(bool coalesce) {
+		m_coalesceEvents = coalesce;
+	}
+	bool set::getCoalesceEvents() {
+		return m_coalesceEvents;
+	}
+
+	bool set::m_rendersDirectly() {
+		return m_directRendering && m_rotation.identity && m_flip == SDL_FLIP_NONE && !m_tileCaching && (m_mod.r & m_mod.g & m_mod.b & m_mod.a) == 255;
+	}
+	void set::m_renderDirect(SDL_Renderer *renderer) {
+		renderBackend *backend = renderBackend::get(renderer);
+		std::lock_guard<std::recursive_mutex> lock(m_textureMutex);
+		if (m_texture != nullptr) { //Drawn offscreen until now
+			renderBackend::destroyTexture(m_texture);
+			m_texture = nullptr;
+		}
+		SDL_FRect dstrect = m_renderDstrect();
+		//The pixels our texture would have covered, those whose centers are inside of dstrect
+		SDL_Rect clip{ (int)std::ceil(dstrect.x - 0.5f), (int)std::ceil(dstrect.y - 0.5f), 0, 0 };
+		clip.w = (int)std::ceil(dstrect.x + dstrect.w - 0.5f) - clip.x;
+		clip.h = (int)std::ceil(dstrect.y + dstrect.h - 0.5f) - clip.y;
+		SDL_Rect outerClip;
+		bool outerClipped = backend->getClipRect(&outerClip);
+		if (outerClipped && SDL_IntersectRect(&clip, &outerClip, &clip) == SDL_FALSE) {
+			return; //Clipped away by a set around us
+		}
+		backend->setClipRect(&clip);
+		if (m_a > 0) {
+			Uint8 r, g, b, a;
+			SDL_BlendMode mode;
+			backend->getDrawColor(&r, &g, &b, &a);
+			backend->getDrawBlendMode(&mode);
+			backend->setDrawColor(m_r, m_g, m_b, m_a);
+			backend->setDrawBlendMode(SDL_BLENDMODE_BLEND);
+			backend->fillRect(&dstrect);
+			backend->setDrawBlendMode(mode);
+			backend->setDrawColor(r, g, b, a);
+		}
+		SDL_FPoint outerOffset = m_renderOffset;
+		m_renderOffset = SDL_FPoint{ dstrect.x + m_renderCorner.x, dstrect.y + m_renderCorner.y };
+		SDL_FRect shown{ clip.x - m_renderOffset.x, clip.y - m_renderOffset.y, (float)clip.w, (float)clip.h }; //In local coordinates
+		m_renderChildren(renderer, &shown);
+		m_renderOffset = outerOffset;
+		backend->setClipRect(outerClipped ? &outerClip : nullptr);
+	}
+	void set::m_renderOffscreen(SDL_Renderer *renderer) {
+		renderBackend *backend = renderBackend::get(renderer);
+		SDL_Texture *prevRenderTarget = nullptr;
+		SDL_FPoint outerOffset = m_renderOffset;
+		SDL_FRect dstrect = m_renderDstrect();
+		SDL_Rect outerClip;
+		bool outerClipped = false;
+		//If dstrect size > 0
+		//	Lock renderer mutex
+		//	If no texture
+		//		Create texture
+		//	Set renderer target to our texture
+		//Else
+		//	If texture
+		//		Remove texture
+		if (m_dstrect.w > 0 && m_dstrect.h > 0) {
+			m_textureMutex.lock();
+			if (m_texture == nullptr) {
+				m_texture = backend->createTexture(SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, m_dstrect.w, m_dstrect.h);
+				SDL_SetTextureBlendMode(m_texture, SDL_BLENDMODE_BLEND);
+			}
+			prevRenderTarget = backend->getTarget();
+			outerClipped = backend->getClipRect(&outerClip); //SDL forgets it when switching between textures
+			backend->setTarget(m_texture);
+			Uint8 r, g, b, a;
+			backend->getDrawColor(&r, &g, &b, &a);
+			backend->setDrawColor(m_r, m_g, m_b, m_a);
+			backend->clear();
+			backend->setDrawColor(r, g, b, a);
+		}
+		else if (m_texture != nullptr && m_dstrect.w <= 0 && m_dstrect.h <= 0) {
+			renderBackend::destroyTexture(m_texture);
+			m_texture = nullptr;
+		}
+		//Render to target
+		if (m_dstrect.w > 0 && m_dstrect.h > 0 && m_tileCaching) {
+			m_renderTiles(renderer);
+		}
+		else {
+			SDL_Rect clip;
+			SDL_FRect shown;
+			bool clipped = false;
+			if (m_dstrect.w > 0 && m_dstrect.h > 0) { //Our own texture, so start from its corner
+				m_renderOffset = m_renderCorner;
+			}
+			else {
+				m_renderOffset.x += m_renderCorner.x;
+				m_renderOffset.y += m_renderCorner.y;
+				clipped = backend->getClipRect(&clip); //Children are drawn straight onto the target, so skip those clipped away
+				shown = SDL_FRect{ clip.x - m_renderOffset.x, clip.y - m_renderOffset.y, (float)clip.w, (float)clip.h };
+			}
+			m_renderChildren(renderer, clipped ? &shown : nullptr);
+		}
+		m_renderOffset = outerOffset;
+		//If dstrect size > 0
+		//	Set renderer target back to previous
+		//	Draw our texture in desired location
+		//	Free mutex
+		if (m_dstrect.w > 0 && m_dstrect.h > 0) {
+			backend->setTarget(prevRenderTarget);
+			backend->setClipRect(outerClipped ? &outerClip : nullptr);
+			m_textureMutex.unlock();
+			m_applyMod(m_texture);
+			backend->copy(m_texture, NULL, &dstrect, m_angle, &zeroFPoint, m_flip);
+			m_clearMod(m_texture);
+		}
+	}
+	void set::m_renderTexture(SDL_Renderer *renderer) {
+		std::lock_guard<std::recursive_mutex> lock(m_textureMutex);
+		if (m_texture == nullptr) {
+			return;
+		}
+		SDL_FRect dstrect = m_renderDstrect();
+		m_applyMod(m_texture);
+		renderBackend::get(renderer)->copy(m_texture, NULL, &dstrect, m_angle, &zeroFPoint, m_flip);
+		m_clearMod(m_texture);
+	}
+	void set::m_cullChildren(const SDL_FRect *area) {
+		//Front to back, leaving out children inside of an opaque, unrotated child in front of them
+		const size_t maxOccluders = 8; //Keep the largest, so culling stays cheap with many small opaque children
+		m_drawList.clear();
+		m_occluders.clear();
+		for (auto it = m_elements.rbegin(); it != m_elements.rend(); it++) {
+			element *e = *it;
+			if (!e->isVisible() || e->m_overlaySet != nullptr) {
+				continue;
+			}
+			SDL_FRect dr = e->getDstrect();
+			if (dr.w <= 0 || dr.h <= 0) { //Elements with no size may draw anywhere
+				m_drawList.push_back(e);
+				continue;
+			}
+			SDL_FRect bounds = BoundingBox(dr, e->getRotation());
+			if (area != nullptr) {
+				if (!RectsOverlap(bounds, *area)) {
+					continue;
+				}
+				float x = std::max(bounds.x, area->x), y = std::max(bounds.y, area->y); //Only the part shown needs covering
+				bounds = SDL_FRect{ x, y, std::min(bounds.x + bounds.w, area->x + area->w) - x, std::min(bounds.y + bounds.h, area->y + area->h) - y };
+			}
+			if (std::any_of(m_occluders.begin(), m_occluders.end(), [&bounds](const SDL_FRect &o) { return RectContains(o, bounds); })) {
+				continue;
+			}
+			m_drawList.push_back(e);
+			if (e->getRotation().identity && e->isOpaque()) {
+				if (m_occluders.size() < maxOccluders) {
+					m_occluders.push_back(dr);
+				}
+				else {
+					auto smallest = std::min_element(m_occluders.begin(), m_occluders.end(), [](const SDL_FRect &l, const SDL_FRect &r) {
+						return l.w * l.h < r.w * r.h;
+					});
+					if (smallest->w * smallest->h < dr.w * dr.h) {
+						*smallest = dr;
+					}
+				}
+			}
+		}
+	}
+	void set::m_renderChildren(SDL_Renderer *renderer, const SDL_FRect *area) {
+		if (!m_retainedRendering) {
+			m_cullChildren(area);
+		}
+		else if (m_displayListStale.exchange(false)) { //Record everything, the area is left to the replay; cleared first so changes made meanwhile record again
+			m_cullChildren(nullptr);
+			m_displayList.clear();
+			for (auto it = m_drawList.rbegin(); it != m_drawList.rend(); it++) {
+				if (!(*it)->record(m_displayList)) {
+					m_displayList.render(*it);
+				}
+			}
+			m_displayList.groupByTexture();
+		}
+		if (!OnWorker && !m_threadedSets.empty()) {
+			//Start every threaded child first, so they draw while the others are drawn here
+			m_threadedSets.erase(std::remove_if(m_threadedSets.begin(), m_threadedSets.end(), [this](set *s) {
+				return s->m_threadedParent != this;
+			}), m_threadedSets.end());
+			for (set *s : m_threadedSets) {
+				if (s->m_parentSet == this && s->m_dstrect.w > 0 && s->m_dstrect.h > 0 && std::find(m_drawList.begin(), m_drawList.end(), s) != m_drawList.end()
+					&& (area == nullptr || RectsOverlap(BoundingBox(s->m_dstrect, s->m_rotation), *area))) {
+					s->m_startWorker();
+				}
+			}
+		}
+		if (m_retainedRendering) {
+			m_displayList.replay(renderer, m_renderOffset, area);
+			return;
+		}
+		for (auto it = m_drawList.rbegin(); it != m_drawList.rend(); it++) {
+			(*it)->render(renderer);
+		}
+	}
+	void set::m_joinThreadedParent(set *parent) {
+		if (parent == m_threadedParent) {
+			return;
+		}
+		if (m_threadedParent != nullptr) {
+			std::vector<set*> &siblings = m_threadedParent->m_threadedSets;
+			siblings.erase(std::remove(siblings.begin(), siblings.end(), this), siblings.end());
+		}
+		m_threadedParent = parent;
+		if (parent != nullptr) {
+			parent->m_threadedSets.push_back(this);
+		}
+	}
+	void set::m_startWorker() {
+		if (m_workerDone.valid() || (DamageFrame != 0 && m_regionFrame == DamageFrame)) { //Already started, or drawn for an earlier region
+			return;
+		}
+		int w = (int)m_dstrect.w, h = (int)m_dstrect.h;
+		if (m_workerSurface == nullptr || m_workerSurface->w != w || m_workerSurface->h != h) {
+			SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_ARGB8888);
+			if (surface == nullptr) {
+				return;
+			}
+			if (m_workerBackend == nullptr) {
+				m_workerBackend = new surfaceBackend(surface);
+				m_workerBackend->attach();
+			}
+			else {
+				m_workerBackend->setSurface(surface); //Keeps the textures children made
+			}
+			SDL_FreeSurface(m_workerSurface);
+			m_workerSurface = surface;
+		}
+		if (m_workerBackend->getRenderer() == nullptr) {
+			return;
+		}
+		//packaged_task can't be copied into a std::function
+		std::shared_ptr<std::packaged_task<void()>> task = std::make_shared<std::packaged_task<void()>>([this]() { m_drawOnWorker(); });
+		m_workerDone = task->get_future();
+		Workers().push([task]() { (*task)(); });
+	}
+	void set::m_drawOnWorker() {
+		std::lock_guard<std::recursive_mutex> lock(m_textureMutex);
+		SDL_Renderer *renderer = m_workerBackend->getRenderer();
+		m_workerBackend->setTarget(nullptr);
+		m_workerBackend->setDrawColor(m_r, m_g, m_b, m_a);
+		m_workerBackend->clear();
+		if (m_tileCaching) {
+			m_renderTiles(renderer);
+		}
+		else {
+			m_renderOffset = m_renderCorner;
+			m_renderChildren(renderer, nullptr);
+		}
+	}
+	void set::m_renderThreaded(SDL_Renderer *renderer) {
+		if (m_parentSet != m_threadedParent) { //Moved to another set since last drawn
+			m_joinThreadedParent(m_parentSet);
+		}
+		m_startWorker();
+		if (!m_workerDone.valid()) {
+			return;
+		}
+		m_workerDone.get();
+		renderBackend *backend = renderBackend::get(renderer);
+		SDL_FRect dstrect = m_renderDstrect();
+		m_textureMutex.lock();
+		if (m_texture == nullptr) {
+			m_texture = backend->createTexture(SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, m_workerSurface->w, m_workerSurface->h);
+			SDL_SetTextureBlendMode(m_texture, SDL_BLENDMODE_BLEND);
+		}
+		backend->updateTexture(m_texture, nullptr, m_workerSurface->pixels, m_workerSurface->pitch);
+		m_applyMod(m_texture);
+		backend->copy(m_texture, NULL, &dstrect, m_angle, &zeroFPoint, m_flip);
+		m_clearMod(m_texture);
+		m_textureMutex.unlock();
+	}
+	void set::m_stopWorker() {
+		if (m_workerBackend == nullptr) {
+			return;
+		}
+		textCache::global().clearRenderer(m_workerBackend->getRenderer());
+		delete m_workerBackend;
+		m_workerBackend = nullptr;
+		SDL_FreeSurface(m_workerSurface);
+		m_workerSurface = nullptr;
+	}
+	void set::m_renderOverlay(SDL_Renderer *renderer) {
+		SDL_FPoint outerOffset = m_renderOffset;
+		for (element *e : m_overlay) {
+			if (!e->isVisible()) {
+				continue;
+			}
+			//Where the element's set puts its local origin on screen
+			SDL_FPoint origin = e->m_parentSet->localToWindow(SDL_FPoint{ 0.f, 0.f });
+			m_renderOffset = SDL_FPoint{ outerOffset.x + origin.x, outerOffset.y + origin.y };
+			e->render(renderer);
+		}
+		m_renderOffset = outerOffset;
+	}
+	void set::m_renderTiles(SDL_Renderer *renderer) {
+		//Range of tiles on screen, in local coordinates
+		int size = m_tileSize;
+		int firstColumn = (int)std::floor(-m_renderCorner.x / size), lastColumn = (int)std::ceil((m_dstrect.w - m_renderCorner.x) / size) - 1;
+		int firstRow = (int)std::floor(-m_renderCorner.y / size), lastRow = (int)std::ceil((m_dstrect.h - m_renderCorner.y) / size) - 1;
+		size_t onScreen = (size_t)(lastColumn - firstColumn + 1) * (lastRow - firstRow + 1);
+		m_tileFrame++;
+
+		renderBackend *backend = renderBackend::get(renderer);
+		SDL_Texture *target = backend->getTarget(); //m_texture, or the worker's surface
+		Uint8 r, g, b, a;
+		backend->getDrawColor(&r, &g, &b, &a);
+		for (int row = firstRow; row <= lastRow; row++) {
+			for (int column = firstColumn; column <= lastColumn; column++) {
+				tile &t = m_tiles[((Uint64)(Uint32)column << 32) | (Uint32)row];
+				if (t.texture == nullptr) {
+					if (!m_spareTiles.empty()) {
+						t.texture = m_spareTiles.back();
+						m_spareTiles.pop_back();
+					}
+					else {
+						t.texture = backend->createTexture(SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, size, size);
+						SDL_SetTextureBlendMode(t.texture, SDL_BLENDMODE_NONE); //Tiles replace what is under them, as if drawn directly
+					}
+					t.dirty = true;
+				}
+				if (t.texture == nullptr) {
+					continue; //Out of texture memory, don't draw onto the window by accident
+				}
+				if (t.dirty) {
+					backend->setTarget(t.texture);
+					backend->setDrawColor(m_r, m_g, m_b, m_a);
+					backend->clear();
+					backend->setDrawColor(r, g, b, a);
+					SDL_FRect area{ (float)column * size, (float)row * size, (float)size, (float)size };
+					m_renderOffset = SDL_FPoint{ -area.x, -area.y };
+					m_renderChildren(renderer, &area);
+					backend->setTarget(target);
+					t.dirty = false;
+				}
+				t.lastUsed = m_tileFrame;
+				SDL_FRect dst{ (float)column * size + m_renderCorner.x, (float)row * size + m_renderCorner.y, (float)size, (float)size };
+				backend->copy(t.texture, NULL, &dst);
+			}
+		}
+
+		//Drop the tiles unused for the longest, keeping their textures for the next tiles to come on screen
+		size_t maxTiles = m_maxTiles != 0 ? std::max(m_maxTiles, onScreen) : onScreen * 4;
+		while (m_tiles.size() > maxTiles) {
+			auto oldest = m_tiles.begin();
+			for (auto it = m_tiles.begin(); it != m_tiles.end(); it++) {
+				if (it->second.lastUsed < oldest->second.lastUsed) {
+					oldest = it;
+				}
+			}
+			if (oldest->second.texture != nullptr && m_spareTiles.size() < onScreen) {
+				m_spareTiles.push_back(oldest->second.texture);
+			}
+			else {
+				renderBackend::destroyTexture(oldest->second.texture);
+			}
+			m_tiles.erase(oldest);
+		}
+	}
+	void set::m_clearTiles() {
+		for (auto &t : m_tiles) {
+			renderBackend::destroyTexture(t.second.texture);
+		}
+		m_tiles.clear();
+		for (SDL_Texture *texture : m_spareTiles) {
+			renderBackend::destroyTexture(texture);
+		}
+		m_spareTiles.clear();
+	}
 
 }
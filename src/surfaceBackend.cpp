@@ -0,0 +1,836 @@
+#include "./surfaceBackend.hpp"
+
+extern "C" {
+#include <SDL2/SDL.h>
+}
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include "./extra.hpp" //rotation, RotatePoints
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LUI_SURFACE_SSE2
+#include <emmintrin.h>
+#if defined(__AVX2__)
+#define LUI_SURFACE_AVX2
+#define LUI_SURFACE_AVX2_TARGET
+#include <immintrin.h>
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LUI_SURFACE_AVX2
+#define LUI_SURFACE_AVX2_DISPATCH //Built for AVX2 on their own, and only used if the CPU has it
+#define LUI_SURFACE_AVX2_TARGET __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && SDL_BYTEORDER == SDL_LIL_ENDIAN
+#define LUI_SURFACE_NEON
+#include <arm_neon.h>
+#endif
+
+namespace lui {
+
+	namespace {
+		const Uint32 opaqueWhite = 0xFFFFFFFF; //Modulation which changes nothing
+
+		//round(t / 255), exactly, for t up to 255 * 255
+		inline Uint32 Div255(Uint32 t) {
+			t += 128;
+			return (t + (t >> 8)) >> 8;
+		}
+		//One ARGB8888 pixel; every vector path gives the same result as this
+		inline Uint32 BlendPixel(Uint32 d, Uint32 s, Uint32 mod, SDL_BlendMode mode) {
+			Uint32 sa = Div255((s >> 24) * (mod >> 24)), sr = Div255(((s >> 16) & 0xFF) * ((mod >> 16) & 0xFF));
+			Uint32 sg = Div255(((s >> 8) & 0xFF) * ((mod >> 8) & 0xFF)), sb = Div255((s & 0xFF) * (mod & 0xFF));
+			Uint32 da = d >> 24, dr = (d >> 16) & 0xFF, dg = (d >> 8) & 0xFF, db = d & 0xFF;
+			switch (mode) {
+			case SDL_BLENDMODE_NONE:
+				return (sa << 24) | (sr << 16) | (sg << 8) | sb;
+			case SDL_BLENDMODE_ADD:
+				dr = std::min(dr + Div255(sr * sa), 255u);
+				dg = std::min(dg + Div255(sg * sa), 255u);
+				db = std::min(db + Div255(sb * sa), 255u);
+				break;
+			case SDL_BLENDMODE_MOD:
+				dr = Div255(sr * dr);
+				dg = Div255(sg * dg);
+				db = Div255(sb * db);
+				break;
+			default: { //SDL_BLENDMODE_BLEND
+				Uint32 inverse = 255 - sa;
+				da = Div255(255 * sa + da * inverse);
+				dr = Div255(sr * sa + dr * inverse);
+				dg = Div255(sg * sa + dg * inverse);
+				db = Div255(sb * sa + db * inverse);
+			}
+			}
+			return (da << 24) | (dr << 16) | (dg << 8) | db;
+		}
+
+#if defined(LUI_SURFACE_SSE2)
+		inline __m128i Div255Epi16(__m128i t) {
+			t = _mm_add_epi16(t, _mm_set1_epi16(128));
+			return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+		}
+		//Two pixels widened to 16 bits a channel
+		inline __m128i BlendHalfSSE2(__m128i s, __m128i d, __m128i mod, bool modulate, bool blend) {
+			if (modulate) {
+				s = Div255Epi16(_mm_mullo_epi16(s, mod));
+			}
+			if (!blend) {
+				return s;
+			}
+			__m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			s = _mm_or_si128(_mm_and_si128(s, _mm_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0)), _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255)); //Alpha blends as if the source were 255
+			__m128i inverse = _mm_sub_epi16(_mm_set1_epi16(255), a);
+			return Div255Epi16(_mm_add_epi16(_mm_mullo_epi16(s, a), _mm_mullo_epi16(d, inverse)));
+		}
+#endif
+#if defined(LUI_SURFACE_AVX2)
+		LUI_SURFACE_AVX2_TARGET inline __m256i Div255Epi16AVX2(__m256i t) {
+			t = _mm256_add_epi16(t, _mm256_set1_epi16(128));
+			return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+		}
+		LUI_SURFACE_AVX2_TARGET inline __m256i BlendHalfAVX2(__m256i s, __m256i d, __m256i mod, bool modulate, bool blend) {
+			if (modulate) {
+				s = Div255Epi16AVX2(_mm256_mullo_epi16(s, mod));
+			}
+			if (!blend) {
+				return s;
+			}
+			__m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			s = _mm256_or_si256(_mm256_and_si256(s, _mm256_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0)), _mm256_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255));
+			__m256i inverse = _mm256_sub_epi16(_mm256_set1_epi16(255), a);
+			return Div255Epi16AVX2(_mm256_add_epi16(_mm256_mullo_epi16(s, a), _mm256_mullo_epi16(d, inverse)));
+		}
+		//Eight pixels a step; returns how many were done
+		LUI_SURFACE_AVX2_TARGET int BlendSpanAVX2(Uint32 *dst, const Uint32 *src, int count, Uint32 mod, bool blend) {
+			const __m256i zero = _mm256_setzero_si256(), opaque = _mm256_set1_epi32((int)0xFF000000);
+			const __m256i mod16 = _mm256_unpacklo_epi8(_mm256_set1_epi32((int)mod), zero);
+			bool modulate = mod != opaqueWhite;
+			int i = 0;
+			for (; i + 8 <= count; i += 8) {
+				__m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+				if (blend && !modulate) {
+					__m256i alpha = _mm256_and_si256(s, opaque);
+					if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(alpha, opaque)) == -1) { //Opaque, so just copied
+						_mm256_storeu_si256((__m256i*)(dst + i), s);
+						continue;
+					}
+					if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(alpha, zero)) == -1) { //Clear, so nothing changes
+						continue;
+					}
+				}
+				__m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+				__m256i low = BlendHalfAVX2(_mm256_unpacklo_epi8(s, zero), _mm256_unpacklo_epi8(d, zero), mod16, modulate, blend);
+				__m256i high = BlendHalfAVX2(_mm256_unpackhi_epi8(s, zero), _mm256_unpackhi_epi8(d, zero), mod16, modulate, blend);
+				_mm256_storeu_si256((__m256i*)(dst + i), _mm256_packus_epi16(low, high));
+			}
+			return i;
+		}
+		//Eight texels a step, sampled along a line through the source; returns how many were done
+		LUI_SURFACE_AVX2_TARGET int GatherSpanAVX2(Uint32 *row, const Uint32 *pixels, int stride, float u, float v, float du, float dv, float maxU, float maxV, int count) {
+			const __m256 lanes = _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f), zero = _mm256_setzero_ps();
+			const __m256 u0 = _mm256_set1_ps(u), v0 = _mm256_set1_ps(v), stepU = _mm256_set1_ps(du), stepV = _mm256_set1_ps(dv);
+			const __m256 highU = _mm256_set1_ps(maxU), highV = _mm256_set1_ps(maxV);
+			const __m256i rowStride = _mm256_set1_epi32(stride);
+			int i = 0;
+			for (; i + 8 <= count; i += 8) {
+				__m256 index = _mm256_add_ps(_mm256_set1_ps((float)i), lanes);
+				__m256 x = _mm256_min_ps(_mm256_max_ps(_mm256_add_ps(u0, _mm256_mul_ps(index, stepU)), zero), highU);
+				__m256 y = _mm256_min_ps(_mm256_max_ps(_mm256_add_ps(v0, _mm256_mul_ps(index, stepV)), zero), highV);
+				__m256i offsets = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_cvttps_epi32(y), rowStride), _mm256_cvttps_epi32(x));
+				_mm256_storeu_si256((__m256i*)(row + i), _mm256_i32gather_epi32((const int*)pixels, offsets, 4));
+			}
+			return i;
+		}
+		bool HasAVX2() {
+#if defined(LUI_SURFACE_AVX2_DISPATCH)
+			static const bool has = __builtin_cpu_supports("avx2");
+			return has;
+#else
+			return true;
+#endif
+		}
+#endif
+
+		//Blend count source pixels, modulated by mod, onto dst
+		void BlendSpan(Uint32 *dst, const Uint32 *src, int count, Uint32 mod, SDL_BlendMode mode) {
+			int i = 0;
+			if (mode == SDL_BLENDMODE_NONE && mod == opaqueWhite) {
+				std::memcpy(dst, src, count * sizeof(Uint32));
+				return;
+			}
+			if (mode == SDL_BLENDMODE_NONE || mode == SDL_BLENDMODE_BLEND) {
+				bool blend = mode == SDL_BLENDMODE_BLEND;
+#if defined(LUI_SURFACE_AVX2)
+				if (HasAVX2()) {
+					i = BlendSpanAVX2(dst, src, count, mod, blend);
+				}
+#endif
+#if defined(LUI_SURFACE_SSE2)
+				const __m128i zero = _mm_setzero_si128(), opaque = _mm_set1_epi32((int)0xFF000000);
+				const __m128i mod16 = _mm_unpacklo_epi8(_mm_set1_epi32((int)mod), zero);
+				bool modulate = mod != opaqueWhite;
+				for (; i + 4 <= count; i += 4) {
+					__m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+					if (blend && !modulate) {
+						__m128i alpha = _mm_and_si128(s, opaque);
+						if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, opaque)) == 0xFFFF) { //Opaque, so just copied
+							_mm_storeu_si128((__m128i*)(dst + i), s);
+							continue;
+						}
+						if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, zero)) == 0xFFFF) { //Clear, so nothing changes
+							continue;
+						}
+					}
+					__m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+					__m128i low = BlendHalfSSE2(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero), mod16, modulate, blend);
+					__m128i high = BlendHalfSSE2(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero), mod16, modulate, blend);
+					_mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(low, high));
+				}
+#elif defined(LUI_SURFACE_NEON)
+				bool modulate = mod != opaqueWhite;
+				const uint8x8_t modB = vdup_n_u8(mod & 0xFF), modG = vdup_n_u8((mod >> 8) & 0xFF), modR = vdup_n_u8((mod >> 16) & 0xFF), modA = vdup_n_u8(mod >> 24);
+				const uint8x8_t full = vdup_n_u8(255);
+				for (; i + 8 <= count; i += 8) {
+					uint8x8x4_t s = vld4_u8((const uint8_t*)(src + i)); //Blue, green, red, alpha
+					if (modulate) {
+						s.val[0] = vrshrn_n_u16(vrsraq_n_u16(vmull_u8(s.val[0], modB), vmull_u8(s.val[0], modB), 8), 8);
+						s.val[1] = vrshrn_n_u16(vrsraq_n_u16(vmull_u8(s.val[1], modG), vmull_u8(s.val[1], modG), 8), 8);
+						s.val[2] = vrshrn_n_u16(vrsraq_n_u16(vmull_u8(s.val[2], modR), vmull_u8(s.val[2], modR), 8), 8);
+						s.val[3] = vrshrn_n_u16(vrsraq_n_u16(vmull_u8(s.val[3], modA), vmull_u8(s.val[3], modA), 8), 8);
+					}
+					if (!blend) {
+						vst4_u8((uint8_t*)(dst + i), s);
+						continue;
+					}
+					uint8x8x4_t d = vld4_u8((const uint8_t*)(dst + i));
+					uint8x8_t a = s.val[3], inverse = vmvn_u8(a);
+					for (int c = 0; c < 4; c++) {
+						uint16x8_t t = vmlal_u8(vmull_u8(c == 3 ? full : s.val[c], a), d.val[c], inverse);
+						d.val[c] = vrshrn_n_u16(vrsraq_n_u16(t, t, 8), 8);
+					}
+					vst4_u8((uint8_t*)(dst + i), d);
+				}
+#endif
+			}
+			for (; i < count; i++) {
+				dst[i] = BlendPixel(dst[i], src[i], mod, mode);
+			}
+		}
+		//Blend one color onto count pixels
+		void FillSpan(Uint32 *dst, int count, Uint32 color, SDL_BlendMode mode) {
+			Uint32 alpha = color >> 24;
+			if (mode == SDL_BLENDMODE_NONE || (mode == SDL_BLENDMODE_BLEND && alpha == 255)) {
+				std::fill(dst, dst + count, color);
+				return;
+			}
+			if (mode == SDL_BLENDMODE_BLEND && alpha == 0) {
+				return;
+			}
+			int i = 0;
+			if (mode == SDL_BLENDMODE_BLEND) {
+				//The color's share of each channel is the same for every pixel
+				Uint32 inverse = 255 - alpha;
+				Uint16 share[4] = { (Uint16)((color & 0xFF) * alpha), (Uint16)(((color >> 8) & 0xFF) * alpha), (Uint16)(((color >> 16) & 0xFF) * alpha), (Uint16)(255 * alpha) };
+#if defined(LUI_SURFACE_SSE2)
+				const __m128i zero = _mm_setzero_si128(), inverse16 = _mm_set1_epi16((short)inverse);
+				const __m128i share16 = _mm_setr_epi16((short)share[0], (short)share[1], (short)share[2], (short)share[3], (short)share[0], (short)share[1], (short)share[2], (short)share[3]);
+				for (; i + 4 <= count; i += 4) {
+					__m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+					__m128i low = Div255Epi16(_mm_add_epi16(share16, _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), inverse16)));
+					__m128i high = Div255Epi16(_mm_add_epi16(share16, _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), inverse16)));
+					_mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(low, high));
+				}
+#elif defined(LUI_SURFACE_NEON)
+				const uint8x8_t inverse8 = vdup_n_u8((uint8_t)inverse);
+				for (; i + 8 <= count; i += 8) {
+					uint8x8x4_t d = vld4_u8((const uint8_t*)(dst + i));
+					for (int c = 0; c < 4; c++) {
+						uint16x8_t t = vmlal_u8(vdupq_n_u16(share[c]), d.val[c], inverse8);
+						d.val[c] = vrshrn_n_u16(vrsraq_n_u16(t, t, 8), 8);
+					}
+					vst4_u8((uint8_t*)(dst + i), d);
+				}
+#endif
+			}
+			for (; i < count; i++) {
+				dst[i] = BlendPixel(dst[i], color, opaqueWhite, mode);
+			}
+		}
+		//Sample count texels along a line through the source, nearest neighbour, clamped to the source
+		void GatherSpan(Uint32 *row, const Uint32 *pixels, int stride, float u, float v, float du, float dv, int w, int h, int count) {
+			int i = 0;
+			float maxU = (float)(w - 1), maxV = (float)(h - 1);
+#if defined(LUI_SURFACE_AVX2)
+			if (HasAVX2()) {
+				i = GatherSpanAVX2(row, pixels, stride, u, v, du, dv, maxU, maxV, count);
+			}
+#endif
+#if defined(LUI_SURFACE_SSE2)
+			//Coordinates four at a time; SSE2 has no gather, so the loads are one by one
+			const __m128 lanes = _mm_setr_ps(0.f, 1.f, 2.f, 3.f), zero = _mm_setzero_ps();
+			const __m128 u0 = _mm_set1_ps(u), v0 = _mm_set1_ps(v), stepU = _mm_set1_ps(du), stepV = _mm_set1_ps(dv);
+			const __m128 highU = _mm_set1_ps(maxU), highV = _mm_set1_ps(maxV);
+			alignas(16) int xs[4], ys[4];
+			for (; i + 4 <= count; i += 4) {
+				__m128 index = _mm_add_ps(_mm_set1_ps((float)i), lanes);
+				_mm_store_si128((__m128i*)xs, _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_add_ps(u0, _mm_mul_ps(index, stepU)), zero), highU)));
+				_mm_store_si128((__m128i*)ys, _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_add_ps(v0, _mm_mul_ps(index, stepV)), zero), highV)));
+				for (int j = 0; j < 4; j++) {
+					row[i + j] = pixels[ys[j] * stride + xs[j]];
+				}
+			}
+#elif defined(LUI_SURFACE_NEON)
+			const float laneValues[4] = { 0.f, 1.f, 2.f, 3.f };
+			const float32x4_t lanes = vld1q_f32(laneValues), zero = vdupq_n_f32(0.f), highU = vdupq_n_f32(maxU), highV = vdupq_n_f32(maxV);
+			const int32x4_t rowStride = vdupq_n_s32(stride);
+			int offsets[4];
+			for (; i + 4 <= count; i += 4) {
+				float32x4_t index = vaddq_f32(vdupq_n_f32((float)i), lanes);
+				float32x4_t x = vminq_f32(vmaxq_f32(vaddq_f32(vdupq_n_f32(u), vmulq_n_f32(index, du)), zero), highU);
+				float32x4_t y = vminq_f32(vmaxq_f32(vaddq_f32(vdupq_n_f32(v), vmulq_n_f32(index, dv)), zero), highV);
+				vst1q_s32(offsets, vmlaq_s32(vcvtq_s32_f32(x), vcvtq_s32_f32(y), rowStride));
+				for (int j = 0; j < 4; j++) {
+					row[i + j] = pixels[offsets[j]];
+				}
+			}
+#endif
+			for (; i < count; i++) {
+				float x = std::min(std::max(u + (float)i * du, 0.f), maxU), y = std::min(std::max(v + (float)i * dv, 0.f), maxV);
+				row[i] = pixels[(int)y * stride + (int)x];
+			}
+		}
+		//Narrow [start, end) to where 0 <= f0 + i * step < limit; the same sums as GatherSpan, so the ends agree with it
+		void InsideSpan(float f0, float step, float limit, int &start, int &end) {
+			auto inside = [&](int i) {
+				float f = f0 + (float)i * step;
+				return f >= 0.f && f < limit;
+			};
+			if (step != 0.f) {
+				float a = -f0 / step, b = (limit - f0) / step;
+				float low = std::max(std::min(a, b), -1e9f), high = std::min(std::max(a, b), 1e9f);
+				start = std::max(start, (int)std::floor(low) - 1);
+				end = std::min(end, (int)std::ceil(high) + 1);
+			}
+			while (start < end && !inside(start)) {
+				start++;
+			}
+			while (end > start && !inside(end - 1)) {
+				end--;
+			}
+		}
+		SDL_Rect Intersect(const SDL_Rect &a, const SDL_Rect &b) {
+			int x = std::max(a.x, b.x), y = std::max(a.y, b.y);
+			int w = std::min(a.x + a.w, b.x + b.w) - x, h = std::min(a.y + a.h, b.y + b.h) - y;
+			return SDL_Rect{ x, y, std::max(w, 0), std::max(h, 0) };
+		}
+		inline Uint32* PixelRow(SDL_Surface *surface, int y) {
+			return (Uint32*)((Uint8*)surface->pixels + (size_t)y * surface->pitch);
+		}
+		inline bool Drawable(SDL_Surface *surface) {
+			return surface != nullptr && surface->pixels != nullptr && surface->format->BytesPerPixel == 4;
+		}
+		inline bool Supported(SDL_Surface *surface) {
+			return surface->format->format == SDL_PIXELFORMAT_ARGB8888 || surface->format->format == SDL_PIXELFORMAT_RGB888;
+		}
+
+		//Copies of textures made elsewhere, given with shareTexture()
+		struct sharedCopies {
+			std::mutex mutex;
+			std::unordered_map<SDL_Texture*, SDL_Surface*> copies;
+		};
+		sharedCopies& Shared() {
+			//Never destroyed; textures may be destroyed during static destruction
+			static sharedCopies *shared = new sharedCopies();
+			return *shared;
+		}
+	}
+
+	surfaceBackend::surfaceBackend(SDL_Surface *surface) : renderBackend(m_makeRenderer(surface)) {
+		m_surface = surface;
+		m_target = surface;
+		if (surface != nullptr && !Supported(surface)) {
+			SDL_SetError("surfaceBackend needs an ARGB8888 or RGB888 surface");
+			m_surface = m_target = nullptr;
+		}
+	}
+	surfaceBackend::~surfaceBackend() {
+		detach();
+		std::lock_guard<std::recursive_mutex> lock(m_mutex);
+		for (auto &c : m_copies) {
+			SDL_FreeSurface(c.second);
+		}
+		SDL_DestroyRenderer(getRenderer()); //Along with its textures
+	}
+	SDL_Renderer* surfaceBackend::m_makeRenderer(SDL_Surface *surface) {
+		return surface != nullptr ? SDL_CreateSoftwareRenderer(surface) : nullptr;
+	}
+	void surfaceBackend::m_forgetTexture(SDL_Texture *texture) {
+		std::lock_guard<std::recursive_mutex> lock(m_mutex);
+		auto found = m_copies.find(texture);
+		if (found != m_copies.end()) {
+			if (m_targetTexture == texture) {
+				setTarget(nullptr);
+			}
+			SDL_FreeSurface(found->second);
+			m_copies.erase(found);
+		}
+	}
+	SDL_Surface* surfaceBackend::m_copyOf(SDL_Texture *texture) {
+		auto found = m_copies.find(texture);
+		if (found != m_copies.end()) {
+			return found->second;
+		}
+		sharedCopies &shared = Shared();
+		std::lock_guard<std::mutex> lock(shared.mutex);
+		auto given = shared.copies.find(texture);
+		if (given == shared.copies.end()) {
+			SDL_SetError("Texture was not made by this surfaceBackend or shared with shareTexture()");
+			return nullptr;
+		}
+		return given->second;
+	}
+	SDL_Rect surfaceBackend::m_drawable() {
+		SDL_Rect whole{ 0, 0, m_target->w, m_target->h };
+		return m_clipEnabled ? Intersect(whole, m_clip) : whole;
+	}
+	Uint32 surfaceBackend::m_drawPixel() {
+		return ((Uint32)m_drawColor.a << 24) | ((Uint32)m_drawColor.r << 16) | ((Uint32)m_drawColor.g << 8) | m_drawColor.b;
+	}
+	void surfaceBackend::m_fillPixels(const SDL_Rect &rect, Uint32 color, SDL_BlendMode mode) {
+		SDL_Rect area = Intersect(rect, m_drawable());
+		for (int y = area.y; y < area.y + area.h; y++) {
+			FillSpan(PixelRow(m_target, y) + area.x, area.w, color, mode);
+		}
+	}
+
+	SDL_Surface* surfaceBackend::getSurface() {
+		std::lock_guard<std::recursive_mutex> lock(m_mutex);
+		return m_surface;
+	}
+	int surfaceBackend::setSurface(SDL_Surface *surface) {
+		std::lock_guard<std::recursive_mutex> lock(m_mutex);
+		if (surface == nullptr || !Supported(surface)) {
+			return SDL_SetError("surfaceBackend needs an ARGB8888 or RGB888 surface");
+		}
+		m_surface = surface;
+		if (m_targetTexture == nullptr) {
+			m_target = surface;
+		}
+		return 0;
+	}
+	int surfaceBackend::shareTexture(SDL_Texture *texture, SDL_Surface *pixels) {
+		if (texture == nullptr || pixels == nullptr) {
+			return -1;
+		}
+		SDL_Surface *copy = SDL_ConvertSurfaceFormat(pixels, SDL_PIXELFORMAT_ARGB8888, 0);
+		if (copy == nullptr) {
+			return -1;
+		}
+		sharedCopies &shared = Shared();
+		std::lock_guard<std::mutex> lock(shared.mutex);
+		SDL_Surface *&slot = shared.copies[texture];
+		SDL_FreeSurface(slot); //Shared again
+		slot = copy;
+		return 0;
+	}
+	void surfaceBackend::unshareTexture(SDL_Texture *texture) {
+		sharedCopies &shared = Shared();
+		std::lock_guard<std::mutex> lock(shared.mutex);
+		auto found = shared.copies.find(texture);
+		if (found != shared.copies.end()) {
+			SDL_FreeSurface(found->second);
+			shared.copies.erase(found);
+		}
+	}
+	const char* surfaceBackend::getKernels() {
+#if defined(LUI_SURFACE_AVX2)
+		if (HasAVX2()) {
+			return "AVX2";
+		}
+#endif
+#if defined(LUI_SURFACE_SSE2)
+		return "SSE2";
+#elif defined(LUI_SURFACE_NEON)
+		return "NEON";
+#else
+		return "scalar";
+#endif
+	}
+
+	SDL_Texture* surfaceBackend::createTexture(Uint32 format, int access, int w, int h) {
+		std::lock_guard<std::recursive_mutex> lock(m_mutex);
+		if (getRenderer() == nullptr) {
+			return nullptr;
+		}
+		SDL_Surface *copy = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_ARGB8888);
+		if (copy == nullptr) {
+			return nullptr;
+		}
+		SDL_Texture *texture = SDL_CreateTexture(getRenderer(), format, access, w, h);
+		if (texture == nullptr) {
+			SDL_FreeSurface(copy);
+			return nullptr;
+		}
+		std::memset(copy->pixels, 0, (size_t)copy->pitch * h);
+		m_copies[texture] = copy;
+		return texture;
+	}
+	SDL_Texture* surfaceBackend::createTextureFromSurface(SDL_Surface *surface) {
+		std::lock_guard<std::recursive_mutex> lock(m_mutex);
+		if (getRenderer() == nullptr || surface == nullptr) {
+			return nullptr;
+		}
+		SDL_Surface *copy = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+		if (copy == nullptr) {
+			return nullptr;
+		}
+		SDL_Texture *texture = SDL_CreateTextureFromSurface(getRenderer(), surface); //Picks the blend mode from the surface
+		if (texture == nullptr) {
+			SDL_FreeSurface(copy);
+			return nullptr;
+		}
+		m_copies[texture] = copy;
+		return texture;
+	}
+	int surfaceBackend::updateTexture(SDL_Texture *texture, const SDL_Rect *rect, const void *pixels, int pitch) {
+		std::lock_guard<std::recursive_mutex> lock(m_mutex);
+		SDL_Surface *copy = m_copyOf(texture);
+		Uint32 format = 0;
+		if (copy == nullptr || SDL_QueryTexture(texture, &format, nullptr, nullptr, nullptr) != 0) {
+			return -1;
+		}
+		SDL_Rect area = rect != nullptr ? Intersect(*rect, SDL_Rect{ 0, 0, copy->w, copy->h }) : SDL_Rect{ 0, 0, copy->w, copy->h };
+		if (area.w == 0 || area.h == 0) {
+			return 0;
+		}
+		return SDL_ConvertPixels(area.w, area.h, format, pixels, pitch, SDL_PIXELFORMAT_ARGB8888, PixelRow(copy, area.y) + area.x, copy->pitch);
+	}
+	int surfaceBackend::setTarget(SDL_Texture *texture) {
+		std::lock_guard<std::recursive_mutex> lock(m_mutex);
+		SDL_Surface *target = m_surface;
+		if (texture != nullptr && (target = m_copyOf(texture)) == nullptr) {
+			return -1;
+		}
+		//Like SDL, textures are drawn into unclipped, and the default target keeps its clip
+		if (m_targetTexture == nullptr && texture != nullptr) {
+			m_defaultClip = m_clip;
+			m_defaultClipEnabled = m_clipEnabled;
+			m_clipEnabled = false;
+		}
+		else if (m_targetTexture != nullptr && texture == nullptr) {
+			m_clip = m_defaultClip;
+			m_clipEnabled = m_defaultClipEnabled;
+		}
+		else {
+			m_clipEnabled = false;
+		}
+		m_target = target;
+		m_targetTexture = texture;
+		return 0;
+	}
+	SDL_Texture* surfaceBackend::getTarget() {
+		std::lock_guard<std::recursive_mutex> lock(m_mutex);
+		return m_targetTexture;
+	}
+	int surfaceBackend::getOutputSize(int *w, int *h) {
+		std::lock_guard<std::recursive_mutex> lock(m_mutex);
+		if (m_target == nullptr) {
+			return SDL_SetError("surfaceBackend has no surface");
+		}
+		if (w != nullptr) *w = m_target->w;
+		if (h != nullptr) *h = m_target->h;
+		return 0;
+	}
+	int surfaceBackend::setClipRect(const SDL_Rect *rect) {
+		m_clipEnabled = rect != nullptr;
+		if (rect != nullptr) {
+			m_clip = *rect;
+		}
+		return 0;
+	}
+	bool surfaceBackend::getClipRect(SDL_Rect *rect) {
+		if (rect != nullptr) {
+			*rect = m_clipEnabled ? m_clip : SDL_Rect{ 0, 0, 0, 0 };
+		}
+		return m_clipEnabled;
+	}
+	int surfaceBackend::setDrawColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
+		m_drawColor = SDL_Color{ r, g, b, a };
+		return 0;
+	}
+	int surfaceBackend::getDrawColor(Uint8 *r, Uint8 *g, Uint8 *b, Uint8 *a) {
+		if (r != nullptr) *r = m_drawColor.r;
+		if (g != nullptr) *g = m_drawColor.g;
+		if (b != nullptr) *b = m_drawColor.b;
+		if (a != nullptr) *a = m_drawColor.a;
+		return 0;
+	}
+	int surfaceBackend::setDrawBlendMode(SDL_BlendMode mode) {
+		m_drawBlendMode = mode;
+		return 0;
+	}
+	int surfaceBackend::getDrawBlendMode(SDL_BlendMode *mode) {
+		if (mode != nullptr) {
+			*mode = m_drawBlendMode;
+		}
+		return 0;
+	}
+	int surfaceBackend::clear() {
+		std::lock_guard<std::recursive_mutex> lock(m_mutex);
+		if (!Drawable(m_target)) {
+			return -1;
+		}
+		Uint32 color = m_drawPixel();
+		for (int y = 0; y < m_target->h; y++) {
+			FillSpan(PixelRow(m_target, y), m_target->w, color, SDL_BLENDMODE_NONE);
+		}
+		return 0;
+	}
+	int surfaceBackend::fillRect(const SDL_FRect *rect) {
+		std::lock_guard<std::recursive_mutex> lock(m_mutex);
+		if (!Drawable(m_target)) {
+			return -1;
+		}
+		if (rect == nullptr) {
+			m_fillPixels(SDL_Rect{ 0, 0, m_target->w, m_target->h }, m_drawPixel(), m_drawBlendMode);
+			return 0;
+		}
+		//Pixels whose centers are inside of the rectangle
+		int x0 = (int)std::ceil(rect->x - 0.5f), y0 = (int)std::ceil(rect->y - 0.5f);
+		int x1 = (int)std::ceil(rect->x + rect->w - 0.5f), y1 = (int)std::ceil(rect->y + rect->h - 0.5f);
+		m_fillPixels(SDL_Rect{ x0, y0, x1 - x0, y1 - y0 }, m_drawPixel(), m_drawBlendMode);
+		return 0;
+	}
+	int surfaceBackend::drawRect(const SDL_FRect *rect) {
+		std::lock_guard<std::recursive_mutex> lock(m_mutex);
+		if (!Drawable(m_target)) {
+			return -1;
+		}
+		SDL_FRect r = rect != nullptr ? *rect : SDL_FRect{ 0.f, 0.f, (float)m_target->w, (float)m_target->h };
+		int x0 = (int)std::floor(r.x), y0 = (int)std::floor(r.y), x1 = (int)std::floor(r.x + r.w) - 1, y1 = (int)std::floor(r.y + r.h) - 1;
+		if (x1 < x0 || y1 < y0) {
+			return 0;
+		}
+		Uint32 color = m_drawPixel();
+		m_fillPixels(SDL_Rect{ x0, y0, x1 - x0 + 1, 1 }, color, m_drawBlendMode);
+		if (y1 > y0) {
+			m_fillPixels(SDL_Rect{ x0, y1, x1 - x0 + 1, 1 }, color, m_drawBlendMode);
+		}
+		if (y1 - y0 > 1) { //Sides without the corners, so no pixel is blended twice
+			m_fillPixels(SDL_Rect{ x0, y0 + 1, 1, y1 - y0 - 1 }, color, m_drawBlendMode);
+			if (x1 > x0) {
+				m_fillPixels(SDL_Rect{ x1, y0 + 1, 1, y1 - y0 - 1 }, color, m_drawBlendMode);
+			}
+		}
+		return 0;
+	}
+	int surfaceBackend::drawLines(const SDL_FPoint *points, int count) {
+		std::lock_guard<std::recursive_mutex> lock(m_mutex);
+		if (!Drawable(m_target)) {
+			return -1;
+		}
+		Uint32 color = m_drawPixel();
+		SDL_Rect area = m_drawable();
+		auto plot = [&](int x, int y) {
+			if (x >= area.x && y >= area.y && x < area.x + area.w && y < area.y + area.h) {
+				FillSpan(PixelRow(m_target, y) + x, 1, color, m_drawBlendMode);
+			}
+		};
+		if (count == 1) {
+			plot((int)std::floor(points[0].x), (int)std::floor(points[0].y));
+		}
+		for (int i = 1; i < count; i++) {
+			//Bresenham; each line after the first starts past the point it shares with the one before
+			int x = (int)std::floor(points[i - 1].x), y = (int)std::floor(points[i - 1].y);
+			int x1 = (int)std::floor(points[i].x), y1 = (int)std::floor(points[i].y);
+			int dx = std::abs(x1 - x), dy = -std::abs(y1 - y), sx = x < x1 ? 1 : -1, sy = y < y1 ? 1 : -1, error = dx + dy;
+			bool first = i == 1;
+			while (true) {
+				if (first) {
+					plot(x, y);
+				}
+				first = true;
+				if (x == x1 && y == y1) {
+					break;
+				}
+				int twice = 2 * error;
+				if (twice >= dy) {
+					error += dy;
+					x += sx;
+				}
+				if (twice <= dx) {
+					error += dx;
+					y += sy;
+				}
+			}
+		}
+		return 0;
+	}
+	int surfaceBackend::copy(SDL_Texture *texture, const SDL_Rect *srcrect, const SDL_FRect *dstrect, double angle, const SDL_FPoint *center, SDL_RendererFlip flip) {
+		std::lock_guard<std::recursive_mutex> lock(m_mutex);
+		SDL_Surface *source = m_copyOf(texture);
+		if (source == nullptr || !Drawable(m_target)) {
+			return -1;
+		}
+		SDL_Rect src = srcrect != nullptr ? Intersect(*srcrect, SDL_Rect{ 0, 0, source->w, source->h }) : SDL_Rect{ 0, 0, source->w, source->h };
+		SDL_FRect dst = dstrect != nullptr ? *dstrect : SDL_FRect{ 0.f, 0.f, (float)m_target->w, (float)m_target->h };
+		if (src.w <= 0 || src.h <= 0 || dst.w <= 0.f || dst.h <= 0.f) {
+			return 0;
+		}
+		Uint8 r = 255, g = 255, b = 255, a = 255;
+		SDL_BlendMode mode = SDL_BLENDMODE_NONE;
+		SDL_GetTextureColorMod(texture, &r, &g, &b);
+		SDL_GetTextureAlphaMod(texture, &a);
+		SDL_GetTextureBlendMode(texture, &mode);
+		Uint32 mod = ((Uint32)a << 24) | ((Uint32)r << 16) | ((Uint32)g << 8) | b;
+
+		//Window pixels the turned rectangle may cover
+		rotation turn(angle);
+		SDL_FPoint pivot = center != nullptr ? SDL_FPoint{ dst.x + center->x, dst.y + center->y } : SDL_FPoint{ dst.x + dst.w / 2.f, dst.y + dst.h / 2.f };
+		SDL_FPoint corners[4] = { { dst.x, dst.y }, { dst.x + dst.w, dst.y }, { dst.x + dst.w, dst.y + dst.h }, { dst.x, dst.y + dst.h } };
+		RotatePoints(turn, corners, 4, corners, pivot);
+		float minX = corners[0].x, minY = corners[0].y, maxX = corners[0].x, maxY = corners[0].y;
+		for (SDL_FPoint &c : corners) {
+			minX = std::min(minX, c.x);
+			minY = std::min(minY, c.y);
+			maxX = std::max(maxX, c.x);
+			maxY = std::max(maxY, c.y);
+		}
+		SDL_Rect bounds{ (int)std::floor(minX), (int)std::floor(minY), 0, 0 };
+		bounds.w = (int)std::ceil(maxX) - bounds.x;
+		bounds.h = (int)std::ceil(maxY) - bounds.y;
+		bounds = Intersect(bounds, m_drawable());
+		if (bounds.w == 0 || bounds.h == 0) {
+			return 0;
+		}
+
+		//Source position of a window pixel center is linear in the pixel, so each row steps by the same amount
+		float scaleX = src.w / dst.w, scaleY = src.h / dst.h;
+		float flipX = (flip & SDL_FLIP_HORIZONTAL) ? -1.f : 1.f, flipY = (flip & SDL_FLIP_VERTICAL) ? -1.f : 1.f;
+		float du = turn.cosine * scaleX * flipX, dv = -turn.sine * scaleY * flipY; //Per pixel right
+		const Uint32 *pixels = PixelRow(source, src.y) + src.x;
+		int stride = source->pitch / 4;
+		if ((int)m_row.size() < bounds.w) {
+			m_row.resize(bounds.w);
+		}
+		for (int y = bounds.y; y < bounds.y + bounds.h; y++) {
+			SDL_FPoint local = turn.applyInverse({ bounds.x + 0.5f, y + 0.5f }, pivot);
+			float u = (local.x - dst.x) * scaleX, v = (local.y - dst.y) * scaleY;
+			if (flipX < 0.f) {
+				u = src.w - u;
+			}
+			if (flipY < 0.f) {
+				v = src.h - v;
+			}
+			int start = 0, end = bounds.w;
+			InsideSpan(u, du, (float)src.w, start, end);
+			InsideSpan(v, dv, (float)src.h, start, end);
+			if (start >= end) {
+				continue;
+			}
+			Uint32 *out = PixelRow(m_target, y) + bounds.x + start;
+			float firstU = u + (float)start * du, firstV = v + (float)start * dv;
+			if (du == 1.f && dv == 0.f) { //Unscaled and upright, so straight from the source row
+				BlendSpan(out, pixels + (int)firstV * stride + (int)firstU, end - start, mod, mode);
+			}
+			else {
+				GatherSpan(m_row.data(), pixels, stride, firstU, firstV, du, dv, src.w, src.h, end - start);
+				BlendSpan(out, m_row.data(), end - start, mod, mode);
+			}
+		}
+		return 0;
+	}
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	int surfaceBackend::geometry(SDL_Texture *texture, const SDL_Vertex *vertices, int numVertices, const int *indices, int numIndices) {
+		std::lock_guard<std::recursive_mutex> lock(m_mutex);
+		SDL_Surface *source = nullptr;
+		SDL_BlendMode mode = m_drawBlendMode;
+		if (texture != nullptr) {
+			if ((source = m_copyOf(texture)) == nullptr) {
+				return -1;
+			}
+			SDL_GetTextureBlendMode(texture, &mode);
+		}
+		if (!Drawable(m_target) || vertices == nullptr) {
+			return -1;
+		}
+		int count = indices != nullptr ? numIndices : numVertices;
+		for (int i = 0; i + 2 < count; i += 3) {
+			int i0 = indices != nullptr ? indices[i] : i, i1 = indices != nullptr ? indices[i + 1] : i + 1, i2 = indices != nullptr ? indices[i + 2] : i + 2;
+			if (i0 < 0 || i1 < 0 || i2 < 0 || i0 >= numVertices || i1 >= numVertices || i2 >= numVertices) {
+				SDL_SetError("Vertex index out of range");
+				return -1;
+			}
+			m_triangle(source, mode, vertices[i0], vertices[i1], vertices[i2]);
+		}
+		return 0;
+	}
+	void surfaceBackend::m_triangle(SDL_Surface *source, SDL_BlendMode mode, const SDL_Vertex &a, const SDL_Vertex &b0, const SDL_Vertex &c0) {
+		auto edge = [](const SDL_FPoint &p, const SDL_FPoint &q, float x, float y) {
+			return (q.x - p.x) * (y - p.y) - (q.y - p.y) * (x - p.x);
+		};
+		float area = edge(a.position, b0.position, c0.position.x, c0.position.y);
+		if (area == 0.f) {
+			return;
+		}
+		const SDL_Vertex &b = area > 0.f ? b0 : c0, &c = area > 0.f ? c0 : b0; //Wound the same way every time
+		area = std::abs(area);
+		//Pixels exactly on an edge belong to the triangle on its top or left, so shared edges aren't drawn twice
+		auto topLeft = [](const SDL_FPoint &p, const SDL_FPoint &q) {
+			return q.y < p.y || (q.y == p.y && q.x > p.x);
+		};
+		bool topLeftA = topLeft(b.position, c.position), topLeftB = topLeft(c.position, a.position), topLeftC = topLeft(a.position, b.position);
+
+		float minX = std::min(std::min(a.position.x, b.position.x), c.position.x), maxX = std::max(std::max(a.position.x, b.position.x), c.position.x);
+		float minY = std::min(std::min(a.position.y, b.position.y), c.position.y), maxY = std::max(std::max(a.position.y, b.position.y), c.position.y);
+		SDL_Rect bounds{ (int)std::floor(minX), (int)std::floor(minY), 0, 0 };
+		bounds.w = (int)std::ceil(maxX) - bounds.x + 1;
+		bounds.h = (int)std::ceil(maxY) - bounds.y + 1;
+		bounds = Intersect(bounds, m_drawable());
+		if ((int)m_row.size() < bounds.w) {
+			m_row.resize(bounds.w);
+		}
+		const Uint32 *pixels = source != nullptr ? (const Uint32*)source->pixels : nullptr;
+		int stride = source != nullptr ? source->pitch / 4 : 0;
+		for (int y = bounds.y; y < bounds.y + bounds.h; y++) {
+			int runStart = -1;
+			Uint32 *out = PixelRow(m_target, y) + bounds.x;
+			for (int x = 0; x <= bounds.w; x++) {
+				bool inside = false;
+				if (x < bounds.w) {
+					float px = bounds.x + x + 0.5f, py = y + 0.5f;
+					float wa = edge(b.position, c.position, px, py), wb = edge(c.position, a.position, px, py), wc = edge(a.position, b.position, px, py);
+					inside = (wa > 0.f || (wa == 0.f && topLeftA)) && (wb > 0.f || (wb == 0.f && topLeftB)) && (wc > 0.f || (wc == 0.f && topLeftC));
+					if (inside) {
+						wa /= area;
+						wb /= area;
+						wc = 1.f - wa - wb;
+						auto channel = [&](Uint8 ca, Uint8 cb, Uint8 cc) {
+							return (Uint32)std::min(std::max(wa * ca + wb * cb + wc * cc + 0.5f, 0.f), 255.f);
+						};
+						Uint32 color = (channel(a.color.a, b.color.a, c.color.a) << 24) | (channel(a.color.r, b.color.r, c.color.r) << 16) | (channel(a.color.g, b.color.g, c.color.g) << 8) | channel(a.color.b, b.color.b, c.color.b);
+						if (pixels != nullptr) {
+							float u = (wa * a.tex_coord.x + wb * b.tex_coord.x + wc * c.tex_coord.x) * source->w;
+							float v = (wa * a.tex_coord.y + wb * b.tex_coord.y + wc * c.tex_coord.y) * source->h;
+							int tx = std::min(std::max((int)u, 0), source->w - 1), ty = std::min(std::max((int)v, 0), source->h - 1);
+							color = BlendPixel(0, pixels[ty * stride + tx], color, SDL_BLENDMODE_NONE); //Texel times vertex color
+						}
+						m_row[x] = color;
+						if (runStart < 0) {
+							runStart = x;
+						}
+					}
+				}
+				if (!inside && runStart >= 0) { //Blend each run of covered pixels at once
+					BlendSpan(out + runStart, m_row.data() + runStart, x - runStart, opaqueWhite, mode);
+					runStart = -1;
+				}
+			}
+		}
+	}
+#endif
+
+}
@@ -0,0 +1,263 @@
+#include "./textCache.hpp"
+#include "./renderBackend.hpp"
+
+extern "C" {
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+}
+#include <functional>
+#include <iterator> //std::next and std::prev
+
+namespace lui {
+
+	size_t textCache::entryKeyHash::operator()(const entryKey &k) const {
+		size_t h = k.hash;
+		//Combine the remaining fields into the string's hash
+		h ^= std::hash<void*>()(k.renderer) + 0x9e3779b9 + (h << 6) + (h >> 2);
+		h ^= std::hash<void*>()(k.font) + 0x9e3779b9 + (h << 6) + (h >> 2);
+		h ^= std::hash<int>()(k.size ^ (k.style << 16)) + 0x9e3779b9 + (h << 6) + (h >> 2);
+		h ^= std::hash<Uint32>()(k.color) + 0x9e3779b9 + (h << 6) + (h >> 2);
+		return h;
+	}
+
+	textCache::textCache() {}
+	textCache::~textCache() {
+		clear();
+	}
+
+	textCache& textCache::global() {
+		//Never destroyed; the renderers its textures belong to may already be gone at exit
+		static textCache *cache = new textCache();
+		return *cache;
+	}
+	size_t textCache::hashString(const std::string &text) {
+		return std::hash<std::string>()(text);
+	}
+
+	int textCache::size(TTF_Font *font, const std::string &text, int *w, int *h) {
+		return size(font, text, hashString(text), w, h);
+	}
+	int textCache::size(TTF_Font *font, const std::string &text, size_t hash, int *w, int *h) {
+		if (font == nullptr) {
+			return -1;
+		}
+		std::lock_guard<std::mutex> lock(m_mutex);
+		entryKey k = m_makeKey(nullptr, font, hash, 0);
+		entry *found = m_find(k, text);
+		int tw = 0, th = 0;
+		if (found == nullptr) {
+			if (TTF_SizeUTF8(font, text.data(), &tw, &th) != 0) {
+				return -1;
+			}
+			found = m_insert(k, text);
+			found->w = tw;
+			found->h = th;
+			m_trim(nullptr); //May evict the new entry when the budget is tiny, so only tw and th are used below
+		}
+		else {
+			tw = found->w;
+			th = found->h;
+		}
+		if (w != nullptr) {
+			*w = tw;
+		}
+		if (h != nullptr) {
+			*h = th;
+		}
+		return 0;
+	}
+	SDL_Texture* textCache::getTexture(SDL_Renderer *renderer, TTF_Font *font, const std::string &text, SDL_Color color, int *w, int *h) {
+		return getTexture(renderer, font, text, hashString(text), color, w, h);
+	}
+	SDL_Texture* textCache::getTexture(SDL_Renderer *renderer, TTF_Font *font, const std::string &text, size_t hash, SDL_Color color, int *w, int *h) {
+		if (renderer == nullptr || font == nullptr || text.empty()) {
+			return nullptr;
+		}
+		std::lock_guard<std::mutex> lock(m_mutex);
+		Uint32 packedColor = ((Uint32)color.r << 24) | ((Uint32)color.g << 16) | ((Uint32)color.b << 8) | color.a;
+		entryKey k = m_makeKey(renderer, font, hash, packedColor);
+		entry *found = nullptr;
+		auto oversized = m_oversized.find(renderer);
+		if (oversized != m_oversized.end() && oversized->second.key == k && oversized->second.text == text) { //Drawn again, such as every frame
+			found = &oversized->second;
+			m_hits++;
+		}
+		else {
+			found = m_find(k, text);
+		}
+		if (found == nullptr) {
+			SDL_Surface *surface = TTF_RenderUTF8_Blended(font, text.data(), color);
+			if (surface == nullptr) {
+				return nullptr;
+			}
+			SDL_Texture *texture = renderBackend::get(renderer)->createTextureFromSurface(surface);
+			int tw = surface->w, th = surface->h;
+			SDL_FreeSurface(surface);
+			if (texture == nullptr) {
+				return nullptr;
+			}
+			size_t bytes = sizeof(entry) + text.size() + (size_t)tw * th * 4;
+			if (bytes <= m_byteBudget) { //Make room before adding, so the new entry is never the one evicted
+				m_trim(renderer, false, bytes);
+			}
+			if (m_bytesUsed + bytes > m_byteBudget) { //Larger than the budget, or what other renderers leave of it
+				if (oversized != m_oversized.end()) {
+					m_eraseOversized(oversized);
+				}
+				found = &m_oversized[renderer];
+				found->key = k;
+				found->text = text;
+			}
+			else {
+				found = m_insert(k, text);
+				found->bytes += (size_t)tw * th * 4;
+				m_bytesUsed += (size_t)tw * th * 4;
+			}
+			found->w = tw;
+			found->h = th;
+			found->texture = texture;
+		}
+		if (w != nullptr) {
+			*w = found->w;
+		}
+		if (h != nullptr) {
+			*h = found->h;
+		}
+		return found->texture;
+	}
+
+	void textCache::setByteBudget(size_t bytes) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_byteBudget = bytes;
+		m_trim(nullptr, true);
+	}
+	size_t textCache::getByteBudget() {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_byteBudget;
+	}
+	size_t textCache::getBytesUsed() {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_bytesUsed;
+	}
+	Uint64 textCache::getHits() {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_hits;
+	}
+	Uint64 textCache::getMisses() {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_misses;
+	}
+	void textCache::resetCounters() {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_hits = 0;
+		m_misses = 0;
+	}
+	std::mutex& textCache::getFontMutex() {
+		return m_mutex;
+	}
+
+	void textCache::clear() {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		while (!m_entries.empty()) {
+			m_erase(m_entries.begin());
+		}
+		while (!m_oversized.empty()) {
+			m_eraseOversized(m_oversized.begin());
+		}
+	}
+	void textCache::clearRenderer(SDL_Renderer *renderer) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (auto it = m_entries.begin(); it != m_entries.end();) {
+			auto next = std::next(it);
+			if (it->key.renderer == renderer) {
+				m_erase(it);
+			}
+			it = next;
+		}
+		auto oversized = m_oversized.find(renderer);
+		if (oversized != m_oversized.end()) {
+			m_eraseOversized(oversized);
+		}
+	}
+	void textCache::clearFont(TTF_Font *font) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (auto it = m_entries.begin(); it != m_entries.end();) {
+			auto next = std::next(it);
+			if (it->key.font == font) {
+				m_erase(it);
+			}
+			it = next;
+		}
+		for (auto it = m_oversized.begin(); it != m_oversized.end();) {
+			auto next = std::next(it);
+			if (it->second.key.font == font) {
+				m_eraseOversized(it);
+			}
+			it = next;
+		}
+	}
+
+
+
+	textCache::entryKey textCache::m_makeKey(SDL_Renderer *renderer, TTF_Font *font, size_t hash, Uint32 color) {
+		entryKey k;
+		k.renderer = renderer;
+		k.font = font;
+		k.size = TTF_FontHeight(font);
+		k.style = TTF_GetFontStyle(font);
+		k.color = color;
+		k.hash = hash;
+		return k;
+	}
+	textCache::entry* textCache::m_find(const entryKey &k, const std::string &text) {
+		auto found = m_index.find(k);
+		if (found == m_index.end()) {
+			m_misses++;
+			return nullptr;
+		}
+		if (found->second->text != text) { //Hash collision, the old entry is replaced
+			m_erase(found->second);
+			m_misses++;
+			return nullptr;
+		}
+		m_entries.splice(m_entries.begin(), m_entries, found->second); //Most recently used
+		m_hits++;
+		return &m_entries.front();
+	}
+	textCache::entry* textCache::m_insert(const entryKey &k, const std::string &text) {
+		m_entries.emplace_front();
+		entry &e = m_entries.front();
+		e.key = k;
+		e.text = text;
+		e.bytes = sizeof(entry) + text.size();
+		m_bytesUsed += e.bytes;
+		m_index[k] = m_entries.begin();
+		return &e;
+	}
+	void textCache::m_erase(std::list<entry>::iterator it) {
+		if (it->texture != nullptr) {
+			renderBackend::destroyTexture(it->texture);
+		}
+		m_bytesUsed -= it->bytes;
+		m_index.erase(it->key);
+		m_entries.erase(it);
+	}
+	void textCache::m_eraseOversized(std::unordered_map<SDL_Renderer*, entry>::iterator it) {
+		renderBackend::destroyTexture(it->second.texture);
+		m_oversized.erase(it);
+	}
+	void textCache::m_trim(SDL_Renderer *renderer, bool anyRenderer, size_t reserve) {
+		auto it = m_entries.end();
+		while (m_bytesUsed + reserve > m_byteBudget && it != m_entries.begin()) {
+			auto oldest = std::prev(it);
+			//Textures of other renderers may be in use on other threads
+			if (anyRenderer || oldest->key.renderer == nullptr || oldest->key.renderer == renderer) {
+				m_erase(oldest);
+			}
+			else {
+				it = oldest;
+			}
+		}
+	}
+
+}
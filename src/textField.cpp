@@ -1,6 +1,9 @@
 #include "./textField.hpp"
 #include <cstring>
+#include <algorithm>
+#include <mutex>
 #include "./extra.hpp"
+#include "./textCache.hpp"
 
 namespace lui {
 
@@ -16,23 +19,42 @@ namespace lui {
 		setFlip(flip);
 	}
 	textField::~textField() {
-		SDL_FreeSurface(m_surfaceCommitedLeft);
-		SDL_FreeSurface(m_surfaceComposition);
-		SDL_FreeSurface(m_surfaceCommitedRight);
-		SDL_DestroyTexture(m_texture);
-		SDL_DestroyTexture(m_textureCommitedLeft);
-		SDL_DestroyTexture(m_textureComposition);
-		SDL_DestroyTexture(m_textureCommitedRight);
+		SDL_FreeSurface(m_surface);
+		renderBackend::destroyTexture(m_texture);
 	}
 
 	void textField::render(SDL_Renderer *renderer) {
-		if (m_updateTextureNextRender) {
+		if (m_updateTextureNextRender && !isPasting()) { //Measuring a half-pasted string every frame is wasted work
 			m_updateTexture(renderer);
 		}
-		SDL_RenderCopyExF(renderer, m_texture, NULL, &m_dstrect, m_angle, &zeroFPoint, m_flip);
+		SDL_FRect dstrect = m_renderDstrect();
+		m_applyMod(m_texture);
+		renderBackend::get(renderer)->copy(m_texture, NULL, &dstrect, m_angle, &zeroFPoint, m_flip);
+		m_clearMod(m_texture);
+	}
+	void textField::releaseTextures() {
+		renderBackend::destroyTexture(m_texture);
+		m_texture = nullptr;
+		m_updateTextureNextRender = true;
 	}
 	void textField::userLogic(std::vector<SDL_Event> &events, SDL_Renderer *renderer) {
 		element::userLogic(events, renderer);
+		if (isPasting()) {
+			//Anything that moves the cursor or edits the text needs the paste to be finished first
+			bool finish = false;
+			for (SDL_Event &e : events) {
+				if (e.type == SDL_MOUSEBUTTONDOWN || e.type == SDL_TEXTINPUT || e.type == SDL_TEXTEDITING || e.type == SDL_KEYDOWN) {
+					finish = true;
+					break;
+				}
+			}
+			if (finish) {
+				m_finishPaste();
+			}
+			else {
+				m_pasteStep(m_pasteChunkSize);
+			}
+		}
 		for (SDL_Event &e : events) {
 			if (m_hasFocus) {
 				switch (e.type) {
@@ -41,7 +63,7 @@ namespace lui {
 						m_selecting = true;
 						//Translate point to be relative to the element:
 						SDL_FPoint originalPoint{ e.button.x - m_dstrect.x, e.button.y - m_dstrect.y };
-						SDL_FPoint localPoint = RotatePoint(originalPoint, -m_angle);
+						SDL_FPoint localPoint = m_rotation.applyInverse(originalPoint);
 						m_selectingFromIndex = indexFromPosition(localPoint.x);
 						m_selectionIndexBegin = 0;
 						m_selectionIndexEnd = 0;
@@ -54,7 +76,7 @@ namespace lui {
 					if (m_selecting) {
 						//Translate point to be relative to the element:
 						SDL_FPoint originalPoint{ e.button.x - m_dstrect.x, e.button.y - m_dstrect.y };
-						SDL_FPoint localPoint = RotatePoint(originalPoint, -m_angle);
+						SDL_FPoint localPoint = m_rotation.applyInverse(originalPoint);
 						m_cursorIndex = indexFromPosition(localPoint.x);
 						if (m_selectingFromIndex < m_cursorIndex) {
 							m_selectionIndexBegin = m_selectingFromIndex;
@@ -90,28 +112,34 @@ namespace lui {
 			if (m_typing) {
 				switch (e.type) {
 				case SDL_TEXTINPUT: //User has added text to the commited string, insert it at the cursor position
+				{
 					if (e.text.text[0] == 1) {
 						break;
 					}
 					//std::cout << "User commited some text!" << std::endl << e.text.text << std::endl;
 					if (m_selectionIndexBegin != m_selectionIndexEnd) {
-						m_commitedString.erase(m_selectionIndexBegin, m_selectionIndexEnd - m_selectionIndexBegin);
+						m_eraseCommited(m_selectionIndexBegin, m_selectionIndexEnd - m_selectionIndexBegin);
 						m_cursorIndex = m_selectionIndexBegin;
 						m_selectionIndexBegin = 0;
 						m_selectionIndexEnd = 0;
 					}
-					m_commitedString.insert(m_cursorIndex, e.text.text);
-					m_cursorIndex += std::strlen(e.text.text);
+					std::string text = e.text.text;
+					if (text.size() > m_remainingLength()) { //Cut off at a code point
+						text.resize(UTF8Advance(text, m_remainingLength(), 0));
+					}
+					m_insertCommited(m_cursorIndex, text);
+					m_cursorIndex += text.size();
 					m_compositionIndex = 0;
 					m_updateTextureNextRender = true;
 					m_cursorTimer = 0;
 
 					m_callEventFunction(ValueChanged);
-					break;
+				}
+				break;
 				case SDL_TEXTEDITING:
 					if (m_compositionString == "") { //Just started editing
 						if (m_selectionIndexBegin != m_selectionIndexEnd) {
-							m_commitedString.erase(m_selectionIndexBegin, m_selectionIndexEnd - m_selectionIndexBegin);
+							m_eraseCommited(m_selectionIndexBegin, m_selectionIndexEnd - m_selectionIndexBegin);
 							m_cursorIndex = m_selectionIndexBegin;
 							m_selectionIndexBegin = 0;
 							m_selectionIndexEnd = 0;
@@ -119,23 +147,23 @@ namespace lui {
 						m_compositionIndex = m_cursorIndex;
 					}
 					m_compositionString = std::string(e.edit.text);
-					m_compositionCursorIndex = getUTF8GraphemeIndex(m_compositionString, e.edit.start, 0);
+					m_compositionCursorIndex = UTF8Advance(m_compositionString, 0, e.edit.start); //SDL gives the cursor in code points
 					m_updateTextureNextRender = true;
 					m_cursorTimer = 0;
 					break;
 				case SDL_KEYDOWN: //Backspace and delete
 					if (m_compositionString == "") { //Not editing composition
 						switch (e.key.keysym.sym) {
-						case SDLK_BACKSPACE: //Delete UTF8 char to the left of cursor
+						case SDLK_BACKSPACE: //Delete grapheme cluster to the left of cursor
 							if (m_cursorIndex > 0) {
 								if (m_selectionIndexBegin == m_selectionIndexEnd) {
-									size_t deleteIndex = getUTF8GraphemeIndex(m_commitedString, -1, m_cursorIndex);
-									m_commitedString.erase(deleteIndex, m_cursorIndex - deleteIndex); //TODO: Length should not be one, but instead be the byte difference from current to next grapheme
-									m_cursorIndex -= m_cursorIndex - deleteIndex;
+									size_t deleteIndex = m_commitedGraphemes.previous(m_cursorIndex);
+									m_eraseCommited(deleteIndex, m_cursorIndex - deleteIndex);
+									m_cursorIndex = deleteIndex;
 								}
 								else {
 									//Delete selected text
-									m_commitedString.erase(m_selectionIndexBegin, m_selectionIndexEnd - m_selectionIndexBegin);
+									m_eraseCommited(m_selectionIndexBegin, m_selectionIndexEnd - m_selectionIndexBegin);
 									m_selectionIndexBegin = 0;
 									m_selectionIndexEnd = 0;
 								}
@@ -143,15 +171,15 @@ namespace lui {
 								m_cursorTimer = 0;
 							}
 							break;
-						case SDLK_DELETE: //Delete UTF8 char to the right of cusror
+						case SDLK_DELETE: //Delete grapheme cluster to the right of cusror
 							if (m_cursorIndex < m_commitedString.size()) {
 								if (m_selectionIndexBegin == m_selectionIndexEnd) {
-									size_t deleteIndex = getUTF8GraphemeIndex(m_commitedString, 1, m_cursorIndex);
-									m_commitedString.erase(m_cursorIndex, deleteIndex - m_cursorIndex); //TODO: Length should not be one, but instead be the byte difference from current to next grapheme
+									size_t deleteIndex = m_commitedGraphemes.next(m_cursorIndex);
+									m_eraseCommited(m_cursorIndex, deleteIndex - m_cursorIndex);
 								}
 								else {
 									//Delete selected text
-									m_commitedString.erase(m_selectionIndexBegin, m_selectionIndexEnd - m_selectionIndexBegin);
+									m_eraseCommited(m_selectionIndexBegin, m_selectionIndexEnd - m_selectionIndexBegin);
 									m_selectionIndexBegin = 0;
 									m_selectionIndexEnd = 0;
 								}
@@ -159,11 +187,11 @@ namespace lui {
 								m_cursorTimer = 0;
 							}
 							break;
-						case SDLK_LEFT: //Move cursor one UTF8 char left
+						case SDLK_LEFT: //Move cursor one grapheme cluster left
 						{
 							//std::cout << "Cursor moved from byte " << m_cursorIndex << " to ";
-							size_t newCursorIndex = getUTF8GraphemeIndex(m_commitedString, -1, m_cursorIndex);
-							if (e.key.keysym.mod & KMOD_SHIFT != 0) { //If we are selecting text, move both pointers accordingly
+							size_t newCursorIndex = m_commitedGraphemes.previous(m_cursorIndex);
+							if ((e.key.keysym.mod & KMOD_SHIFT) != 0) { //If we are selecting text, move both pointers accordingly
 								//One index should be at cursor position, the other one should be where it was
 								if (m_selectionIndexBegin == m_selectionIndexEnd) { //If they were ontop of eachother, move the lower one to cursorIndex
 									m_selectionIndexBegin = newCursorIndex;
@@ -188,11 +216,11 @@ namespace lui {
 							//std::cout << m_cursorIndex << std::endl;
 						}
 						break;
-						case SDLK_RIGHT: //Move cursor one UTF8 char right
+						case SDLK_RIGHT: //Move cursor one grapheme cluster right
 						{
 							//std::cout << "Cursor moved from byte " << m_cursorIndex << " to ";
-							size_t newCursorIndex = getUTF8GraphemeIndex(m_commitedString, 1, m_cursorIndex);
-							if (e.key.keysym.mod & KMOD_SHIFT != 0) { //If we are selecting text, move both pointers accordingly
+							size_t newCursorIndex = m_commitedGraphemes.next(m_cursorIndex);
+							if ((e.key.keysym.mod & KMOD_SHIFT) != 0) { //If we are selecting text, move both pointers accordingly
 																	  //One index should be at cursor position, the other one should be where it was
 								if (m_selectionIndexBegin == m_selectionIndexEnd) { //If they were ontop of eachother, move the upper one to cursorIndex
 									m_selectionIndexBegin = m_cursorIndex;
@@ -220,7 +248,7 @@ namespace lui {
 						case SDLK_x: //Cut
 							if ((e.key.keysym.mod & KMOD_CTRL) != 0 && m_selectionIndexBegin < m_selectionIndexEnd) { //Ctrl+X = Cut
 								SDL_SetClipboardText(m_commitedString.substr(m_selectionIndexBegin, m_selectionIndexEnd - m_selectionIndexBegin).data()); //Copy
-								m_commitedString.erase(m_selectionIndexBegin, m_selectionIndexEnd - m_selectionIndexBegin); //Erase
+								m_eraseCommited(m_selectionIndexBegin, m_selectionIndexEnd - m_selectionIndexBegin); //Erase
 								m_cursorIndex = m_selectionIndexBegin;
 								m_selectionIndexBegin = 0;
 								m_selectionIndexEnd = 0;
@@ -235,14 +263,19 @@ namespace lui {
 						case SDLK_v: //Paste
 							if ((e.key.keysym.mod & KMOD_CTRL) != 0) {
 								if (m_selectionIndexBegin < m_selectionIndexEnd) {
-									m_commitedString.erase(m_selectionIndexBegin, m_selectionIndexEnd - m_selectionIndexBegin); //Erase
+									m_eraseCommited(m_selectionIndexBegin, m_selectionIndexEnd - m_selectionIndexBegin); //Erase
 									m_cursorIndex = m_selectionIndexBegin;
 									m_selectionIndexBegin = 0;
 									m_selectionIndexEnd = 0;
 								}
 								char* clipText = SDL_GetClipboardText();
-								m_commitedString.insert(m_cursorIndex, clipText);
-								m_cursorIndex += std::strlen(clipText);
+								if (clipText != nullptr) {
+									m_pasteBuffer = clipText;
+									m_pasteOffset = 0;
+									SDL_free(clipText);
+									m_commitedString.reserve(m_commitedString.size() + std::min(m_pasteBuffer.size(), m_remainingLength()));
+									m_pasteStep(m_pasteChunkSize); //Small pastes finish right away
+								}
 								m_updateTextureNextRender = true;
 							}
 							break;
@@ -252,25 +285,35 @@ namespace lui {
 				}
 			}
 		}
+		if (m_updateTextureNextRender) {
+			invalidate();
+		}
 	}
 	void textField::resetUserLogic() {
 		//Clear all text
+		std::string().swap(m_pasteBuffer);
+		m_pasteOffset = 0;
 		m_commitedString = "";
+		m_commitedGraphemes.rebuild(m_commitedString);
 		m_compositionString = "";
 		m_cursorIndex = 0;
+		m_viewIndex = 0;
+		m_viewShift = 0;
 		m_selectionRect.w = 0;
 		m_selectionRect.h = 0;
 		m_updateTextureNextRender = true;
+		invalidate();
 	}
 	void textField::loopLogic(Uint32 ms) {
 		Uint32 cursorTimerNew = (m_cursorTimer + ms) % 1500;
-		if (m_cursorTimer < 750 && cursorTimerNew >= 750) { //Cursor became invisible, update texture
-			m_updateTextureNextRender = true;
-		}
-		else if (m_cursorTimer >= 750 && cursorTimerNew < 750) { //Cursor became visible
+		bool blinked = (m_cursorTimer < 750) != (cursorTimerNew < 750);
+		m_cursorTimer = cursorTimerNew;
+		if (blinked && m_typing) { //The cursor is only drawn while typing
 			m_updateTextureNextRender = true;
+			if (isVisible()) { //Hidden fields are updated when next rendered
+				invalidate();
+			}
 		}
-		m_cursorTimer = cursorTimerNew;
 	}
 	void textField::resetLoopLogic() {
 
@@ -295,12 +338,16 @@ namespace lui {
 		m_g[c] = clr.g;
 		m_b[c] = clr.b;
 		m_a[c] = clr.a;
+		m_updateTextureNextRender = true;
+		invalidate();
 	}
 	void textField::setColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a, Component c) {
 		m_r[c] = r;
 		m_g[c] = g;
 		m_b[c] = b;
 		m_a[c] = a;
+		m_updateTextureNextRender = true;
+		invalidate();
 	}
 	SDL_Color textField::getColor(Component c) {
 		SDL_Color clr;
@@ -315,6 +362,8 @@ namespace lui {
 	}
 	void textField::setPromptString(std::string s) {
 		m_defaultString = s;
+		m_updateTextureNextRender = true;
+		invalidate();
 	}
 	std::string textField::getPromptString() {
 		return m_defaultString;
@@ -328,34 +377,57 @@ namespace lui {
 		return m_typing;
 	}
 	void textField::stopTyping() {
+		m_finishPaste();
 		SDL_StopTextInput();
 		m_typing = false;
 		m_selectionIndexBegin = 0;
 		m_selectionIndexEnd = 0;
 		if (m_compositionString != "") {
-			m_commitedString.insert(m_compositionIndex, m_compositionString);
+			m_insertCommited(m_compositionIndex, m_compositionString);
 			m_compositionString = "";
 		}
 	}
 	size_t textField::indexFromPosition(Sint32 x) {
-		//std::string totalString = m_commitedString.insert(m_compositionIndex, m_compositionString);
-		int length = 0;
-		for (size_t i = 0; i < m_commitedString.size(); i++) {
-			TTF_SizeUTF8(m_font, m_commitedString.substr(0, i + 1).data(), &length, nullptr);
-			if (length >= x) {
-				return i;
-			}
+		//Measured from where the field is scrolled to, landing only between grapheme clusters
+		size_t view = m_commitedGraphemes.floor(m_viewIndex);
+		int room = x - m_viewShift;
+		size_t reached = m_fillAfter(view, room);
+		if (reached == view) {
+			return view;
 		}
-		return m_commitedString.size();
+		if (reached == m_commitedString.size() && m_spanWidth(view, reached) < room) { //Past the end of the string
+			return reached;
+		}
+		return m_commitedGraphemes.previous(reached);
 	}
 	void textField::setCommitedString(std::string s) {
 		if (!m_typing) {
 			m_commitedString = s;
+			m_commitedGraphemes.rebuild(m_commitedString);
+			m_viewIndex = 0;
+			m_viewShift = 0;
+			m_updateTextureNextRender = true;
+			invalidate();
 		}
 	}
 	std::string textField::getCommitedString() {
 		return m_commitedString;
 	}
+	void textField::setMaxLength(size_t bytes) {
+		m_maxLength = bytes;
+	}
+	size_t textField::getMaxLength() {
+		return m_maxLength;
+	}
+	void textField::setPasteChunkSize(size_t bytes) {
+		m_pasteChunkSize = std::max(bytes, (size_t)4); //Room for any code point
+	}
+	size_t textField::getPasteChunkSize() {
+		return m_pasteChunkSize;
+	}
+	bool textField::isPasting() {
+		return m_pasteOffset < m_pasteBuffer.size();
+	}
 
 
 
@@ -363,141 +435,122 @@ namespace lui {
 		//std::cout << "Updating texture" << std::endl;
 
 		m_updateTextureNextRender = false;
+		int fieldW = (int)std::round(m_dstrect.w);
+		bool composing = m_compositionString != "";
+		bool prompt = !m_typing && m_commitedString == "";
 		//Underline and composition size
-		TTF_SizeUTF8(m_font, m_compositionString.data(), &m_compositionRect.w, &m_compositionRect.h);
+		m_sizeText(m_compositionString, &m_compositionRect.w, &m_compositionRect.h);
 		m_underlineRect.w = m_compositionRect.w;
 		m_underlineRect.y = m_compositionRect.h;
+		int compositionW = composing ? m_compositionRect.w : 0;
 
-		//Selection box position
-		std::string preSelectionString = m_commitedString.substr(0, m_selectionIndexBegin);
-		TTF_SizeUTF8(m_font, preSelectionString.data(), &m_selectionRect.x, nullptr);
-
-		//Selection box size
-		std::string selectionString = m_commitedString.substr(m_selectionIndexBegin, m_selectionIndexEnd - m_selectionIndexBegin);
-		TTF_SizeUTF8(m_font, selectionString.data(), &m_selectionRect.w, &m_selectionRect.h);
+		//Scroll so the cursor is shown. Only text around the cursor is measured, so a long string costs no more than a short one
+		size_t cursorIndex = composing ? m_compositionIndex : m_cursorIndex;
+		int cursorCompositionW = 0; //Composition before the cursor
+		if (composing) {
+			m_sizeText(m_compositionString.substr(0, m_compositionCursorIndex), &cursorCompositionW, nullptr);
+		}
+		m_viewIndex = m_commitedGraphemes.floor(m_viewIndex); //Edits since the last update may have moved the boundaries
+		if (prompt) {
+			m_viewIndex = 0;
+			m_viewShift = 0;
+		}
+		else if (cursorIndex < m_viewIndex || (cursorIndex == m_viewIndex && m_viewShift + cursorCompositionW < 0)) { //Cursor too far left, put it on the left edge
+			m_viewIndex = cursorIndex;
+			m_viewShift = 0;
+		}
+		else {
+			size_t fits = m_fitBefore(cursorIndex, m_viewIndex, fieldW - cursorCompositionW);
+			if (fits > m_viewIndex) { //Cursor too far right, put it on the right edge
+				m_viewIndex = m_commitedGraphemes.previous(fits);
+				m_viewShift = fieldW - cursorCompositionW - m_spanWidth(m_viewIndex, cursorIndex);
+			}
+		}
+		size_t shownEnd = prompt ? 0 : m_fillAfter(m_viewIndex, fieldW - m_viewShift - compositionW); //Text past this is out of view
+		if (shownEnd == m_commitedString.size() && (m_viewIndex > 0 || m_viewShift < 0)
+			&& m_viewShift + m_spanWidth(m_viewIndex, shownEnd) + compositionW < fieldW) { //The end is too far left, shift right so the most text is shown
+			size_t fits = m_fitBefore(shownEnd, 0, fieldW - compositionW);
+			if (fits == 0) { //Everything fits, keep 0 aligned
+				m_viewIndex = 0;
+				m_viewShift = 0;
+			}
+			else {
+				m_viewIndex = m_commitedGraphemes.previous(fits);
+				m_viewShift = fieldW - compositionW - m_spanWidth(m_viewIndex, shownEnd);
+			}
+		}
+		size_t splitIndex = composing ? std::min(std::max(m_compositionIndex, m_viewIndex), shownEnd) : shownEnd;
 
 		//commitedLeft size, composition and underline position
 		std::string preCompositionString;
-		if (!m_typing && m_commitedString == "") { //Show the default text / prompt
+		if (prompt) { //Show the default text / prompt
 			preCompositionString = m_defaultString;
-			TTF_SizeUTF8(m_font, m_defaultString.data(), &m_commitedRectLeft.w, &m_commitedRectLeft.h);
-		}
-		else if (m_compositionString != "") { //Composing some stuff, split it there
-			preCompositionString = m_commitedString.substr(0, m_compositionIndex);
-			TTF_SizeUTF8(m_font, preCompositionString.data(), &m_commitedRectLeft.w, &m_commitedRectLeft.h);
+			textCache::global().size(m_font, m_defaultString, &m_commitedRectLeft.w, &m_commitedRectLeft.h); //The prompt rarely changes, so share its measurement
 		}
 		else {
-			preCompositionString = m_commitedString;
-			TTF_SizeUTF8(m_font, m_commitedString.data(), &m_commitedRectLeft.w, &m_commitedRectLeft.h);
+			preCompositionString = m_commitedString.substr(m_viewIndex, splitIndex - m_viewIndex);
+			m_sizeText(preCompositionString, &m_commitedRectLeft.w, &m_commitedRectLeft.h);
 		}
+		m_commitedRectLeft.x = m_viewShift;
 		m_compositionRect.x = m_commitedRectLeft.x + m_commitedRectLeft.w;
 		m_underlineRect.x = m_commitedRectLeft.x + m_commitedRectLeft.w;
 
-		//Cursor position
-		if (m_compositionString == "") { //No composition
-			//std::cout << "\tNo composition, rendering cursor position..." << std::endl;
-			std::string preCursorString = m_commitedString.substr(0, m_cursorIndex);
-			TTF_SizeUTF8(m_font, preCursorString.data(), &m_cursorRect.x, &m_cursorRect.h);
-		}
-		else { //Composition
-		 //std::cout << "\tComposition found, rendering cursor position within composition..." << std::endl;
-			std::string preCursorString = m_compositionString.substr(0, m_compositionCursorIndex);
-			TTF_SizeUTF8(m_font, preCursorString.data(), &m_cursorRect.x, &m_cursorRect.h);
-			m_cursorRect.x += m_commitedRectLeft.w;
-		}
-		m_cursorRect.x += m_commitedRectLeft.x + m_cursorRect.w / 2;
-		//If the cursor is off screen, adjust our rendering offset to account for it to be *just* on the edge
-		//TODO: This
+		//Selection box, the part of it in view
+		size_t selectionBegin = std::min(std::max(m_selectionIndexBegin, m_viewIndex), shownEnd);
+		size_t selectionEnd = std::min(std::max(m_selectionIndexEnd, selectionBegin), shownEnd);
+		m_selectionRect.x = m_viewShift + m_spanWidth(m_viewIndex, selectionBegin);
+		m_sizeText(m_commitedString.substr(selectionBegin, selectionEnd - selectionBegin), &m_selectionRect.w, &m_selectionRect.h);
 
-		//Done by this point: Selection Box, Cursor, CommitedLeft, Underline, Composition
-		//Not done by this point: CommitedRight, Cursor-Correction
-
-		m_commitedRectRight.x = m_compositionRect.x + m_compositionRect.w;
-		std::string postCompositionString;
-		if (m_compositionString != "") {
-			postCompositionString = m_commitedString.substr(m_compositionIndex); //Everything past composition
+		//Cursor position
+		if (!composing) {
+			m_sizeText(m_commitedString.substr(m_viewIndex, m_cursorIndex - std::min(m_cursorIndex, m_viewIndex)), &m_cursorRect.x, &m_cursorRect.h);
+			m_cursorRect.x += m_commitedRectLeft.x;
 		}
 		else {
-			postCompositionString = ""; //Nothing, we only use left
+			m_sizeText(m_compositionString.substr(0, m_compositionCursorIndex), &m_cursorRect.x, &m_cursorRect.h);
+			m_cursorRect.x += m_compositionRect.x;
 		}
-		TTF_SizeUTF8(m_font, postCompositionString.data(), &m_commitedRectRight.w, &m_commitedRectRight.h);
+		m_cursorRect.x += m_cursorRect.w / 2;
 
-		if (m_commitedRectLeft.w + m_compositionRect.w + m_commitedRectRight.w < m_dstrect.w) { //Keep 0 aligned, it fits in dstrect already
-			m_commitedRectLeft.x = 0;
-		}
-		else {
-			if (m_cursorRect.x > m_dstrect.w) { //If cursor is too far right, shift left
-				m_commitedRectLeft.x -= m_cursorRect.x - m_dstrect.w;
-				//m_updateTexture(renderer);
-				//return;
-			}
-			else if (m_cursorRect.x < 0) { //If cursor is too far left, shift right
-				m_commitedRectLeft.x -= m_cursorRect.x;
-				//m_updateTexture(renderer);
-				//return;
-			}
-			else if (m_commitedRectRight.x + m_commitedRectRight.w < m_dstrect.w) { //Right's end is too far left, shift right so max text is shown
-				m_commitedRectLeft.x += m_dstrect.w - (m_commitedRectRight.x + m_commitedRectRight.w);
-				//m_updateTexture(renderer);
-				//return;
-			}
+		//commitedRight, everything past the composition which is in view
+		m_commitedRectRight.x = m_compositionRect.x + m_compositionRect.w;
+		std::string postCompositionString;
+		if (composing) {
+			postCompositionString = m_commitedString.substr(splitIndex, shownEnd - splitIndex);
 		}
+		m_sizeText(postCompositionString, &m_commitedRectRight.w, &m_commitedRectRight.h);
 
 		//Now the rects are all correct (except for non-valid data points).
-		//So now we recreate all the surfaces using the currently known text with m_font
-		SDL_FreeSurface(m_surfaceCommitedLeft);
-		SDL_FreeSurface(m_surfaceComposition);
-		SDL_FreeSurface(m_surfaceCommitedRight);
-		if (m_compositionString == "") { //All text goes in left, right is empty
-			//std::cout << "\tNo composition, rendering all text in commitedLeft..." << std::endl;
-			//std::cout << "\tFocus:" << m_hasFocus << "Typing:" << m_typing << "CommitedString:" << m_commitedString.data() << std::endl;
-			if (!m_typing && m_commitedString == "") { //If we should show the default text / prompt
-				//std::cout << "\t\tWriting default string \"" << m_defaultString.data() << "\"..." << std::endl;
-				m_surfaceCommitedLeft = TTF_RenderUTF8_Solid(m_font, m_defaultString.data(), SDL_Color{ m_r[PromptText], m_g[PromptText], m_b[PromptText], m_a[PromptText] });
-			}
-			else {
-				//std::cout << "\t\tWriting commited string \"" << m_commitedString.data() << "\"..." << std::endl;
-				m_surfaceCommitedLeft = TTF_RenderUTF8_Solid(m_font, m_commitedString.data(), SDL_Color{ m_r[CommitedText], m_g[CommitedText], m_b[CommitedText], m_a[CommitedText] });
-			}
-			m_surfaceComposition = nullptr;
-			m_surfaceCommitedRight = nullptr;
+		//The texture and staging surface are only reallocated when the size of the field changes
+		int w = fieldW, h = (int)std::round(m_dstrect.h);
+		if (w <= 0 || h <= 0) {
+			return; //Nothing to draw on
 		}
-		else {
-			//std::cout << "\tComposition found, rendering text in 3 chunks..." << std::endl;
-			m_surfaceCommitedLeft = TTF_RenderUTF8_Solid(m_font, preCompositionString.data(), SDL_Color{ m_r[CommitedText], m_g[CommitedText], m_b[CommitedText], m_a[CommitedText] });
-			m_surfaceComposition = TTF_RenderUTF8_Solid(m_font, m_compositionString.data(), SDL_Color{ m_r[CompositionText], m_g[CompositionText], m_b[CompositionText], m_a[CompositionText] });
-			m_surfaceCommitedRight = TTF_RenderUTF8_Solid(m_font, postCompositionString.data(), SDL_Color{ m_r[CommitedText], m_g[CommitedText], m_b[CommitedText], m_a[CommitedText] });
+		if (m_surface == nullptr || m_surface->w != w || m_surface->h != h) {
+			SDL_FreeSurface(m_surface);
+			m_surface = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_ARGB8888);
+		}
+		int textureW = 0, textureH = 0;
+		if (m_texture != nullptr) {
+			SDL_QueryTexture(m_texture, nullptr, nullptr, &textureW, &textureH);
+		}
+		if (m_texture == nullptr || textureW != w || textureH != h) {
+			renderBackend::destroyTexture(m_texture);
+			m_texture = renderBackend::get(renderer)->createTexture(SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, w, h);
+			SDL_SetTextureBlendMode(m_texture, SDL_BLENDMODE_BLEND);
+		}
+		if (m_surface == nullptr || m_texture == nullptr) {
+			return;
 		}
 
-		//Surfaces are finished now and are ready. Please watch warmly until the texture is ready.
-		SDL_DestroyTexture(m_texture); //Won't be needing these anymore
-		SDL_DestroyTexture(m_textureCommitedLeft);
-		SDL_DestroyTexture(m_textureComposition);
-		SDL_DestroyTexture(m_textureCommitedRight);
-
-		m_textureCommitedLeft = SDL_CreateTextureFromSurface(renderer, m_surfaceCommitedLeft);
-		m_textureComposition = SDL_CreateTextureFromSurface(renderer, m_surfaceComposition);
-		m_textureCommitedRight = SDL_CreateTextureFromSurface(renderer, m_surfaceCommitedRight);
-
-		m_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ABGR8888, SDL_TEXTUREACCESS_TARGET, std::round(m_dstrect.w), std::round(m_dstrect.h));
-		SDL_SetTextureBlendMode(m_texture, SDL_BLENDMODE_BLEND);
-
-		//Store previous things we will be changing for our texture rendering
-		SDL_Texture *prevRenderTarget = SDL_GetRenderTarget(renderer);
-		Uint8 prevR, prevG, prevB, prevA;
-		SDL_GetRenderDrawColor(renderer, &prevR, &prevG, &prevB, &prevA);
-		SDL_SetRenderTarget(renderer, m_texture);
-
-		//Clear texture
-		SDL_SetRenderDrawColor(renderer, m_r[Background], m_g[Background], m_b[Background], m_a[Background]);
-		SDL_RenderClear(renderer);
+		//Clear surface
+		SDL_FillRect(m_surface, nullptr, SDL_MapRGBA(m_surface->format, m_r[Background], m_g[Background], m_b[Background], m_a[Background]));
 		//Render the selection box first
-		SDL_SetRenderDrawColor(renderer, m_r[SelectionBox], m_g[SelectionBox], m_b[SelectionBox], m_a[SelectionBox]);
-		SDL_RenderFillRect(renderer, &m_selectionRect);
+		SDL_FillRect(m_surface, &m_selectionRect, SDL_MapRGBA(m_surface->format, m_r[SelectionBox], m_g[SelectionBox], m_b[SelectionBox], m_a[SelectionBox]));
 		//Composition underline second
-		SDL_SetRenderDrawColor(renderer, m_r[CompositionUnderline], m_g[CompositionUnderline], m_b[CompositionUnderline], m_a[CompositionUnderline]);
+		Uint32 underlineColor = SDL_MapRGBA(m_surface->format, m_r[CompositionUnderline], m_g[CompositionUnderline], m_b[CompositionUnderline], m_a[CompositionUnderline]);
 		if (m_underlineLengths[1] <= 0) {
-			SDL_RenderFillRect(renderer, &m_underlineRect);
+			SDL_FillRect(m_surface, &m_underlineRect, underlineColor);
 		}
 		else if (m_underlineLengths[0] > 0 && m_underlineLengths[1] > 0) {
 			SDL_Rect dashRect = m_underlineRect;
@@ -506,55 +559,169 @@ namespace lui {
 				if (dashRect.x + dashRect.w > m_underlineRect.x + m_underlineRect.w) {
 					dashRect.w = (dashRect.x + dashRect.w) - (m_underlineRect.x + m_underlineRect.w);
 				}
-				SDL_RenderFillRect(renderer, &dashRect);
+				SDL_FillRect(m_surface, &dashRect, underlineColor);
 			}
 		}
 		//Then the various texts
-		SDL_RenderCopy(renderer, m_textureCommitedLeft, NULL, &m_commitedRectLeft);
-		//std::cout << m_commitedRectLeft.x << " for " << m_commitedRectLeft.w << std::endl;
-		SDL_RenderCopy(renderer, m_textureCommitedRight, NULL, &m_commitedRectRight);
-		SDL_RenderCopy(renderer, m_textureComposition, NULL, &m_compositionRect);
+		if (!composing) { //All text goes in left, right is empty
+			m_blitText(preCompositionString, prompt ? PromptText : CommitedText, m_commitedRectLeft);
+		}
+		else {
+			m_blitText(preCompositionString, CommitedText, m_commitedRectLeft);
+			m_blitText(postCompositionString, CommitedText, m_commitedRectRight);
+			m_blitText(m_compositionString, CompositionText, m_compositionRect);
+		}
 		//Then the cursor
 		if (m_typing && m_cursorTimer < 750) {
-			SDL_SetRenderDrawColor(renderer, m_r[Cursor], m_g[Cursor], m_b[Cursor], m_a[Cursor]);
-			SDL_RenderFillRect(renderer, &m_cursorRect);
+			SDL_FillRect(m_surface, &m_cursorRect, SDL_MapRGBA(m_surface->format, m_r[Cursor], m_g[Cursor], m_b[Cursor], m_a[Cursor]));
 		}
 
-		//Restore previous settings
-		SDL_SetRenderTarget(renderer, prevRenderTarget);
-		SDL_SetRenderDrawColor(renderer, prevR, prevG, prevB, prevA);
+		//Upload into the existing texture
+		renderBackend::get(renderer)->updateTexture(m_texture, nullptr, m_surface->pixels, m_surface->pitch);
 
 		//std::cout << "Texture has been updated" << std::endl;
 	}
 
 
 
-	size_t getUTF8GraphemeIndex(const std::string &s, int graphemeDistance, size_t fromByte) {
-		//std::cout << "Moving UTF from byte " << fromByte << " " << graphemeDistance << " graphemes." << std::endl;
-		if (fromByte > s.size()) {
-			fromByte = s.size() - 1;
-			//std::cout << "Cliping from top to range" << std::endl;
+	int textField::m_sizeText(const std::string &s, int *w, int *h) {
+		std::lock_guard<std::mutex> lock(textCache::global().getFontMutex()); //Fields may be drawn on worker threads sharing the font
+		return TTF_SizeUTF8(m_font, s.data(), w, h);
+	}
+	void textField::m_blitText(const std::string &s, int component, SDL_Rect &dstrect) {
+		if (s == "") {
+			return;
+		}
+		SDL_Surface *text;
+		{
+			std::lock_guard<std::mutex> lock(textCache::global().getFontMutex());
+			text = TTF_RenderUTF8_Solid(m_font, s.data(), SDL_Color{ m_r[component], m_g[component], m_b[component], m_a[component] });
 		}
-		else if (fromByte < 0) {
-			fromByte = 0;
-			//std::cout << "Cliping from bottom to range" << std::endl;
+		if (text == nullptr) {
+			return;
 		}
-		while (s[fromByte] <= (char)0b10111111 && s[fromByte] >= (char)0b10000000 && fromByte > 0) { //Make sure we start on a valid byte
-			fromByte--;
-			//std::cout << "Getting start byte of current grapheme" << std::endl;
+		SDL_Rect blitRect = dstrect; //SDL_BlitSurface clips the rect it is given
+		SDL_BlitSurface(text, nullptr, m_surface, &blitRect);
+		SDL_FreeSurface(text);
+	}
+	int textField::m_spanWidth(size_t begin, size_t end) {
+		int w = 0;
+		if (end > begin) {
+			m_sizeText(m_commitedString.substr(begin, end - begin), &w, nullptr);
 		}
+		return w;
+	}
+	size_t textField::m_fitBefore(size_t end, size_t floor, int room) {
+		//Step back by twice as many clusters each time, then narrow down between the last two steps
+		size_t fits = end;
+		int clusters = 1;
+		while (fits > floor) {
+			size_t begin = std::max(m_commitedGraphemes.move(fits, -clusters), floor);
+			if (m_spanWidth(begin, end) > room) {
+				size_t wide = begin;
+				while (m_commitedGraphemes.next(wide) < fits) {
+					size_t middle = std::max(m_commitedGraphemes.floor(wide + (fits - wide) / 2), m_commitedGraphemes.next(wide));
+					if (m_spanWidth(middle, end) > room) {
+						wide = middle;
+					}
+					else {
+						fits = middle;
+					}
+				}
+				return fits;
+			}
+			fits = begin;
+			clusters *= 2;
+		}
+		return fits;
+	}
+	size_t textField::m_fillAfter(size_t begin, int room) {
+		if (room <= 0) {
+			return begin;
+		}
+		//Step forward by twice as many clusters each time, then narrow down between the last two steps
+		size_t narrow = begin;
+		int clusters = 1;
+		while (narrow < m_commitedString.size()) {
+			size_t end = m_commitedGraphemes.move(narrow, clusters);
+			if (m_spanWidth(begin, end) >= room) {
+				while (m_commitedGraphemes.next(narrow) < end) {
+					size_t middle = std::max(m_commitedGraphemes.floor(narrow + (end - narrow) / 2), m_commitedGraphemes.next(narrow));
+					if (m_spanWidth(begin, middle) >= room) {
+						end = middle;
+					}
+					else {
+						narrow = middle;
+					}
+				}
+				return end;
+			}
+			narrow = end;
+			clusters *= 2;
+		}
+		return m_commitedString.size();
+	}
+	size_t textField::m_remainingLength() {
+		if (m_maxLength == 0) {
+			return std::string::npos;
+		}
+		return m_maxLength > m_commitedString.size() ? m_maxLength - m_commitedString.size() : 0;
+	}
+	void textField::m_pasteStep(size_t bytes) {
+		if (!isPasting()) {
+			return;
+		}
+		size_t end = m_pasteOffset + std::min(bytes, m_pasteBuffer.size() - m_pasteOffset);
+		size_t whole = end;
+		while (whole > m_pasteOffset && whole < m_pasteBuffer.size() && (m_pasteBuffer[whole] & 0xC0) == 0x80) { //Don't split a code point between chunks
+			whole--;
+		}
+		if (whole > m_pasteOffset) {
+			end = whole;
+		}
+
+		//Keep the valid runs, dropping bytes which are not UTF-8
+		std::string chunk;
+		chunk.reserve(end - m_pasteOffset);
+		const char *p = m_pasteBuffer.data() + m_pasteOffset;
+		size_t left = end - m_pasteOffset;
+		while (left > 0) {
+			size_t valid = UTF8ValidLength(p, left);
+			chunk.append(p, valid);
+			p += valid;
+			left -= valid;
+			if (left > 0) {
+				p++;
+				left--;
+			}
+		}
+		m_pasteOffset = end;
 
-		for (; graphemeDistance > 0 && fromByte < s.size(); graphemeDistance--) { //For moving forward
-			fromByte++;
-			//std::cout << "Moving forward" << std::endl;
-			for (char c = s[fromByte]; c >= (char)0b10000000 && c <= (char)0b10111111 && fromByte < s.size(); fromByte++, c = s[fromByte]); //Skip over non-starting bytes
+		if (chunk.size() > m_remainingLength()) { //Out of room, cut off at a code point and stop pasting
+			chunk.resize(UTF8Advance(chunk, m_remainingLength(), 0));
+			m_pasteOffset = m_pasteBuffer.size();
 		}
-		for (; graphemeDistance < 0 && fromByte > 0; graphemeDistance++) { //For moving backwards
-			fromByte--;
-			//std::cout << "Moving forward" << std::endl;
-			for (char c = s[fromByte]; c >= (char)0b10000000 && c <= (char)0b10111111 && fromByte > 0; fromByte--, c = s[fromByte]); //Skip over non-starting bytes
+		m_insertCommited(m_cursorIndex, chunk);
+		m_cursorIndex += chunk.size();
+
+		if (!isPasting()) {
+			std::string().swap(m_pasteBuffer); //Release the memory of large pastes
+			m_pasteOffset = 0;
+			m_updateTextureNextRender = true;
+			m_cursorTimer = 0;
+			m_callEventFunction(ValueChanged);
 		}
-		return fromByte;
+	}
+	void textField::m_finishPaste() {
+		m_pasteStep(m_pasteBuffer.size());
+	}
+	void textField::m_eraseCommited(size_t index, size_t length) {
+		m_commitedString.erase(index, length);
+		m_commitedGraphemes.replace(m_commitedString, index, length, 0);
+	}
+	void textField::m_insertCommited(size_t index, const std::string &s) {
+		m_commitedString.insert(index, s);
+		m_commitedGraphemes.replace(m_commitedString, index, 0, s.size());
 	}
 
 }
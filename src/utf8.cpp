@@ -0,0 +1,479 @@
+#include "./utf8.hpp"
+
+extern "C" {
+#include <SDL2/SDL.h>
+}
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LUI_UTF8_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define LUI_UTF8_NEON
+#include <arm_neon.h>
+#endif
+
+namespace lui {
+
+	namespace {
+		//Grapheme_Cluster_Break values of UAX #29, with Extended_Pictographic folded in (All such code points are "Other")
+		enum graphemeProperty : Uint8 { Other, CR, LF, Control, Extend, ZWJ, RegionalIndicator, Prepend, SpacingMark, L, V, T, LV, LVT, ExtendedPictographic };
+
+		struct codePointRange {
+			Uint32 first, last;
+		};
+
+		//Abridged from GraphemeBreakProperty.txt and emoji-data.txt (Unicode 13)
+		const codePointRange controlRanges[] = {
+			{ 0x00AD, 0x00AD }, { 0x061C, 0x061C }, { 0x180E, 0x180E }, { 0x200B, 0x200B }, { 0x200E, 0x200F }, { 0x2028, 0x202E }, { 0x2060, 0x206F },
+			{ 0xFEFF, 0xFEFF }, { 0xFFF0, 0xFFFB }, { 0xE0000, 0xE001F }, { 0xE0080, 0xE00FF }, { 0xE01F0, 0xE0FFF }
+		};
+		const codePointRange extendRanges[] = {
+			{ 0x0300, 0x036F }, { 0x0483, 0x0489 }, { 0x0591, 0x05BD }, { 0x05BF, 0x05BF }, { 0x05C1, 0x05C2 }, { 0x05C4, 0x05C5 }, { 0x05C7, 0x05C7 },
+			{ 0x0610, 0x061A }, { 0x064B, 0x065F }, { 0x0670, 0x0670 }, { 0x06D6, 0x06DC }, { 0x06DF, 0x06E4 }, { 0x06E7, 0x06E8 }, { 0x06EA, 0x06ED },
+			{ 0x0711, 0x0711 }, { 0x0730, 0x074A }, { 0x07A6, 0x07B0 }, { 0x07EB, 0x07F3 }, { 0x0816, 0x0819 }, { 0x081B, 0x0823 }, { 0x0825, 0x0827 },
+			{ 0x0829, 0x082D }, { 0x0859, 0x085B }, { 0x08D3, 0x08E1 }, { 0x08E3, 0x0902 }, { 0x093A, 0x093A }, { 0x093C, 0x093C }, { 0x0941, 0x0948 },
+			{ 0x094D, 0x094D }, { 0x0951, 0x0957 }, { 0x0962, 0x0963 }, { 0x0981, 0x0981 }, { 0x09BC, 0x09BC }, { 0x09BE, 0x09BE }, { 0x09C1, 0x09C4 },
+			{ 0x09CD, 0x09CD }, { 0x09D7, 0x09D7 }, { 0x09E2, 0x09E3 }, { 0x0A01, 0x0A02 }, { 0x0A3C, 0x0A3C }, { 0x0A41, 0x0A51 }, { 0x0A70, 0x0A71 },
+			{ 0x0A75, 0x0A75 }, { 0x0A81, 0x0A82 }, { 0x0ABC, 0x0ABC }, { 0x0AC1, 0x0AC8 }, { 0x0ACD, 0x0ACD }, { 0x0AE2, 0x0AE3 }, { 0x0B01, 0x0B01 },
+			{ 0x0B3C, 0x0B3C }, { 0x0B3E, 0x0B3F }, { 0x0B41, 0x0B44 }, { 0x0B4D, 0x0B4D }, { 0x0B56, 0x0B57 }, { 0x0BBE, 0x0BBE }, { 0x0BC0, 0x0BC0 },
+			{ 0x0BCD, 0x0BCD }, { 0x0BD7, 0x0BD7 }, { 0x0C00, 0x0C00 }, { 0x0C3E, 0x0C40 }, { 0x0C46, 0x0C56 }, { 0x0CBC, 0x0CBC }, { 0x0CBF, 0x0CBF },
+			{ 0x0CC2, 0x0CC2 }, { 0x0CC6, 0x0CC6 }, { 0x0CCC, 0x0CCD }, { 0x0CD5, 0x0CD6 }, { 0x0D3E, 0x0D3E }, { 0x0D41, 0x0D44 }, { 0x0D4D, 0x0D4D },
+			{ 0x0D57, 0x0D57 }, { 0x0DCA, 0x0DCA }, { 0x0DCF, 0x0DCF }, { 0x0DD2, 0x0DD6 }, { 0x0DDF, 0x0DDF }, { 0x0E31, 0x0E31 }, { 0x0E34, 0x0E3A },
+			{ 0x0E47, 0x0E4E }, { 0x0EB1, 0x0EB1 }, { 0x0EB4, 0x0EBC }, { 0x0EC8, 0x0ECD }, { 0x0F18, 0x0F19 }, { 0x0F35, 0x0F35 }, { 0x0F37, 0x0F37 },
+			{ 0x0F39, 0x0F39 }, { 0x0F71, 0x0F7E }, { 0x0F80, 0x0F84 }, { 0x0F86, 0x0F87 }, { 0x0F8D, 0x0FBC }, { 0x102D, 0x1030 }, { 0x1032, 0x1037 },
+			{ 0x1039, 0x103A }, { 0x103D, 0x103E }, { 0x1058, 0x1059 }, { 0x105E, 0x1060 }, { 0x1071, 0x1074 }, { 0x1082, 0x1082 }, { 0x1085, 0x1086 },
+			{ 0x108D, 0x108D }, { 0x109D, 0x109D }, { 0x135D, 0x135F }, { 0x1712, 0x1714 }, { 0x1732, 0x1734 }, { 0x1752, 0x1753 }, { 0x1772, 0x1773 },
+			{ 0x17B4, 0x17B5 }, { 0x17B7, 0x17BD }, { 0x17C6, 0x17C6 }, { 0x17C9, 0x17D3 }, { 0x17DD, 0x17DD }, { 0x180B, 0x180D }, { 0x1885, 0x1886 },
+			{ 0x18A9, 0x18A9 }, { 0x1920, 0x1922 }, { 0x1927, 0x1928 }, { 0x1932, 0x1932 }, { 0x1939, 0x193B }, { 0x1A17, 0x1A18 }, { 0x1A1B, 0x1A1B },
+			{ 0x1A56, 0x1A56 }, { 0x1A58, 0x1A60 }, { 0x1A62, 0x1A62 }, { 0x1A65, 0x1A6C }, { 0x1A73, 0x1A7F }, { 0x1AB0, 0x1AFF }, { 0x1B00, 0x1B03 },
+			{ 0x1B34, 0x1B3A }, { 0x1B3C, 0x1B3C }, { 0x1B42, 0x1B42 }, { 0x1B6B, 0x1B73 }, { 0x1B80, 0x1B81 }, { 0x1BA2, 0x1BA5 }, { 0x1BA8, 0x1BA9 },
+			{ 0x1BAB, 0x1BAD }, { 0x1BE6, 0x1BE6 }, { 0x1BE8, 0x1BE9 }, { 0x1BED, 0x1BED }, { 0x1BEF, 0x1BF1 }, { 0x1C2C, 0x1C33 }, { 0x1C36, 0x1C37 },
+			{ 0x1CD0, 0x1CD2 }, { 0x1CD4, 0x1CE0 }, { 0x1CE2, 0x1CE8 }, { 0x1CED, 0x1CED }, { 0x1CF4, 0x1CF4 }, { 0x1CF8, 0x1CF9 }, { 0x1DC0, 0x1DFF },
+			{ 0x200C, 0x200C }, { 0x20D0, 0x20F0 }, { 0x2CEF, 0x2CF1 }, { 0x2D7F, 0x2D7F }, { 0x2DE0, 0x2DFF }, { 0x302A, 0x302F }, { 0x3099, 0x309A },
+			{ 0xA66F, 0xA672 }, { 0xA674, 0xA67D }, { 0xA69E, 0xA69F }, { 0xA6F0, 0xA6F1 }, { 0xA802, 0xA802 }, { 0xA806, 0xA806 }, { 0xA80B, 0xA80B },
+			{ 0xA825, 0xA826 }, { 0xA8C4, 0xA8C5 }, { 0xA8E0, 0xA8F1 }, { 0xA8FF, 0xA8FF }, { 0xA926, 0xA92D }, { 0xA947, 0xA951 }, { 0xA980, 0xA982 },
+			{ 0xA9B3, 0xA9B3 }, { 0xA9B6, 0xA9B9 }, { 0xA9BC, 0xA9BD }, { 0xA9E5, 0xA9E5 }, { 0xAA29, 0xAA2E }, { 0xAA31, 0xAA32 }, { 0xAA35, 0xAA36 },
+			{ 0xAA43, 0xAA43 }, { 0xAA4C, 0xAA4C }, { 0xAA7C, 0xAA7C }, { 0xAAB0, 0xAAB0 }, { 0xAAB2, 0xAAB4 }, { 0xAAB7, 0xAAB8 }, { 0xAABE, 0xAABF },
+			{ 0xAAC1, 0xAAC1 }, { 0xAAEC, 0xAAED }, { 0xAAF6, 0xAAF6 }, { 0xABE5, 0xABE5 }, { 0xABE8, 0xABE8 }, { 0xABED, 0xABED }, { 0xFB1E, 0xFB1E },
+			{ 0xFE00, 0xFE0F }, { 0xFE20, 0xFE2F }, { 0xFF9E, 0xFF9F }, { 0x101FD, 0x101FD }, { 0x1D165, 0x1D165 }, { 0x1D167, 0x1D169 },
+			{ 0x1D16E, 0x1D172 }, { 0x1D17B, 0x1D182 }, { 0x1D185, 0x1D18B }, { 0x1D1AA, 0x1D1AD }, { 0x1F3FB, 0x1F3FF }, { 0xE0020, 0xE007F },
+			{ 0xE0100, 0xE01EF }
+		};
+		const codePointRange spacingMarkRanges[] = {
+			{ 0x0903, 0x0903 }, { 0x093B, 0x093B }, { 0x093E, 0x0940 }, { 0x0949, 0x094C }, { 0x094E, 0x094F }, { 0x0982, 0x0983 }, { 0x09BF, 0x09C0 },
+			{ 0x09C7, 0x09C8 }, { 0x09CB, 0x09CC }, { 0x0A03, 0x0A03 }, { 0x0A3E, 0x0A40 }, { 0x0A83, 0x0A83 }, { 0x0ABE, 0x0AC0 }, { 0x0AC9, 0x0AC9 },
+			{ 0x0ACB, 0x0ACC }, { 0x0B02, 0x0B03 }, { 0x0B40, 0x0B40 }, { 0x0B47, 0x0B48 }, { 0x0B4B, 0x0B4C }, { 0x0BBF, 0x0BBF }, { 0x0BC1, 0x0BC2 },
+			{ 0x0BC6, 0x0BC8 }, { 0x0BCA, 0x0BCC }, { 0x0C01, 0x0C03 }, { 0x0C41, 0x0C44 }, { 0x0C82, 0x0C83 }, { 0x0CBE, 0x0CBE }, { 0x0CC0, 0x0CC1 },
+			{ 0x0CC3, 0x0CC4 }, { 0x0CC7, 0x0CC8 }, { 0x0CCA, 0x0CCB }, { 0x0D02, 0x0D03 }, { 0x0D3F, 0x0D40 }, { 0x0D46, 0x0D48 }, { 0x0D4A, 0x0D4C },
+			{ 0x0D82, 0x0D83 }, { 0x0DD0, 0x0DD1 }, { 0x0DD8, 0x0DDE }, { 0x0DF2, 0x0DF3 }, { 0x0E33, 0x0E33 }, { 0x0EB3, 0x0EB3 }, { 0x0F3E, 0x0F3F },
+			{ 0x0F7F, 0x0F7F }, { 0x1031, 0x1031 }, { 0x103B, 0x103C }, { 0x1056, 0x1057 }, { 0x1084, 0x1084 }, { 0x17B6, 0x17B6 }, { 0x17BE, 0x17C5 },
+			{ 0x17C7, 0x17C8 }, { 0x1923, 0x1926 }, { 0x1929, 0x192B }, { 0x1930, 0x1931 }, { 0x1933, 0x1938 }, { 0x1A19, 0x1A1A }, { 0x1A55, 0x1A55 },
+			{ 0x1A57, 0x1A57 }, { 0x1A6D, 0x1A72 }, { 0x1B04, 0x1B04 }, { 0x1B3B, 0x1B3B }, { 0x1B3D, 0x1B41 }, { 0x1B43, 0x1B44 }, { 0x1B82, 0x1B82 },
+			{ 0x1BA1, 0x1BA1 }, { 0x1BA6, 0x1BA7 }, { 0x1BAA, 0x1BAA }, { 0x1BE7, 0x1BE7 }, { 0x1BEA, 0x1BEC }, { 0x1BEE, 0x1BEE }, { 0x1BF2, 0x1BF3 },
+			{ 0x1C24, 0x1C2B }, { 0x1C34, 0x1C35 }, { 0x1CE1, 0x1CE1 }, { 0x1CF7, 0x1CF7 }, { 0xA823, 0xA824 }, { 0xA827, 0xA827 }, { 0xA880, 0xA881 },
+			{ 0xA8B4, 0xA8C3 }, { 0xA952, 0xA953 }, { 0xA983, 0xA983 }, { 0xA9B4, 0xA9B5 }, { 0xA9BA, 0xA9BB }, { 0xA9BE, 0xA9C0 }, { 0xAA2F, 0xAA30 },
+			{ 0xAA33, 0xAA34 }, { 0xAA4D, 0xAA4D }, { 0xAAEB, 0xAAEB }, { 0xAAEE, 0xAAEF }, { 0xAAF5, 0xAAF5 }, { 0xABE3, 0xABE4 }, { 0xABE6, 0xABE7 },
+			{ 0xABE9, 0xABEA }, { 0xABEC, 0xABEC }
+		};
+		const codePointRange prependRanges[] = {
+			{ 0x0600, 0x0605 }, { 0x06DD, 0x06DD }, { 0x070F, 0x070F }, { 0x08E2, 0x08E2 }, { 0x0D4E, 0x0D4E }, { 0x110BD, 0x110BD }, { 0x110CD, 0x110CD },
+			{ 0x111C2, 0x111C3 }, { 0x11A3A, 0x11A3A }, { 0x11A84, 0x11A89 }, { 0x11D46, 0x11D46 }
+		};
+		const codePointRange pictographicRanges[] = {
+			{ 0x00A9, 0x00A9 }, { 0x00AE, 0x00AE }, { 0x203C, 0x203C }, { 0x2049, 0x2049 }, { 0x2122, 0x2122 }, { 0x2139, 0x2139 }, { 0x2194, 0x2199 },
+			{ 0x21A9, 0x21AA }, { 0x231A, 0x231B }, { 0x2328, 0x2328 }, { 0x2388, 0x2388 }, { 0x23CF, 0x23CF }, { 0x23E9, 0x23F3 }, { 0x23F8, 0x23FA },
+			{ 0x24C2, 0x24C2 }, { 0x25AA, 0x25AB }, { 0x25B6, 0x25B6 }, { 0x25C0, 0x25C0 }, { 0x25FB, 0x25FE }, { 0x2600, 0x2605 }, { 0x2607, 0x2612 },
+			{ 0x2614, 0x2685 }, { 0x2690, 0x2705 }, { 0x2708, 0x2712 }, { 0x2714, 0x2714 }, { 0x2716, 0x2716 }, { 0x271D, 0x271D }, { 0x2721, 0x2721 },
+			{ 0x2728, 0x2728 }, { 0x2733, 0x2734 }, { 0x2744, 0x2744 }, { 0x2747, 0x2747 }, { 0x274C, 0x274C }, { 0x274E, 0x274E }, { 0x2753, 0x2755 },
+			{ 0x2757, 0x2757 }, { 0x2763, 0x2767 }, { 0x2795, 0x2797 }, { 0x27A1, 0x27A1 }, { 0x27B0, 0x27B0 }, { 0x27BF, 0x27BF }, { 0x2934, 0x2935 },
+			{ 0x2B05, 0x2B07 }, { 0x2B1B, 0x2B1C }, { 0x2B50, 0x2B50 }, { 0x2B55, 0x2B55 }, { 0x3030, 0x3030 }, { 0x303D, 0x303D }, { 0x3297, 0x3297 },
+			{ 0x3299, 0x3299 }, { 0x1F000, 0x1F0FF }, { 0x1F10D, 0x1F10F }, { 0x1F12F, 0x1F12F }, { 0x1F16C, 0x1F171 }, { 0x1F17E, 0x1F17F },
+			{ 0x1F18E, 0x1F18E }, { 0x1F191, 0x1F19A }, { 0x1F1AD, 0x1F1E5 }, { 0x1F201, 0x1F20F }, { 0x1F21A, 0x1F21A }, { 0x1F22F, 0x1F22F },
+			{ 0x1F232, 0x1F23A }, { 0x1F23C, 0x1F23F }, { 0x1F249, 0x1F3FA }, { 0x1F400, 0x1F53D }, { 0x1F546, 0x1F64F }, { 0x1F680, 0x1F6FF },
+			{ 0x1F774, 0x1F77F }, { 0x1F7D5, 0x1F7FF }, { 0x1F80C, 0x1F80F }, { 0x1F848, 0x1F84F }, { 0x1F85A, 0x1F85F }, { 0x1F888, 0x1F88F },
+			{ 0x1F8AE, 0x1F8FF }, { 0x1F90C, 0x1F93A }, { 0x1F93C, 0x1F945 }, { 0x1F947, 0x1FAFF }, { 0x1FC00, 0x1FFFD }
+		};
+
+		template<size_t N>
+		bool inRanges(const codePointRange (&ranges)[N], Uint32 cp) {
+			if (cp < ranges[0].first || cp > ranges[N - 1].last) {
+				return false;
+			}
+			const codePointRange *found = std::upper_bound(ranges, ranges + N, cp, [](Uint32 value, const codePointRange &r) { return value < r.first; });
+			return found != ranges && cp <= (found - 1)->last;
+		}
+
+		graphemeProperty getGraphemeProperty(Uint32 cp) {
+			if (cp < 0x0300) { //Latin-1 and friends, which make up nearly all text
+				if (cp == 0x0D) {
+					return CR;
+				}
+				if (cp == 0x0A) {
+					return LF;
+				}
+				if (cp < 0x20 || (cp >= 0x7F && cp <= 0x9F) || cp == 0xAD) {
+					return Control;
+				}
+				if (cp == 0xA9 || cp == 0xAE) {
+					return ExtendedPictographic;
+				}
+				return Other;
+			}
+			if (cp == 0x200D) {
+				return ZWJ;
+			}
+			if (cp >= 0x1F1E6 && cp <= 0x1F1FF) {
+				return RegionalIndicator;
+			}
+			if ((cp >= 0x1100 && cp <= 0x115F) || (cp >= 0xA960 && cp <= 0xA97C)) {
+				return L;
+			}
+			if ((cp >= 0x1160 && cp <= 0x11A7) || (cp >= 0xD7B0 && cp <= 0xD7C6)) {
+				return V;
+			}
+			if ((cp >= 0x11A8 && cp <= 0x11FF) || (cp >= 0xD7CB && cp <= 0xD7FB)) {
+				return T;
+			}
+			if (cp >= 0xAC00 && cp <= 0xD7A3) { //Precomposed Hangul syllables
+				return (cp - 0xAC00) % 28 == 0 ? LV : LVT;
+			}
+			if (inRanges(controlRanges, cp)) {
+				return Control;
+			}
+			if (inRanges(extendRanges, cp)) {
+				return Extend;
+			}
+			if (inRanges(spacingMarkRanges, cp)) {
+				return SpacingMark;
+			}
+			if (inRanges(prependRanges, cp)) {
+				return Prepend;
+			}
+			if (inRanges(pictographicRanges, cp)) {
+				return ExtendedPictographic;
+			}
+			return Other;
+		}
+
+		//State carried along while segmenting
+		struct segmenterState {
+			graphemeProperty previous = Control; //Start of text breaks like after a control
+			Uint8 pictographic = 0; //1: after ExtPict Extend*, 2: after ExtPict Extend* ZWJ
+			size_t regionalIndicators = 0; //Regional indicators directly before the current code point
+		};
+
+		//Is there a boundary between the previous code point and one with property p
+		bool isBreak(const segmenterState &state, graphemeProperty p) {
+			graphemeProperty prev = state.previous;
+			if (prev == CR && p == LF) { //GB3
+				return false;
+			}
+			if (prev == Control || prev == CR || prev == LF) { //GB4
+				return true;
+			}
+			if (p == Control || p == CR || p == LF) { //GB5
+				return true;
+			}
+			if (prev == L && (p == L || p == V || p == LV || p == LVT)) { //GB6
+				return false;
+			}
+			if ((prev == LV || prev == V) && (p == V || p == T)) { //GB7
+				return false;
+			}
+			if ((prev == LVT || prev == T) && p == T) { //GB8
+				return false;
+			}
+			if (p == Extend || p == ZWJ || p == SpacingMark) { //GB9, GB9a
+				return false;
+			}
+			if (prev == Prepend) { //GB9b
+				return false;
+			}
+			if (prev == ZWJ && state.pictographic == 2 && p == ExtendedPictographic) { //GB11
+				return false;
+			}
+			if (prev == RegionalIndicator && p == RegionalIndicator) { //GB12, GB13
+				return state.regionalIndicators % 2 == 0;
+			}
+			return true; //GB999
+		}
+
+		void advanceState(segmenterState &state, graphemeProperty p) {
+			if (p == ExtendedPictographic) {
+				state.pictographic = 1;
+			}
+			else if (p == Extend && state.pictographic == 1) {
+				state.pictographic = 1;
+			}
+			else if (p == ZWJ && state.pictographic == 1) {
+				state.pictographic = 2;
+			}
+			else {
+				state.pictographic = 0;
+			}
+			state.regionalIndicators = (p == RegionalIndicator) ? state.regionalIndicators + 1 : 0;
+			state.previous = p;
+		}
+
+		//Decode one code point; invalid sequences give U+FFFD with a length of 1
+		bool decode(const unsigned char *p, size_t remaining, Uint32 *cp, size_t *length) {
+			*cp = 0xFFFD;
+			*length = 1;
+			if (p[0] < 0x80) {
+				*cp = p[0];
+				return true;
+			}
+			if (p[0] >= 0xC2 && p[0] <= 0xDF && remaining >= 2 && (p[1] & 0xC0) == 0x80) {
+				*cp = ((p[0] & 0x1F) << 6) | (p[1] & 0x3F);
+				*length = 2;
+				return true;
+			}
+			if (p[0] >= 0xE0 && p[0] <= 0xEF && remaining >= 3 && (p[1] & 0xC0) == 0x80 && (p[2] & 0xC0) == 0x80) {
+				Uint32 decoded = ((p[0] & 0x0F) << 12) | ((p[1] & 0x3F) << 6) | (p[2] & 0x3F);
+				if (decoded >= 0x800 && (decoded < 0xD800 || decoded > 0xDFFF)) { //No overlongs or surrogates
+					*cp = decoded;
+					*length = 3;
+					return true;
+				}
+			}
+			else if (p[0] >= 0xF0 && p[0] <= 0xF4 && remaining >= 4 && (p[1] & 0xC0) == 0x80 && (p[2] & 0xC0) == 0x80 && (p[3] & 0xC0) == 0x80) {
+				Uint32 decoded = ((p[0] & 0x07) << 18) | ((p[1] & 0x3F) << 12) | ((p[2] & 0x3F) << 6) | (p[3] & 0x3F);
+				if (decoded >= 0x10000 && decoded <= 0x10FFFF) {
+					*cp = decoded;
+					*length = 4;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		size_t popcount(Uint32 v) {
+			v = v - ((v >> 1) & 0x55555555);
+			v = (v & 0x33333333) + ((v >> 2) & 0x33333333);
+			return (((v + (v >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+		}
+
+		//Is every byte of a 16 byte block ASCII
+		inline bool isASCIIBlock(const char *s) {
+#if defined(LUI_UTF8_SSE2)
+			return _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)s)) == 0;
+#elif defined(LUI_UTF8_NEON)
+			uint8x16_t high = vandq_u8(vld1q_u8((const uint8_t*)s), vdupq_n_u8(0x80));
+			uint64x2_t halves = vreinterpretq_u64_u8(high);
+			return (vgetq_lane_u64(halves, 0) | vgetq_lane_u64(halves, 1)) == 0;
+#else
+			for (int i = 0; i < 16; i++) {
+				if ((unsigned char)s[i] >= 0x80) {
+					return false;
+				}
+			}
+			return true;
+#endif
+		}
+	}
+
+	Uint32 UTF8Decode(const std::string &s, size_t byte, size_t *length) {
+		size_t l = 1;
+		Uint32 cp = 0xFFFD;
+		if (byte < s.size()) {
+			decode((const unsigned char*)s.data() + byte, s.size() - byte, &cp, &l);
+		}
+		if (length != nullptr) {
+			*length = l;
+		}
+		return cp;
+	}
+
+	size_t UTF8ValidLength(const char *s, size_t length) {
+		size_t i = 0;
+		while (i < length) {
+			//Skip whole blocks of ASCII
+			if (i + 16 <= length && isASCIIBlock(s + i)) {
+				i += 16;
+				continue;
+			}
+			//Validate the next code point
+			Uint32 cp;
+			size_t l;
+			if (!decode((const unsigned char*)s + i, length - i, &cp, &l)) {
+				return i;
+			}
+			i += l;
+		}
+		return length;
+	}
+
+	size_t UTF8Count(const char *s, size_t length) {
+		size_t count = 0, i = 0;
+#if defined(LUI_UTF8_SSE2)
+		const __m128i continuationMax = _mm_set1_epi8((char)0xBF); //Continuation bytes are 0x80-0xBF, or -128 to -65 signed
+		for (; i + 16 <= length; i += 16) {
+			__m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+			count += popcount((Uint32)_mm_movemask_epi8(_mm_cmpgt_epi8(v, continuationMax)));
+		}
+#elif defined(LUI_UTF8_NEON)
+		const int8x16_t continuationMax = vdupq_n_s8((int8_t)0xBF);
+		for (; i + 16 <= length; i += 16) {
+			uint8x16_t starts = vandq_u8(vcgtq_s8(vld1q_s8((const int8_t*)(s + i)), continuationMax), vdupq_n_u8(1));
+			uint64x2_t sums = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(starts)));
+			count += (size_t)(vgetq_lane_u64(sums, 0) + vgetq_lane_u64(sums, 1));
+		}
+#endif
+		for (; i < length; i++) {
+			count += ((unsigned char)s[i] & 0xC0) != 0x80;
+		}
+		return count;
+	}
+
+	size_t UTF8Advance(const std::string &s, size_t fromByte, int codePoints) {
+		fromByte = std::min(fromByte, s.size());
+		while (fromByte > 0 && fromByte < s.size() && ((unsigned char)s[fromByte] & 0xC0) == 0x80) { //Make sure we start on a valid byte
+			fromByte--;
+		}
+		for (; codePoints > 0 && fromByte < s.size(); codePoints--) { //For moving forward
+			size_t l = 1;
+			UTF8Decode(s, fromByte, &l);
+			fromByte += l;
+		}
+		for (; codePoints < 0 && fromByte > 0; codePoints++) { //For moving backwards
+			fromByte--;
+			while (fromByte > 0 && ((unsigned char)s[fromByte] & 0xC0) == 0x80) { //Skip over non-starting bytes
+				fromByte--;
+			}
+		}
+		return fromByte;
+	}
+
+
+
+	graphemeIndex::graphemeIndex() {}
+	graphemeIndex::graphemeIndex(const std::string &s) {
+		rebuild(s);
+	}
+
+	void graphemeIndex::rebuild(const std::string &s) {
+		m_boundaries.assign(s.size() + 1, 0);
+		m_boundaries[s.size()] = 1;
+		m_clusters = 0;
+		if (!s.empty()) {
+			m_boundaries[0] = 1;
+			m_clusters = 1;
+			m_segment(s, 0, s.size());
+		}
+	}
+	void graphemeIndex::replace(const std::string &s, size_t position, size_t erased, size_t inserted) {
+		//Splice the flags so they line up with the new string again
+		position = std::min(position, m_boundaries.size() - 1);
+		erased = std::min(erased, m_boundaries.size() - 1 - position);
+		for (size_t i = position; i < position + erased; i++) {
+			m_clusters -= m_boundaries[i];
+		}
+		m_boundaries.erase(m_boundaries.begin() + position, m_boundaries.begin() + position + erased);
+		m_boundaries.insert(m_boundaries.begin() + position, inserted, 0);
+		if (m_boundaries.size() != s.size() + 1) { //Caller's bookkeeping is off, start over
+			rebuild(s);
+			return;
+		}
+		if (s.empty()) {
+			m_clusters = 0;
+			m_boundaries[0] = 1;
+			return;
+		}
+
+		//Start from the cluster before the edit, since the edit may join onto it.
+		//Invalid bytes before the edit may now decode differently, so back up past the code point
+		//they are part of and one more cluster. Regional indicators pair up from the start of their run, so back up past them too.
+		size_t start = position > 0 ? floor(position - 1) : 0;
+		while (start > 0 && ((unsigned char)s[start] & 0xC0) == 0x80) {
+			start = previous(start);
+		}
+		start = previous(start);
+		size_t l = 1;
+		while (start > 0 && getGraphemeProperty(UTF8Decode(s, start, &l)) == RegionalIndicator) {
+			start = previous(start);
+		}
+		if (m_boundaries[start] == 0) { //Position 0 when the old string was empty
+			m_boundaries[start] = 1;
+			m_clusters++;
+		}
+		m_segment(s, start, position + inserted);
+	}
+
+	size_t graphemeIndex::next(size_t byte) const {
+		size_t end = m_boundaries.size() - 1;
+		if (byte >= end) {
+			return end;
+		}
+		for (byte++; m_boundaries[byte] == 0; byte++);
+		return byte;
+	}
+	size_t graphemeIndex::previous(size_t byte) const {
+		byte = std::min(byte, m_boundaries.size() - 1);
+		if (byte == 0) {
+			return 0;
+		}
+		for (byte--; byte > 0 && m_boundaries[byte] == 0; byte--);
+		return byte;
+	}
+	size_t graphemeIndex::move(size_t byte, int clusters) const {
+		byte = floor(byte);
+		for (; clusters > 0; clusters--) {
+			byte = next(byte);
+		}
+		for (; clusters < 0; clusters++) {
+			byte = previous(byte);
+		}
+		return byte;
+	}
+	size_t graphemeIndex::floor(size_t byte) const {
+		byte = std::min(byte, m_boundaries.size() - 1);
+		while (byte > 0 && m_boundaries[byte] == 0) {
+			byte--;
+		}
+		return byte;
+	}
+	bool graphemeIndex::isBoundary(size_t byte) const {
+		return byte < m_boundaries.size() && m_boundaries[byte] != 0;
+	}
+	size_t graphemeIndex::count() const {
+		return m_clusters;
+	}
+
+	void graphemeIndex::m_segment(const std::string &s, size_t from, size_t stopAfter) {
+		segmenterState state;
+		size_t i = from;
+		size_t l = 1;
+		graphemeProperty p = getGraphemeProperty(UTF8Decode(s, i, &l));
+		advanceState(state, p); //from is a boundary, which is already flagged
+		for (size_t b = i + 1; b < i + l; b++) { //Continuation bytes are never boundaries
+			m_clusters -= m_boundaries[b];
+			m_boundaries[b] = 0;
+		}
+		i += l;
+		while (i < s.size()) {
+			p = getGraphemeProperty(UTF8Decode(s, i, &l));
+			Uint8 boundary = isBreak(state, p) ? 1 : 0;
+			//Once past the edit and agreeing with the old flags, the rest of the old flags are still right
+			if (i >= stopAfter && boundary == 1 && m_boundaries[i] == 1 && p != RegionalIndicator) {
+				return;
+			}
+			if (boundary != m_boundaries[i]) {
+				if (boundary == 1) {
+					m_clusters++;
+				}
+				else {
+					m_clusters--;
+				}
+				m_boundaries[i] = boundary;
+			}
+			for (size_t b = i + 1; b < i + l; b++) {
+				m_clusters -= m_boundaries[b];
+				m_boundaries[b] = 0;
+			}
+			advanceState(state, p);
+			i += l;
+		}
+	}
+
+}
@@ -0,0 +1,130 @@
+#define SDL_MAIN_HANDLED //Plain main, without SDL2main
+#include "searchIndex.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace lui;
+
+static int failures = 0;
+
+static std::string lower(std::string s) {
+	for (char &c : s) {
+		if (c >= 'A' && c <= 'Z') {
+			c += 'a' - 'A';
+		}
+	}
+	return s;
+}
+//What every query must return, found by checking each label
+static std::vector<Uint32> scan(const std::vector<std::string> &labels, const std::string &query) {
+	std::string q = lower(query);
+	std::vector<Uint32> results;
+	for (Uint32 i = 0; i < labels.size(); i++) {
+		if (lower(labels[i]).find(q) != std::string::npos) {
+			results.push_back(i);
+		}
+	}
+	return results;
+}
+
+static void check(searchIndex &index, const std::vector<std::string> &labels, const std::vector<std::unique_ptr<element>> &elements, const std::string &query, const char *step) {
+	std::vector<Uint32> expected = scan(labels, query);
+	if (index.getResults() != expected) {
+		printf("FAIL %s to '%s': %zu results, expected %zu\n", step, query.c_str(), index.getResults().size(), expected.size());
+		failures++;
+		return;
+	}
+	if (index.getQuery() != lower(query)) {
+		printf("FAIL %s to '%s': query is '%s'\n", step, query.c_str(), index.getQuery().c_str());
+		failures++;
+	}
+	size_t shown = 0;
+	for (size_t i = 0; i < elements.size(); i++) {
+		shown += elements[i]->isVisible();
+	}
+	if (shown != expected.size() || (!expected.empty() && !elements[expected.back()]->isVisible())) {
+		printf("FAIL %s to '%s': %zu elements shown, expected %zu\n", step, query.c_str(), shown, expected.size());
+		failures++;
+	}
+}
+
+int main() {
+	std::mt19937 random(1);
+	//A skewed alphabet, so some runs are in nearly every label and others in a few, and the intersection has to probe
+	const std::string common = "aaaaaeeeebbc ";
+	const std::string rare = "xyzQ\xC3\xA9";
+	std::vector<std::string> labels;
+	std::vector<std::unique_ptr<element>> elements;
+	searchIndex index;
+	auto addLabel = [&]() {
+		std::string label;
+		for (int i = 3 + random() % 20; i > 0; i--) {
+			label += random() % 16 == 0 ? rare[random() % rare.size()] : common[random() % common.size()];
+		}
+		labels.push_back(label);
+		elements.emplace_back(new element());
+		if (index.addEntry(label, elements.back().get()) != labels.size() - 1) {
+			printf("FAIL entry ids are not in order\n");
+			failures++;
+		}
+	};
+	for (int i = 0; i < 5000; i++) {
+		addLabel();
+	}
+	check(index, labels, elements, "", "start");
+
+	std::string query;
+	for (int step = 0; step < 3000; step++) {
+		int op = random() % 8;
+		const char *name;
+		if (op < 3 || query.empty()) { //Refine
+			const std::string &from = random() % 3 == 0 ? rare : common;
+			char c = from[random() % from.size()];
+			if (c >= 'a' && c <= 'z' && random() % 4 == 0) { //Matching ignores ASCII case
+				c -= 'a' - 'A';
+			}
+			query += c;
+			name = "refine";
+		}
+		else if (op < 5) { //Backspace
+			query.pop_back();
+			name = "backspace";
+		}
+		else if (op < 6) { //Replace a character in the middle
+			query[random() % query.size()] = common[random() % common.size()];
+			name = "replace";
+		}
+		else if (op < 7) { //Select all and type something else
+			query = labels[random() % labels.size()].substr(0, 1 + random() % 5);
+			name = "retype";
+		}
+		else { //New entries are matched against the current query
+			addLabel();
+			check(index, labels, elements, query, "add");
+			continue;
+		}
+		if (query.size() > 8) {
+			query.resize(2);
+		}
+		index.setQuery(query);
+		check(index, labels, elements, query, name);
+		if (failures > 10) {
+			break;
+		}
+	}
+
+	index.clear();
+	if (index.size() != 0 || !index.getResults().empty() || !index.getQuery().empty()) {
+		printf("FAIL clear left entries behind\n");
+		failures++;
+	}
+	if (failures == 0) {
+		printf("searchIndexTest passed\n");
+	}
+	return failures == 0 ? 0 : 1;
+}
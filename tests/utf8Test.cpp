@@ -0,0 +1,138 @@
+#define SDL_MAIN_HANDLED //Plain main, without SDL2main
+#include "utf8.hpp"
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace lui;
+
+static int failures = 0;
+#define CHECK(condition) do { if (!(condition)) { printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #condition); failures++; } } while (0)
+
+//Every boundary the index reports, walking forwards
+static std::vector<size_t> forwardBoundaries(const graphemeIndex &index, size_t length) {
+	std::vector<size_t> boundaries;
+	for (size_t i = 0; i < length; i = index.next(i)) {
+		boundaries.push_back(i);
+	}
+	boundaries.push_back(length);
+	return boundaries;
+}
+//The same, walking backwards, put back in ascending order
+static std::vector<size_t> backwardBoundaries(const graphemeIndex &index, size_t length) {
+	std::vector<size_t> boundaries = { length };
+	for (size_t i = length; i > 0;) {
+		i = index.previous(i);
+		boundaries.insert(boundaries.begin(), i);
+	}
+	return boundaries;
+}
+
+static void checkBoundaries(const char *name, const std::string &s, const std::vector<size_t> &expected) {
+	graphemeIndex index(s);
+	std::vector<size_t> forward = forwardBoundaries(index, s.size());
+	if (forward != expected) {
+		printf("FAIL %s: boundaries", name);
+		for (size_t b : forward) {
+			printf(" %zu", b);
+		}
+		printf("\n");
+		failures++;
+	}
+	CHECK(backwardBoundaries(index, s.size()) == expected);
+	CHECK(index.count() == expected.size() - 1);
+	for (size_t i = 0; i <= s.size(); i++) {
+		bool boundary = false;
+		for (size_t b : expected) {
+			boundary = boundary || b == i;
+		}
+		CHECK(index.isBoundary(i) == boundary);
+	}
+}
+
+static void testClusters() {
+	const std::string man = "\xF0\x9F\x91\xA8", woman = "\xF0\x9F\x91\xA9", girl = "\xF0\x9F\x91\xA7";
+	const std::string zwj = "\xE2\x80\x8D", skinTone = "\xF0\x9F\x8F\xBB";
+	const std::string regionalU = "\xF0\x9F\x87\xBA", regionalS = "\xF0\x9F\x87\xB8", regionalF = "\xF0\x9F\x87\xAB";
+	const std::string acute = "\xCC\x81";
+	const std::string choseongG = "\xE1\x84\x80", jungseongA = "\xE1\x85\xA1", jongseongG = "\xE1\x86\xA8";
+	const std::string syllableGa = "\xEA\xB0\x80", syllableGak = "\xEA\xB0\x81"; //LV and LVT
+
+	checkBoundaries("empty", "", { 0 });
+	checkBoundaries("ascii", "abc", { 0, 1, 2, 3 });
+	checkBoundaries("combining", "e" + acute + "x", { 0, 3, 4 });
+	checkBoundaries("crlf", "a\r\nb", { 0, 1, 3, 4 });
+	checkBoundaries("cr cr", "\r\r\n", { 0, 1, 3 });
+	checkBoundaries("zwj family", man + zwj + woman + zwj + girl, { 0, 18 });
+	checkBoundaries("zwj with modifier", man + skinTone + zwj + woman + "a", { 0, 15, 16 });
+	checkBoundaries("flag pairs", regionalU + regionalS + regionalF + regionalU, { 0, 8, 16 });
+	checkBoundaries("odd flags", regionalU + regionalS + regionalF, { 0, 8, 12 });
+	checkBoundaries("hangul L V T", choseongG + jungseongA + jongseongG, { 0, 9 });
+	checkBoundaries("hangul LV T", syllableGa + jongseongG + "a", { 0, 6, 7 });
+	checkBoundaries("hangul LVT V", syllableGak + jungseongA, { 0, 3, 6 });
+	checkBoundaries("hangul LVT LV", syllableGak + syllableGa, { 0, 3, 6 });
+	checkBoundaries("invalid bytes", "a\xFF\xC3", { 0, 1, 2, 3 });
+
+	graphemeIndex index("a" + man + zwj + woman + "b");
+	CHECK(index.move(0, 2) == 12);
+	CHECK(index.move(12, -1) == 1);
+	CHECK(index.move(0, 10) == 13);
+	CHECK(index.floor(5) == 1);
+}
+
+//Random edits kept up to date with replace() must match indexing the result from scratch
+static void testReplace() {
+	const char *pieces[] = { "a", "\xCC\x81", "\xE2\x80\x8D", "\xF0\x9F\x91\xA8", "\xF0\x9F\x87\xBA", "\r", "\n", "\xEA\xB0\x80", "\xE1\x84\x80", "\xE1\x85\xA1", "\xE1\x86\xA8", "\xF0\x9F\x8F\xBB", "\xFF", "\xE0\xA4\xBF" };
+	const size_t pieceCount = sizeof(pieces) / sizeof(pieces[0]);
+	std::mt19937 random(1);
+	std::string s;
+	graphemeIndex index;
+	for (int step = 0; step < 20000; step++) {
+		size_t position = random() % (s.size() + 1);
+		if (random() % 3 == 0 && !s.empty()) {
+			size_t length = random() % (s.size() - position + 1);
+			s.erase(position, length);
+			index.replace(s, position, length, 0);
+		}
+		else {
+			std::string inserted;
+			for (int i = random() % 4; i >= 0; i--) {
+				inserted += pieces[random() % pieceCount];
+			}
+			s.insert(position, inserted);
+			index.replace(s, position, 0, inserted.size());
+		}
+		if (s.size() > 60) {
+			s.erase(0, 30);
+			index.replace(s, 0, 30, 0);
+		}
+		graphemeIndex rebuilt(s);
+		if (forwardBoundaries(index, s.size()) != forwardBoundaries(rebuilt, s.size()) || index.count() != rebuilt.count()) {
+			printf("FAIL replace diverged from rebuild at step %d\n", step);
+			failures++;
+			return;
+		}
+	}
+}
+
+static void testCounting() {
+	std::string s(1000, 'a');
+	s += "\xC3\xA9";
+	s += std::string(37, 'b');
+	CHECK(UTF8Count(s.data(), s.size()) == 1000 + 1 + 37);
+	CHECK(UTF8ValidLength(s.data(), s.size()) == s.size());
+	s[500] = (char)0xC3;
+	CHECK(UTF8ValidLength(s.data(), s.size()) == 500);
+}
+
+int main() {
+	testClusters();
+	testReplace();
+	testCounting();
+	if (failures == 0) {
+		printf("utf8Test passed\n");
+	}
+	return failures == 0 ? 0 : 1;
+}